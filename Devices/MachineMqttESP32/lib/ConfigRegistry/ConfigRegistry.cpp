@@ -0,0 +1,223 @@
+#include "ConfigRegistry.h"
+
+#define CONFIG_MAGIC 0x31474643 // "CFG1"
+
+ConfigRegistry::ConfigRegistry(const ConfigParam *table, size_t count, void *blob, size_t blobSize, const char *nvsNamespace, const char *nvsKey)
+    : table(table), paramCount(count), blob((uint8_t *)blob), size(blobSize), nvsNamespace(nvsNamespace), nvsKey(nvsKey) {}
+
+uint32_t ConfigRegistry::crc32(const uint8_t *data, size_t length) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+void ConfigRegistry::applyDefaults(void *target) const {
+    memset(target, 0, size);
+    String error;
+    for (size_t i = 0; i < paramCount; i++) {
+        if (!parse(target, &table[i], table[i].defaultValue, error)) {
+            Serial.printf("(Config)=> Invalid default for %s: %s\n", table[i].name, error.c_str());
+        }
+    }
+}
+
+// โหลดการตั้งค่าทั้งหมดด้วยการอ่าน NVS ครั้งเดียว
+ConfigRegistry::LoadResult ConfigRegistry::load() {
+    Preferences prefs;
+    uint8_t *buffer = NULL;
+    size_t stored = 0;
+
+    if (prefs.begin(nvsNamespace, true)) {
+        stored = prefs.getBytesLength(nvsKey);
+        if (stored >= sizeof(Header)) {
+            buffer = (uint8_t *)malloc(stored);
+            if (buffer != NULL && prefs.getBytes(nvsKey, buffer, stored) != stored) {
+                free(buffer);
+                buffer = NULL;
+            }
+        }
+        prefs.end();
+    }
+
+    if (buffer != NULL) {
+        Header header;
+        memcpy(&header, buffer, sizeof(header));
+        const uint8_t *payload = buffer + sizeof(header);
+
+        bool valid = header.magic == CONFIG_MAGIC && header.size == stored - sizeof(header) && header.size <= size &&
+                     header.crc == crc32(payload, header.size);
+        if (valid) {
+            applyDefaults(blob);
+            memcpy(blob, payload, header.size);
+            free(buffer);
+
+            if (header.size == size) {
+                return LOAD_OK;
+            }
+
+            // blob เวอร์ชันเก่า (field น้อยกว่า) เติมค่าเริ่มต้นแล้วบันทึกใหม่
+            Serial.printf("(Config)=> Upgraded blob %u -> %u bytes\n", header.size, size);
+            save();
+            return LOAD_UPGRADED;
+        }
+
+        Serial.println("(Config)=> Stored blob is invalid (CRC/size mismatch)");
+        free(buffer);
+    }
+
+    migrate();
+    save();
+    return LOAD_MIGRATED;
+}
+
+// ย้ายค่าจาก key เดิมแบบแยกตัว (ถ้ามี) มาเป็น blob เดียว
+void ConfigRegistry::migrate() {
+    Serial.println("(Config)=> Migrating legacy settings");
+    applyDefaults(blob);
+
+    Preferences prefs;
+    if (!prefs.begin(nvsNamespace, true)) {
+        return;
+    }
+
+    String error;
+    for (size_t i = 0; i < paramCount; i++) {
+        const ConfigParam *p = &table[i];
+        if (p->nvsKey == NULL || !prefs.isKey(p->nvsKey)) {
+            continue;
+        }
+
+        String value;
+        if (p->type == CONFIG_INT) {
+            value = String(prefs.getInt(p->nvsKey, atoi(p->defaultValue)));
+        } else if (p->type == CONFIG_BOOL) {
+            value = prefs.getBool(p->nvsKey, false) ? "1" : "0";
+        } else {
+            value = prefs.getString(p->nvsKey, p->defaultValue);
+        }
+
+        if (!parse(blob, p, value, error)) {
+            Serial.printf("(Config)=> Skip legacy %s: %s\n", p->name, error.c_str());
+        }
+    }
+    prefs.end();
+}
+
+bool ConfigRegistry::save() {
+    size_t total = sizeof(Header) + size;
+    uint8_t *buffer = (uint8_t *)malloc(total);
+    if (buffer == NULL) {
+        return false;
+    }
+
+    Header header;
+    header.magic = CONFIG_MAGIC;
+    header.size = size;
+    header.crc = crc32(blob, size);
+    memcpy(buffer, &header, sizeof(header));
+    memcpy(buffer + sizeof(header), blob, size);
+
+    Preferences prefs;
+    bool success = false;
+    if (prefs.begin(nvsNamespace, false)) {
+        success = prefs.putBytes(nvsKey, buffer, total) == total;
+        prefs.end();
+    }
+    free(buffer);
+
+    if (!success) {
+        Serial.println("(Config)=> Save failed");
+    }
+    return success;
+}
+
+const ConfigParam *ConfigRegistry::find(const String &nameOrAlias) const {
+    for (size_t i = 0; i < paramCount; i++) {
+        if (nameOrAlias == table[i].name || nameOrAlias == table[i].alias) {
+            return &table[i];
+        }
+    }
+    return NULL;
+}
+
+// แปลงและตรวจสอบค่า แล้วเขียนลง target (ไม่แตะ target ถ้าค่าไม่ถูกต้อง)
+bool ConfigRegistry::parse(void *target, const ConfigParam *param, const String &value, String &error) const {
+    uint8_t *field = (uint8_t *)target + param->offset;
+
+    switch (param->type) {
+    case CONFIG_INT: {
+        const char *str = value.c_str();
+        char *end = NULL;
+        long number = strtol(str, &end, 10);
+        if (value.length() == 0 || *end != '\0') {
+            error = "not a number";
+            return false;
+        }
+        if (number < param->min || number > param->max) {
+            error = "out of range " + String(param->min) + ".." + String(param->max);
+            return false;
+        }
+        int32_t v = number;
+        memcpy(field, &v, sizeof(v));
+        return true;
+    }
+    case CONFIG_BOOL: {
+        String v = value;
+        v.toLowerCase();
+        if (v == "1" || v == "true" || v == "on") {
+            *field = 1;
+        } else if (v == "0" || v == "false" || v == "off") {
+            *field = 0;
+        } else {
+            error = "expected 0/1";
+            return false;
+        }
+        return true;
+    }
+    case CONFIG_STRING:
+        if ((int32_t)value.length() < param->min || (int32_t)value.length() > param->max || value.length() >= param->size) {
+            error = "length must be " + String(param->min) + ".." + String(param->max);
+            return false;
+        }
+        memset(field, 0, param->size);
+        memcpy(field, value.c_str(), value.length());
+        return true;
+    }
+
+    error = "unknown type";
+    return false;
+}
+
+String ConfigRegistry::get(const void *source, const ConfigParam *param) const {
+    const uint8_t *field = (const uint8_t *)source + param->offset;
+
+    switch (param->type) {
+    case CONFIG_INT: {
+        int32_t v;
+        memcpy(&v, field, sizeof(v));
+        return String(v);
+    }
+    case CONFIG_BOOL:
+        return *field ? "1" : "0";
+    case CONFIG_STRING:
+        return String((const char *)field);
+    }
+    return "";
+}
+
+bool ConfigRegistry::changed(const void *a, const void *b, const ConfigParam *param) const {
+    return memcmp((const uint8_t *)a + param->offset, (const uint8_t *)b + param->offset, param->size) != 0;
+}
+
+void ConfigRegistry::print(Print &out) const {
+    for (size_t i = 0; i < paramCount; i++) {
+        const ConfigParam *p = &table[i];
+        String value = p->secret ? "******" : get(blob, p);
+        out.printf("    - %s (%s) = %s\n", p->name, p->alias, value.c_str());
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef CONFIG_REGISTRY_H
+#define CONFIG_REGISTRY_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+enum ConfigType { CONFIG_INT, CONFIG_STRING, CONFIG_BOOL };
+
+// ฟังก์ชันที่ถูกเรียกหลังค่าถูกเปลี่ยน (previous = ค่าการตั้งค่าก่อนเปลี่ยน)
+typedef void (*ConfigApplyHook)(const void *previous);
+
+// รายละเอียดของพารามิเตอร์แต่ละตัว
+struct ConfigParam {
+    const char *name;      // ชื่อเต็ม เช่น "mqtt_port"
+    const char *alias;     // ชื่อย่อ เช่น "mp"
+    ConfigType type;
+    int32_t min;           // CONFIG_INT: ค่าต่ำสุด, CONFIG_STRING: ความยาวต่ำสุด
+    int32_t max;           // CONFIG_INT: ค่าสูงสุด, CONFIG_STRING: ความยาวสูงสุด
+    uint16_t offset;       // ตำแหน่งของ field ใน blob (offsetof)
+    uint16_t size;         // ขนาดของ field ใน blob (sizeof)
+    const char *nvsKey;    // key เดิมใน NVS (ใช้ย้ายค่าจากเวอร์ชันก่อน)
+    const char *defaultValue;
+    ConfigApplyHook apply; // NULL = ไม่ต้องทำอะไรเพิ่ม
+    bool secret;           // ไม่แสดงค่าจริงเมื่อพิมพ์/ส่งออก
+};
+
+// ตารางการตั้งค่าแบบ compile-time เก็บทั้งหมดเป็น blob เดียวใน NVS พร้อม CRC
+// ห้ามเปลี่ยนลำดับ field ใน blob ให้เพิ่ม field ใหม่ต่อท้ายเท่านั้น
+// (blob ที่สั้นกว่าจะถูกเติมด้วยค่าเริ่มต้นตอนโหลด)
+class ConfigRegistry {
+  public:
+    enum LoadResult { LOAD_OK, LOAD_UPGRADED, LOAD_MIGRATED };
+
+    ConfigRegistry(const ConfigParam *table, size_t count, void *blob, size_t blobSize, const char *nvsNamespace, const char *nvsKey);
+
+    LoadResult load();
+    bool save();
+    void applyDefaults(void *target) const;
+
+    const ConfigParam *find(const String &nameOrAlias) const;
+    bool parse(void *target, const ConfigParam *param, const String &value, String &error) const;
+    String get(const void *source, const ConfigParam *param) const;
+    bool changed(const void *a, const void *b, const ConfigParam *param) const;
+    void print(Print &out) const;
+
+    size_t count() const { return paramCount; }
+    const ConfigParam *at(size_t i) const { return &table[i]; }
+    size_t blobSize() const { return size; }
+
+    static uint32_t crc32(const uint8_t *data, size_t length);
+
+  private:
+    struct Header {
+        uint32_t magic;
+        uint32_t size;
+        uint32_t crc;
+    };
+
+    const ConfigParam *table;
+    size_t paramCount;
+    uint8_t *blob;
+    size_t size;
+    const char *nvsNamespace;
+    const char *nvsKey;
+
+    void migrate();
+};
+
+#endif // CONFIG_REGISTRY_H
@@ -0,0 +1,100 @@
+#include "CounterPyramid.h"
+
+CounterPyramid::CounterPyramid() { memset(levels, 0, sizeof(levels)); }
+
+bool CounterPyramid::begin(const uint16_t slots[LEVELS], const uint16_t factor[LEVELS], uint32_t baseResolution) {
+    uint32_t res = baseResolution;
+    for (uint8_t i = 0; i < LEVELS; i++) {
+        Level &lv = levels[i];
+        lv.slots = slots[i];
+        lv.factor = i == 0 ? 1 : factor[i];
+        res *= lv.factor;
+        lv.resolution = res;
+        lv.head = 0;
+        lv.pendingCount = 0;
+
+        lv.ring = (CounterBucket *)calloc(lv.slots, sizeof(CounterBucket));
+        if (lv.ring == NULL) {
+            Serial.printf("(Pyramid)=> Allocate level %d failed (%u slots)\n", i, lv.slots);
+            return false;
+        }
+    }
+    return true;
+}
+
+void CounterPyramid::merge(CounterBucket &into, const CounterBucket &from) {
+    uint32_t total = into.samples + from.samples;
+    if (into.samples == 0) {
+        into.t = from.t;
+    }
+    if (total > 0) {
+        into.cycle_time = (into.cycle_time * into.samples + from.cycle_time * from.samples) / total;
+        into.cpm = (into.cpm * into.samples + from.cpm * from.samples) / total;
+    }
+    into.good += from.good;
+    into.reject += from.reject;
+    into.run_s += from.run_s;
+    into.stop_s += from.stop_s;
+    into.samples = total;
+}
+
+void CounterPyramid::push(uint8_t level, const CounterBucket &bucket) {
+    Level &lv = levels[level];
+    lv.ring[lv.head % lv.slots] = bucket;
+    lv.head++;
+
+    // รวมขึ้นไประดับที่หยาบกว่า
+    if (level + 1 < LEVELS) {
+        Level &up = levels[level + 1];
+        merge(up.pending, bucket);
+        if (++up.pendingCount >= up.factor) {
+            CounterBucket full = up.pending;
+            memset(&up.pending, 0, sizeof(up.pending));
+            up.pendingCount = 0;
+            push(level + 1, full);
+        }
+    }
+}
+
+void CounterPyramid::add(const CounterBucket &sample) {
+    if (levels[0].ring == NULL) {
+        return;
+    }
+    push(0, sample);
+}
+
+uint32_t CounterPyramid::headSeq(uint8_t level) const { return level < LEVELS ? levels[level].head : 0; }
+
+uint32_t CounterPyramid::oldestSeq(uint8_t level) const {
+    if (level >= LEVELS) {
+        return 0;
+    }
+    const Level &lv = levels[level];
+    return lv.head > lv.slots ? lv.head - lv.slots : 0;
+}
+
+uint32_t CounterPyramid::resolution(uint8_t level) const { return level < LEVELS ? levels[level].resolution : 0; }
+
+// อ่าน bucket ตั้งแต่ fromSeq (ถ้าเก่ากว่าที่เก็บไว้จะเริ่มจากอันที่เก่าที่สุด)
+size_t CounterPyramid::read(uint8_t level, uint32_t fromSeq, CounterBucket *out, size_t count, uint32_t *nextSeq) const {
+    if (level >= LEVELS || levels[level].ring == NULL) {
+        if (nextSeq) {
+            *nextSeq = fromSeq;
+        }
+        return 0;
+    }
+
+    const Level &lv = levels[level];
+    uint32_t oldest = oldestSeq(level);
+    uint32_t seq = fromSeq < oldest ? oldest : fromSeq;
+    size_t n = 0;
+    while (seq < lv.head && n < count) {
+        out[n++] = lv.ring[seq % lv.slots];
+        seq++;
+    }
+
+    if (nextSeq) {
+        *nextSeq = seq;
+    }
+    return n;
+}
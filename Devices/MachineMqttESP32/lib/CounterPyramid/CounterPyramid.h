@@ -0,0 +1,50 @@
+#ifndef COUNTER_PYRAMID_H
+#define COUNTER_PYRAMID_H
+
+#include <Arduino.h>
+
+// ข้อมูลสรุปตัวนับในหนึ่งช่วงเวลา
+struct CounterBucket {
+    uint32_t t;          // uptime (วินาที) ตอนเริ่มช่วงเวลา
+    uint32_t good;       // จำนวนชิ้นงานดี
+    uint32_t reject;     // จำนวนชิ้นงานเสีย
+    uint16_t run_s;      // เวลาเครื่องทำงาน (วินาที)
+    uint16_t stop_s;     // เวลาเครื่องหยุด (วินาที)
+    float cycle_time;    // ค่าเฉลี่ย cycle time
+    float cpm;           // ค่าเฉลี่ย cpm
+    uint16_t samples;    // จำนวน sample ที่รวมอยู่ใน bucket
+};
+
+// เก็บตัวนับแบบหลายความละเอียด (เช่น 2 วินาที, 1 นาที, 15 นาที) ใน ring buffer
+// ระดับที่ 0 รับ sample โดยตรง ระดับถัดไปรวม bucket จากระดับก่อนหน้าทุกๆ factor bucket
+// ไม่มีการ lock: add() และ read() ต้องเรียกจาก task เดียวกัน
+class CounterPyramid {
+  public:
+    static const uint8_t LEVELS = 3;
+
+    CounterPyramid();
+    bool begin(const uint16_t slots[LEVELS], const uint16_t factor[LEVELS], uint32_t baseResolution);
+    void add(const CounterBucket &sample);
+    size_t read(uint8_t level, uint32_t fromSeq, CounterBucket *out, size_t count, uint32_t *nextSeq) const;
+    uint32_t oldestSeq(uint8_t level) const;
+    uint32_t headSeq(uint8_t level) const;
+    uint32_t resolution(uint8_t level) const;
+
+  private:
+    struct Level {
+        CounterBucket *ring;
+        uint16_t slots;
+        uint16_t factor;        // จำนวน bucket ของระดับก่อนหน้าต่อ 1 bucket
+        uint32_t resolution;    // ความยาวช่วงเวลาของ bucket (วินาที)
+        uint32_t head;          // ลำดับ (sequence) ของ bucket ถัดไปที่จะถูกเขียน
+        CounterBucket pending;  // bucket ที่กำลังรวมอยู่
+        uint16_t pendingCount;
+    };
+
+    Level levels[LEVELS];
+
+    void push(uint8_t level, const CounterBucket &bucket);
+    static void merge(CounterBucket &into, const CounterBucket &from);
+};
+
+#endif // COUNTER_PYRAMID_H
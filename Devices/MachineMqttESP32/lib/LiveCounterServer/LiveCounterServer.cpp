@@ -0,0 +1,140 @@
+#include "LiveCounterServer.h"
+#include <ArduinoJson.h>
+
+// หน้าเว็บอย่างง่ายสำหรับแสดงตัวนับแบบ real-time
+static const char LIVE_PAGE[] PROGMEM = R"rawliteral(<!DOCTYPE html>
+<html><head><meta charset="utf-8"><meta name="viewport" content="width=device-width,initial-scale=1"><title>Live counter</title>
+<style>body{font-family:sans-serif;text-align:center}b{font-size:3em;display:block}</style></head>
+<body><h2 id="id">-</h2><p>Status<b id="status">-</b></p><p>OK<b id="good_path_count">0</b></p>
+<p>NG<b id="reject_count">0</b></p><p>Cycle time (s)<b id="cycle_time">0</b></p><p>CPM<b id="cpm">0</b></p>
+<script>
+function connect(){var ws=new WebSocket('ws://'+location.host+'/ws');
+ws.onmessage=function(e){var d=JSON.parse(e.data);if(d.machine_id)document.getElementById('id').textContent=d.machine_id;
+for(var k in d){var el=document.getElementById(k);if(el)el.textContent=d[k];}};
+ws.onclose=function(){setTimeout(connect,2000);};}
+connect();
+</script></body></html>)rawliteral";
+
+LiveCounterServer::LiveCounterServer(uint16_t port, uint8_t maxClients, uint16_t pushInterval)
+    : server(port), ws("/ws"), maxClients(maxClients), pushInterval(pushInterval), lastPushTime(0), lastCleanupTime(0), seq(0) {
+    memset(&current, 0, sizeof(current));
+    lock = xSemaphoreCreateMutex();
+}
+
+void LiveCounterServer::begin(const String &machineId) {
+    setMachineId(machineId);
+
+    ws.onEvent([this](AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
+        this->onEvent(server, client, type, arg, data, len);
+    });
+    server.addHandler(&ws);
+
+    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) { request->send_P(200, "text/html", LIVE_PAGE); });
+    server.on("/live", HTTP_GET, [this](AsyncWebServerRequest *request) { request->send(200, "application/json", this->fullJson()); });
+    server.onNotFound([](AsyncWebServerRequest *request) { request->send(404, "text/plain", "Not found"); });
+
+    server.begin();
+    Serial.println("Live counter server started");
+}
+
+void LiveCounterServer::setMachineId(const String &machineId) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    this->machineId = machineId;
+    xSemaphoreGive(lock);
+}
+
+size_t LiveCounterServer::clientCount() { return ws.count(); }
+
+String LiveCounterServer::fullJson() {
+    JsonDocument doc;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    LiveCounterSnapshot s = current;
+    doc["machine_id"] = machineId;
+    doc["seq"] = seq;
+    xSemaphoreGive(lock);
+
+    doc["status"] = s.running ? "RUNNING" : "STOP";
+    doc["cycle_time"] = serialized(String(s.cycle_time, 2));
+    doc["cpm"] = serialized(String(s.cpm, 2));
+    doc["good_path_count"] = s.good;
+    doc["reject_count"] = s.reject;
+
+    String payload;
+    serializeJson(doc, payload);
+    return payload;
+}
+
+void LiveCounterServer::onEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
+    switch (type) {
+    case WS_EVT_CONNECT:
+        // จำกัดจำนวน client เพื่อไม่ให้ใช้ RAM มากเกินไป
+        if (server->count() > maxClients) {
+            Serial.printf("(Live)=> Client #%u rejected, limit %d\n", client->id(), maxClients);
+            client->text("{\"error\":\"too many clients\"}");
+            client->close();
+            return;
+        }
+        Serial.printf("(Live)=> Client #%u connected from %s\n", client->id(), client->remoteIP().toString().c_str());
+        client->text(fullJson());
+        break;
+    case WS_EVT_DISCONNECT:
+        Serial.printf("(Live)=> Client #%u disconnected\n", client->id());
+        break;
+    default:
+        break;
+    }
+}
+
+// เรียกจาก loop() เพื่อส่งเฉพาะค่าที่เปลี่ยนไปยังทุก client
+void LiveCounterServer::update(const LiveCounterSnapshot &snapshot) {
+    unsigned long now = millis();
+    if (now - lastCleanupTime >= 1000) {
+        ws.cleanupClients(maxClients);
+        lastCleanupTime = now;
+    }
+
+    if (now - lastPushTime < pushInterval) {
+        return;
+    }
+
+    JsonDocument doc;
+    if (snapshot.running != current.running) {
+        doc["status"] = snapshot.running ? "RUNNING" : "STOP";
+    }
+    if (snapshot.cycle_time != current.cycle_time) {
+        doc["cycle_time"] = serialized(String(snapshot.cycle_time, 2));
+    }
+    if (snapshot.cpm != current.cpm) {
+        doc["cpm"] = serialized(String(snapshot.cpm, 2));
+    }
+    if (snapshot.good != current.good) {
+        doc["good_path_count"] = snapshot.good;
+    }
+    if (snapshot.reject != current.reject) {
+        doc["reject_count"] = snapshot.reject;
+    }
+
+    if (doc.size() == 0) {
+        return;
+    }
+
+    // client ยังส่งข้อมูลเก่าไม่หมด ข้ามรอบนี้ไปก่อน (delta จะถูกส่งรวมในรอบถัดไป)
+    if (ws.count() > 0 && !ws.availableForWriteAll()) {
+        return;
+    }
+
+    lastPushTime = now;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    current = snapshot;
+    seq++;
+    xSemaphoreGive(lock);
+
+    if (ws.count() == 0) {
+        return;
+    }
+
+    doc["seq"] = seq;
+    String payload;
+    serializeJson(doc, payload);
+    ws.textAll(payload);
+}
@@ -0,0 +1,47 @@
+#ifndef LIVE_COUNTER_SERVER_H
+#define LIVE_COUNTER_SERVER_H
+
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
+
+// สถานะตัวนับ ณ ขณะหนึ่ง
+struct LiveCounterSnapshot {
+    bool running;
+    float cycle_time;
+    float cpm;
+    unsigned long good;
+    unsigned long reject;
+};
+
+// HTTP + WebSocket server สำหรับแท็บเล็ตข้างไลน์
+// - GET /live คืนค่าสถานะปัจจุบัน (JSON)
+// - ws://<ip>/ws ส่งเฉพาะค่าที่เปลี่ยน (delta) ทันทีที่มีการเปลี่ยนแปลง
+// server ทำงานบน AsyncTCP task จึงไม่บล็อก task นับชิ้นงานหรือ MQTT
+class LiveCounterServer {
+  public:
+    LiveCounterServer(uint16_t port, uint8_t maxClients, uint16_t pushInterval);
+    void begin(const String &machineId);
+    void setMachineId(const String &machineId);
+    void update(const LiveCounterSnapshot &snapshot);
+    size_t clientCount();
+
+  private:
+    AsyncWebServer server;
+    AsyncWebSocket ws;
+    uint8_t maxClients;
+    uint16_t pushInterval;
+    unsigned long lastPushTime;
+    unsigned long lastCleanupTime;
+    uint32_t seq;
+    String machineId;
+
+    // snapshot ล่าสุดที่ส่งแล้ว (อ่านจาก AsyncTCP task ตอน client เชื่อมต่อใหม่)
+    LiveCounterSnapshot current;
+    SemaphoreHandle_t lock;
+
+    String fullJson();
+    void onEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len);
+};
+
+#endif // LIVE_COUNTER_SERVER_H
@@ -0,0 +1,107 @@
+#include "RawCycleLog.h"
+
+RawCycleLog::RawCycleLog(uint16_t capacity) : active(0), pending(false), capacity(capacity), seq(0) {
+    memset(blocks, 0, sizeof(blocks));
+    mux = portMUX_INITIALIZER_UNLOCKED;
+}
+
+bool RawCycleLog::begin() {
+    for (uint8_t i = 0; i < 2; i++) {
+        blocks[i].records = (RawCycleRecord *)calloc(capacity, sizeof(RawCycleRecord));
+        if (blocks[i].records == NULL) {
+            Serial.printf("(RawCycle)=> Allocate buffer failed (%u records)\n", capacity);
+            return false;
+        }
+    }
+    return true;
+}
+
+void RawCycleLog::add(uint32_t t, uint8_t mask) {
+    portENTER_CRITICAL(&mux);
+    Block &block = blocks[active];
+    if (block.records != NULL && block.count < capacity) {
+        block.records[block.count].t = t;
+        block.records[block.count].mask = mask;
+        block.count++;
+    } else if (block.dropped < 0xFFFF) {
+        block.dropped++;
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+// สลับ buffer เมื่อครบ maxCycles รอบ หรือรอบแรกของ block เก่ากว่า maxAgeMs
+// คืนค่าขนาด block ที่เข้ารหัสลง out (0 = ยังไม่มี block ให้ส่ง)
+size_t RawCycleLog::poll(uint32_t now, uint16_t maxCycles, uint32_t maxAgeMs, uint8_t *out, size_t outSize) {
+    if (!pending) {
+        portENTER_CRITICAL(&mux);
+        Block &block = blocks[active];
+        if (block.count > 0 && (block.count >= maxCycles || now - block.records[0].t >= maxAgeMs)) {
+            active ^= 1;
+            blocks[active].count = 0;
+            blocks[active].dropped = 0;
+            pending = true;
+        }
+        portEXIT_CRITICAL(&mux);
+    }
+
+    if (!pending) {
+        return 0;
+    }
+    // task นับชิ้นงานไม่แตะ block ที่ไม่ active จึงอ่านได้โดยไม่ต้อง lock
+    return encode(blocks[active ^ 1], out, outSize);
+}
+
+void RawCycleLog::release() {
+    if (pending) {
+        pending = false;
+        seq++;
+    }
+}
+
+// ทิ้งข้อมูลทั้งหมด (เช่น ตอนปิดโหมด)
+void RawCycleLog::reset() {
+    portENTER_CRITICAL(&mux);
+    blocks[0].count = blocks[1].count = 0;
+    blocks[0].dropped = blocks[1].dropped = 0;
+    pending = false;
+    portEXIT_CRITICAL(&mux);
+}
+
+static uint8_t *putU32(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+    return p + 4;
+}
+
+size_t RawCycleLog::encode(const Block &block, uint8_t *out, size_t outSize) const {
+    if (outSize < maxEncodedSize(block.count)) {
+        return 0;
+    }
+
+    uint32_t base = block.count > 0 ? block.records[0].t : 0;
+    uint8_t *p = out;
+    *p++ = 'R';
+    *p++ = 'C';
+    *p++ = VERSION;
+    *p++ = 0;
+    p = putU32(p, seq);
+    p = putU32(p, base);
+    *p++ = block.count;
+    *p++ = block.count >> 8;
+    *p++ = block.dropped;
+    *p++ = block.dropped >> 8;
+
+    uint32_t prev = base;
+    for (uint16_t i = 0; i < block.count; i++) {
+        uint32_t v = ((block.records[i].t - prev) << 4) | (block.records[i].mask & 0x0F);
+        prev = block.records[i].t;
+        while (v >= 0x80) {
+            *p++ = (v & 0x7F) | 0x80;
+            v >>= 7;
+        }
+        *p++ = v;
+    }
+    return p - out;
+}
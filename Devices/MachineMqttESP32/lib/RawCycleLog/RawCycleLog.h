@@ -0,0 +1,54 @@
+#ifndef RAW_CYCLE_LOG_H
+#define RAW_CYCLE_LOG_H
+
+#include <Arduino.h>
+
+// ข้อมูลของแต่ละรอบการทำงาน
+struct RawCycleRecord {
+    uint32_t t;   // millis() ตอนเกิด interrupt
+    uint8_t mask; // bit i = reject pin i ตรวจพบชิ้นงานเสีย
+};
+
+// เก็บข้อมูลทุกรอบการทำงานแบบ double buffer แล้วเข้ารหัสเป็น binary block
+// - task นับชิ้นงานเขียนลง buffer ที่ active ผ่าน add()
+// - loop เรียก poll() เพื่อสลับ buffer เมื่อครบจำนวนรอบหรือครบเวลา แล้วได้ block ที่เข้ารหัสแล้วกลับมา
+// - block จะถูกส่งซ้ำ (seq เดิม) จนกว่าจะเรียก release() หลังส่งสำเร็จ
+//
+// รูปแบบ block (little-endian):
+//   [0..1] "RC"  [2] version  [3] reserved
+//   [4..7] seq   [8..11] base_t (ms)  [12..13] count  [14..15] dropped
+//   แต่ละรอบ: varint(((t - t ก่อนหน้า) << 4) | mask) (รอบแรกเทียบกับ base_t)
+class RawCycleLog {
+  public:
+    static const uint8_t VERSION = 1;
+    static const size_t HEADER_SIZE = 16;
+
+    RawCycleLog(uint16_t capacity);
+    bool begin();
+    void add(uint32_t t, uint8_t mask);
+    size_t poll(uint32_t now, uint16_t maxCycles, uint32_t maxAgeMs, uint8_t *out, size_t outSize);
+    void release();
+    void reset();
+    uint32_t sequence() const { return seq; }
+
+    // ขนาด block สูงสุดสำหรับจำนวนรอบที่กำหนด (varint ยาวสุด 5 byte)
+    static size_t maxEncodedSize(uint16_t cycles) { return HEADER_SIZE + (size_t)cycles * 5; }
+
+  private:
+    struct Block {
+        RawCycleRecord *records;
+        uint16_t count;
+        uint16_t dropped; // จำนวนรอบที่ทิ้งไปเพราะ buffer เต็ม
+    };
+
+    Block blocks[2];
+    uint8_t active;
+    bool pending; // block ที่ไม่ active รอส่งอยู่
+    uint16_t capacity;
+    uint32_t seq;
+    portMUX_TYPE mux;
+
+    size_t encode(const Block &block, uint8_t *out, size_t outSize) const;
+};
+
+#endif // RAW_CYCLE_LOG_H
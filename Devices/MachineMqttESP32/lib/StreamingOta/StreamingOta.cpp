@@ -0,0 +1,274 @@
+#include "StreamingOta.h"
+#include <HTTPClient.h>
+#include <Update.h>
+#include <esp_ota_ops.h>
+
+#define OTA_STALL_TIMEOUT 60000 // ms ไม่มีข้อมูลเข้ามานานเกินนี้ถือว่าล้มเหลว
+
+StreamingOta::StreamingOta(size_t chunkSize, size_t bufferSize)
+    : chunkSize(chunkSize), bufferSize(bufferSize), stream(NULL), taskHandle(NULL), currentState(OTA_IDLE), receivedBytes(0), acceptedBytes(0),
+      totalBytes(0), abortRequested(false), useHttp(false) {
+    lastError[0] = '\0';
+}
+
+const char *StreamingOta::stateName() const {
+    switch (currentState) {
+    case OTA_IDLE:
+        return "idle";
+    case OTA_DOWNLOADING:
+        return "downloading";
+    case OTA_VERIFYING:
+        return "verifying";
+    case OTA_READY:
+        return "ready";
+    case OTA_FAILED:
+        return "failed";
+    }
+    return "unknown";
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+bool StreamingOta::beginHttp(const String &url, size_t size, const String &sha256) {
+    this->url = url;
+    useHttp = true;
+    return start(size, sha256);
+}
+
+bool StreamingOta::beginMqtt(size_t size, const String &sha256) {
+    useHttp = false;
+    if (stream == NULL) {
+        stream = xStreamBufferCreate(bufferSize, 1);
+        if (stream == NULL) {
+            fail("stream buffer allocation failed");
+            return false;
+        }
+    }
+    xStreamBufferReset(stream);
+    return start(size, sha256);
+}
+
+bool StreamingOta::start(size_t size, const String &sha256) {
+    if (taskHandle != NULL || currentState == OTA_DOWNLOADING || currentState == OTA_VERIFYING) {
+        return false;
+    }
+
+    receivedBytes = 0;
+    acceptedBytes = 0;
+    totalBytes = size;
+    abortRequested = false;
+    lastError[0] = '\0';
+
+    if (sha256.length() != 64) {
+        fail("sha256 must be 64 hex characters");
+        return false;
+    }
+    for (int i = 0; i < 32; i++) {
+        int hi = hexValue(sha256[i * 2]);
+        int lo = hexValue(sha256[i * 2 + 1]);
+        if (hi < 0 || lo < 0) {
+            fail("invalid sha256");
+            return false;
+        }
+        expectedHash[i] = (hi << 4) | lo;
+    }
+
+    if (size == 0 || !Update.begin(size, U_FLASH)) {
+        fail(size == 0 ? "size is required" : Update.errorString());
+        return false;
+    }
+
+    currentState = OTA_DOWNLOADING;
+    // priority 0 และอยู่ core 0 เพื่อไม่แย่งเวลา loop() และ task นับชิ้นงาน
+    if (xTaskCreatePinnedToCore(task, "OTA task", 8192, this, 0, &taskHandle, 0) != pdPASS) {
+        taskHandle = NULL;
+        fail("task creation failed");
+        return false;
+    }
+
+    Serial.printf("(OTA)=> Start %s download, %u bytes\n", useHttp ? "HTTP" : "MQTT", size);
+    return true;
+}
+
+// เรียกจาก loop() เมื่อได้รับ chunk ทาง MQTT (ต้องเรียงตาม offset)
+bool StreamingOta::pushChunk(uint32_t offset, const uint8_t *data, size_t len) {
+    if (useHttp || currentState != OTA_DOWNLOADING || stream == NULL) {
+        return false;
+    }
+    if (offset != acceptedBytes || acceptedBytes + len > totalBytes) {
+        return false;
+    }
+    if (xStreamBufferSpacesAvailable(stream) < len) {
+        return false;
+    }
+
+    xStreamBufferSend(stream, data, len, 0);
+    acceptedBytes += len;
+    return true;
+}
+
+void StreamingOta::abort() { abortRequested = true; }
+
+void StreamingOta::fail(const char *message) {
+    strncpy(lastError, message, sizeof(lastError) - 1);
+    lastError[sizeof(lastError) - 1] = '\0';
+    if (Update.isRunning()) {
+        Update.abort();
+    }
+    currentState = OTA_FAILED;
+    Serial.printf("(OTA)=> Failed: %s\n", lastError);
+}
+
+bool StreamingOta::writeChunk(mbedtls_sha256_context &sha, const uint8_t *data, size_t len) {
+    if (Update.write((uint8_t *)data, len) != len) {
+        fail(Update.errorString());
+        return false;
+    }
+    mbedtls_sha256_update(&sha, data, len);
+    receivedBytes += len;
+    return true;
+}
+
+bool StreamingOta::finish(mbedtls_sha256_context &sha) {
+    currentState = OTA_VERIFYING;
+
+    uint8_t hash[32];
+    mbedtls_sha256_finish(&sha, hash);
+    if (memcmp(hash, expectedHash, sizeof(hash)) != 0) {
+        fail("sha256 mismatch");
+        return false;
+    }
+
+    // Update.end() จะตั้ง boot partition ใหม่ให้ (ใช้หลังรีบูต)
+    if (!Update.end()) {
+        fail(Update.errorString());
+        return false;
+    }
+
+    currentState = OTA_READY;
+    Serial.println("(OTA)=> Image verified, ready to reboot");
+    return true;
+}
+
+void StreamingOta::runHttp(mbedtls_sha256_context &sha, uint8_t *buffer) {
+    HTTPClient http;
+    http.begin(url);
+    int httpCode = http.GET();
+    if (httpCode != HTTP_CODE_OK) {
+        http.end();
+        fail(("HTTP " + String(httpCode)).c_str());
+        return;
+    }
+
+    int contentLength = http.getSize();
+    if (contentLength > 0 && (size_t)contentLength != totalBytes) {
+        http.end();
+        fail("content length mismatch");
+        return;
+    }
+
+    WiFiClient *client = http.getStreamPtr();
+    unsigned long lastDataTime = millis();
+    while (receivedBytes < totalBytes && !abortRequested) {
+        size_t available = client->available();
+        if (available == 0) {
+            if (!http.connected() || millis() - lastDataTime > OTA_STALL_TIMEOUT) {
+                http.end();
+                fail("download stalled");
+                return;
+            }
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+
+        size_t toRead = min(min(available, chunkSize), totalBytes - receivedBytes);
+        size_t n = client->readBytes(buffer, toRead);
+        if (n > 0 && !writeChunk(sha, buffer, n)) {
+            http.end();
+            return;
+        }
+        lastDataTime = millis();
+        vTaskDelay(1);
+    }
+    http.end();
+}
+
+void StreamingOta::runMqtt(mbedtls_sha256_context &sha, uint8_t *buffer) {
+    unsigned long lastDataTime = millis();
+    while (receivedBytes < totalBytes && !abortRequested) {
+        size_t n = xStreamBufferReceive(stream, buffer, chunkSize, pdMS_TO_TICKS(1000));
+        if (n == 0) {
+            if (millis() - lastDataTime > OTA_STALL_TIMEOUT) {
+                fail("no chunk received");
+                return;
+            }
+            continue;
+        }
+        if (!writeChunk(sha, buffer, n)) {
+            return;
+        }
+        lastDataTime = millis();
+    }
+}
+
+void StreamingOta::task(void *parameter) {
+    StreamingOta *self = (StreamingOta *)parameter;
+    uint8_t *buffer = (uint8_t *)malloc(self->chunkSize);
+
+    if (buffer == NULL) {
+        self->fail("buffer allocation failed");
+    } else {
+        mbedtls_sha256_context sha;
+        mbedtls_sha256_init(&sha);
+        mbedtls_sha256_starts(&sha, 0);
+
+        if (self->useHttp) {
+            self->runHttp(sha, buffer);
+        } else {
+            self->runMqtt(sha, buffer);
+        }
+
+        if (self->abortRequested && self->currentState == OTA_DOWNLOADING) {
+            self->fail("aborted");
+        } else if (self->currentState == OTA_DOWNLOADING) {
+            self->finish(sha);
+        }
+
+        mbedtls_sha256_free(&sha);
+        free(buffer);
+    }
+
+    self->taskHandle = NULL;
+    vTaskDelete(NULL);
+}
+
+// image นี้เพิ่งถูกติดตั้งและ bootloader รอการยืนยัน
+bool StreamingOta::isPendingVerify() {
+    esp_ota_img_states_t otaState;
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    return esp_ota_get_state_partition(running, &otaState) == ESP_OK && otaState == ESP_OTA_IMG_PENDING_VERIFY;
+}
+
+void StreamingOta::markValid() { esp_ota_mark_app_valid_cancel_rollback(); }
+
+// กลับไปใช้ image ก่อนหน้าแล้วรีบูต
+void StreamingOta::rollback() {
+    if (isPendingVerify()) {
+        esp_ota_mark_app_invalid_rollback_and_reboot();
+    }
+
+    // bootloader ไม่ได้เปิด rollback ไว้ ให้สลับ boot partition เอง
+    const esp_partition_t *previous = esp_ota_get_next_update_partition(NULL);
+    if (previous != NULL && esp_ota_set_boot_partition(previous) == ESP_OK) {
+        esp_restart();
+    }
+    Serial.println("(OTA)=> Rollback failed");
+}
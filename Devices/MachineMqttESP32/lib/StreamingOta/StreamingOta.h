@@ -0,0 +1,60 @@
+#ifndef STREAMING_OTA_H
+#define STREAMING_OTA_H
+
+#include <Arduino.h>
+#include <freertos/stream_buffer.h>
+#include <mbedtls/sha256.h>
+
+enum OtaState { OTA_IDLE, OTA_DOWNLOADING, OTA_VERIFYING, OTA_READY, OTA_FAILED };
+
+// อัปเดต firmware ลง partition สำรอง (A/B) แบบ streaming ทีละ chunk
+// งานเขียน flash ทำใน task priority ต่ำ เพื่อให้ task นับชิ้นงานและ MQTT ทำงานต่อได้ระหว่างดาวน์โหลด
+// - HTTP: task ดาวน์โหลดจาก url เอง
+// - MQTT: loop() ส่ง chunk เข้ามาผ่าน pushChunk() (ต้องเรียงตาม offset)
+// จะสลับ boot partition ก็ต่อเมื่อ SHA-256 ของ image ตรงกับที่ระบุเท่านั้น
+class StreamingOta {
+  public:
+    StreamingOta(size_t chunkSize, size_t bufferSize);
+
+    bool beginHttp(const String &url, size_t size, const String &sha256);
+    bool beginMqtt(size_t size, const String &sha256);
+    bool pushChunk(uint32_t offset, const uint8_t *data, size_t len);
+    void abort();
+
+    OtaState state() const { return currentState; }
+    size_t received() const { return receivedBytes; }
+    size_t accepted() const { return acceptedBytes; }
+    size_t total() const { return totalBytes; }
+    const char *error() const { return lastError; }
+    const char *stateName() const;
+
+    // ตรวจสอบ image หลังรีบูต (rollback)
+    static bool isPendingVerify();
+    static void markValid();
+    static void rollback();
+
+  private:
+    size_t chunkSize;
+    size_t bufferSize;
+    StreamBufferHandle_t stream;
+    TaskHandle_t taskHandle;
+    volatile OtaState currentState;
+    volatile size_t receivedBytes; // เขียนลง flash แล้ว
+    volatile size_t acceptedBytes; // รับเข้า buffer แล้ว (MQTT)
+    size_t totalBytes;
+    volatile bool abortRequested;
+    bool useHttp;
+    String url;
+    uint8_t expectedHash[32];
+    char lastError[64];
+
+    bool start(size_t size, const String &sha256);
+    void fail(const char *message);
+    bool writeChunk(mbedtls_sha256_context &sha, const uint8_t *data, size_t len);
+    bool finish(mbedtls_sha256_context &sha);
+    void runHttp(mbedtls_sha256_context &sha, uint8_t *buffer);
+    void runMqtt(mbedtls_sha256_context &sha, uint8_t *buffer);
+    static void task(void *parameter);
+};
+
+#endif // STREAMING_OTA_H
@@ -0,0 +1,58 @@
+#include "ConfigRegistry.h"
+#include <stddef.h>
+
+// การตั้งค่าทั้งหมดของเครื่อง เก็บเป็น blob เดียวใน NVS (key: MEM_CONFIG)
+// เพิ่ม field ใหม่ต่อท้ายเท่านั้น
+struct MachineConfig {
+    char machine_id[32];
+    char wifi_ssid[33];
+    char wifi_password[65];
+    char mqtt_server[64];
+    int32_t mqtt_port;
+    char mqtt_topic_liveData[64];
+    char mqtt_topic_record[64];
+    char mqtt_topic_status[64];
+    int32_t debounce_delay;
+    int32_t timeout;
+    int32_t cycle_time_pin;
+    int32_t reject_number_pin;
+    int32_t ota_confirm_minutes;
+    uint8_t raw_mode;
+    int32_t raw_interval;
+    int32_t raw_cycles;
+};
+
+// apply hooks (อยู่ใน main.cpp)
+void applyMachineIdConfig(const void *previous);
+void applyWiFiConfig(const void *previous);
+void applyMqttServerConfig(const void *previous);
+void applyCycleTimePinConfig(const void *previous);
+void applyRejectPinConfig(const void *previous);
+void applyRawModeConfig(const void *previous);
+
+#define CONFIG_STR_(x) #x
+#define CONFIG_STR(x) CONFIG_STR_(x)
+#define CONFIG_FIELD(field) offsetof(MachineConfig, field), sizeof(((MachineConfig *)0)->field)
+
+// name, alias, type, min, max, field, NVS key เดิม, ค่าเริ่มต้น, apply hook, secret
+const ConfigParam CONFIG_TABLE[] = {
+    {"machine_id", "id", CONFIG_STRING, 0, 31, CONFIG_FIELD(machine_id), MEM_MACHINE_ID, "", applyMachineIdConfig, false},
+    {"wifi_ssid", "ws", CONFIG_STRING, 1, 32, CONFIG_FIELD(wifi_ssid), MEM_WIFI_SSID, DEFAULT_WIFI_SSID, applyWiFiConfig, false},
+    {"wifi_password", "wp", CONFIG_STRING, 0, 64, CONFIG_FIELD(wifi_password), MEM_WIFI_PASSWORD, DEFAULT_WIFI_PASSWORD, applyWiFiConfig, true},
+    {"mqtt_server", "ms", CONFIG_STRING, 1, 63, CONFIG_FIELD(mqtt_server), MEM_MQTT_MQTT_SERVER, DEFAULT_MQTT_SERVER, applyMqttServerConfig, false},
+    {"mqtt_port", "mp", CONFIG_INT, 1, 65535, CONFIG_FIELD(mqtt_port), MEM_MQTT_MQTT_PORT, CONFIG_STR(DEFAULT_MQTT_PORT), applyMqttServerConfig, false},
+    {"mqtt_topic_liveData", "mtl", CONFIG_STRING, 1, 63, CONFIG_FIELD(mqtt_topic_liveData), MEM_MQTT_MQTT_TOPIC_LIVEDATA, DEFAULT_MQTT_TOPIC_LIVEDATA, NULL,
+     false},
+    {"mqtt_topic_record", "mtr", CONFIG_STRING, 1, 63, CONFIG_FIELD(mqtt_topic_record), MEM_MQTT_MQTT_TOPIC_RECORD, DEFAULT_MQTT_TOPIC_RECORD, NULL, false},
+    {"mqtt_topic_status", "mts", CONFIG_STRING, 1, 63, CONFIG_FIELD(mqtt_topic_status), MEM_MQTT_TOPIC_STATUS, DEFAULT_MQTT_TOPIC_STATUS, NULL, false},
+    {"debounceDelay", "dd", CONFIG_INT, 0, 1000, CONFIG_FIELD(debounce_delay), MEM_DEBOUNDE_DELAY, CONFIG_STR(DEFAULT_DEBOUNDE_DELAY), NULL, false},
+    {"timeout", "to", CONFIG_INT, 100, 600000, CONFIG_FIELD(timeout), MEM_TIMEOUT, CONFIG_STR(DEFAULT_TIMEOUT), NULL, false},
+    {"cycle_time_pin", "ctp", CONFIG_INT, 0, 39, CONFIG_FIELD(cycle_time_pin), MEM_CYCLE_TIME_NUMBER_PIN, CONFIG_STR(DEFAULT_CYCLE_TIME_PIN), applyCycleTimePinConfig,
+     false},
+    {"reject_number_pin", "rnp", CONFIG_INT, 0, 4, CONFIG_FIELD(reject_number_pin), MEM_REJECT_NUMBER_PIN, CONFIG_STR(DEFAULT_REJECT_NUMBER_PIN),
+     applyRejectPinConfig, false},
+    {"ota_confirm_minutes", "ocm", CONFIG_INT, 1, 60, CONFIG_FIELD(ota_confirm_minutes), NULL, CONFIG_STR(DEFAULT_OTA_CONFIRM_MINUTES), NULL, false},
+    {"raw_mode", "rm", CONFIG_BOOL, 0, 1, CONFIG_FIELD(raw_mode), NULL, "0", applyRawModeConfig, false},
+    {"raw_interval", "ri", CONFIG_INT, 1, 60, CONFIG_FIELD(raw_interval), NULL, CONFIG_STR(DEFAULT_RAW_INTERVAL), NULL, false},
+    {"raw_cycles", "rc", CONFIG_INT, 10, RAW_CYCLE_CAPACITY, CONFIG_FIELD(raw_cycles), NULL, CONFIG_STR(DEFAULT_RAW_CYCLES), NULL, false},
+};
@@ -1,26 +1,22 @@
 #include "./setting.h"
+#include "./config.h"
+#include "CounterPyramid.h"
+#include "LiveCounterServer.h"
+#include "RawCycleLog.h"
+#include "StreamingOta.h"
 #include <Arduino.h>
 #include <ArduinoJson.h>
-#include <Preferences.h>
 #include <PubSubClient.h>
 #include <WiFi.h>
 
-// MQTT broker details
-String machine_id = "";
-String wifi_ssid = "";
-String wifi_password = "";
-String mqtt_server = "";
-int mqtt_port = 1884;
-String mqtt_topic_liveData = "";
-String mqtt_topic_record = "";
-String mqtt_topic_status = "";
+// การตั้งค่าทั้งหมด (MQTT broker, Wi-Fi, pins, timing)
+MachineConfig config;
+ConfigRegistry configRegistry(CONFIG_TABLE, sizeof(CONFIG_TABLE) / sizeof(CONFIG_TABLE[0]), &config, sizeof(config), NAME_SPACE, MEM_CONFIG);
 
 // MQTT client
 WiFiClient espClient;
 PubSubClient client(espClient);
 
-Preferences preferences; // สร้างออบเจกต์
-bool IS_FIRST_RUN = true;
 bool devMode = false;
 
 // Variables for data aggregation
@@ -42,17 +38,52 @@ unsigned long total_start_time = 0;
 unsigned long total_stop_time = 0;
 int data_points = 0;
 
+// ตัวนับสะสมตั้งแต่เปิดเครื่อง (ไม่ถูกรีเซ็ตเมื่อส่งข้อมูล)
+volatile unsigned long lifetime_good_count = 0;
+volatile unsigned long lifetime_reject_count = 0;
+
+// ข้อมูลย้อนหลังแบบหลายความละเอียด (2 วินาที, 1 นาที, 15 นาที)
+CounterPyramid pyramid;
+
+// ส่งตัวนับให้ client ในเครือข่ายโดยตรง ไม่ต้องผ่าน server กลาง
+LiveCounterServer liveServer(LIVE_SERVER_PORT, LIVE_SERVER_MAX_CLIENTS, LIVE_SERVER_PUSH_INTERVAL);
+
+// ข้อมูลทุกรอบการทำงาน (raw cycle mode)
+RawCycleLog rawLog(RAW_CYCLE_CAPACITY);
+uint8_t rawBlock[RawCycleLog::HEADER_SIZE + RAW_CYCLE_CAPACITY * 5];
+
+// OTA
+StreamingOta ota(OTA_CHUNK_SIZE, OTA_BUFFER_SIZE);
+char otaTargetVersion[16] = "";
+unsigned long countingStartTime = 0; // millis() ตอน task นับชิ้นงานเริ่มทำงาน (ใช้คำนวณช่วงที่นับไม่ได้ระหว่างรีบูต)
+
+// ข้อมูลที่บันทึกไว้ก่อนรีบูตเข้า firmware ใหม่
+enum OtaBootState : uint32_t { OTA_BOOT_INSTALLED = 1, OTA_BOOT_ROLLED_BACK = 2 };
+struct OtaBootInfo {
+    uint32_t state; // OtaBootState
+    char previous_version[16];
+    char version[16];
+    uint32_t lifetime_good;
+    uint32_t lifetime_reject;
+    uint32_t unpublished_good;
+    uint32_t unpublished_reject;
+};
+OtaBootInfo otaBootInfo;
+bool otaBootReport = false;  // มีผลการอัปเดตที่ต้องรายงานหลัง publish สำเร็จครั้งแรก
+bool otaBootPending = false;    // firmware นี้ยังไม่ได้ยืนยัน (rollback ถ้าไม่ publish สำเร็จภายในเวลาที่กำหนด)
+bool otaBootRolledBack = false; // บูตกลับมาที่ firmware เดิมหลังติดตั้ง (rollback เองหรือ bootloader ย้อนกลับ)
+unsigned long otaConfirmStart = 0; // millis() ตอนต่อ broker ได้ครั้งแรกหลังบูต (0 = ยังต่อไม่ได้ ใช้ OTA_BROKER_TIMEOUT_MINUTES)
+
+// ให้ Arduino core ยังไม่ยืนยัน image ตอนบูต เราจะยืนยันเองหลัง publish สำเร็จ
+extern "C" bool verifyRollbackLater() { return true; }
+
 // Debounce timing variables
 volatile unsigned long lastCycleTimeInterrupt = 0;
 
-// Debounce delay in milliseconds
-int debounceDelay = 50;
-int timeout = 3000;
-
 // Interrupt service routines with debounce
 void IRAM_ATTR handleCycleTime() {
     unsigned long currentTime = millis();
-    if (currentTime - lastCycleTimeInterrupt > debounceDelay && !cycleTimeTiggered) {
+    if (currentTime - lastCycleTimeInterrupt > config.debounce_delay && !cycleTimeTiggered) {
         lastCycleTimeInterrupt = currentTime;
 
         cycleTimeTiggered = true;
@@ -64,24 +95,48 @@ void setupWiFi() {
     static unsigned long lastAttemptTime = 0;
     static bool isConnecting = false;
 
+    static bool liveServerStarted = false;
+
     if (WiFi.status() == WL_CONNECTED) {
         if (!isConnecting) {
             Serial.println("\nWiFi connected");
             Serial.print("IP Address: ");
             Serial.println(WiFi.localIP());
             isConnecting = true;
+
+            if (!liveServerStarted) {
+                liveServer.begin(config.machine_id);
+                liveServerStarted = true;
+            }
         }
         return;
     }
 
     if (millis() - lastAttemptTime > 5000 || lastAttemptTime == 0) {
         Serial.println("Connecting to WiFi...");
-        WiFi.begin(wifi_ssid.c_str(), wifi_password.c_str());
+        WiFi.begin(config.wifi_ssid, config.wifi_password);
         lastAttemptTime = millis();
         isConnecting = false;
     }
 }
 
+// Subscribe topic ที่ผูกกับ machine_id (เรียกใหม่เมื่อ machine_id เปลี่ยน)
+String subscribedMachineId = "";
+void subscribeTopics() {
+    if (subscribedMachineId.length() > 0) {
+        client.unsubscribe((String(DEFAULT_MQTT_TOPIC_BACKFILL_REQUEST) + subscribedMachineId).c_str());
+        client.unsubscribe((String(DEFAULT_MQTT_TOPIC_CONFIG) + subscribedMachineId).c_str());
+        client.unsubscribe((String(DEFAULT_MQTT_TOPIC_OTA) + subscribedMachineId).c_str());
+        client.unsubscribe((String(DEFAULT_MQTT_TOPIC_OTA) + subscribedMachineId + "/chunk").c_str());
+    }
+
+    subscribedMachineId = config.machine_id;
+    client.subscribe((String(DEFAULT_MQTT_TOPIC_BACKFILL_REQUEST) + subscribedMachineId).c_str());
+    client.subscribe((String(DEFAULT_MQTT_TOPIC_CONFIG) + subscribedMachineId).c_str());
+    client.subscribe((String(DEFAULT_MQTT_TOPIC_OTA) + subscribedMachineId).c_str());
+    client.subscribe((String(DEFAULT_MQTT_TOPIC_OTA) + subscribedMachineId + "/chunk").c_str());
+}
+
 // Function to connect to MQTT broker
 void connectToMQTT() {
     static unsigned long lastAttemptTime = 0; // เก็บเวลาครั้งสุดท้ายที่พยายามเชื่อมต่อ
@@ -95,6 +150,10 @@ void connectToMQTT() {
                 Serial.println("Connecting to MQTT...");
                 if (client.connect("ESP32Client")) {
                     Serial.println("Connected to MQTT broker");
+                    subscribeTopics();
+                    if (otaConfirmStart == 0) {
+                        otaConfirmStart = max(millis(), 1UL);
+                    }
                 } else {
                     Serial.print("Failed to connect, rc=");
                     Serial.print(client.state());
@@ -106,6 +165,290 @@ void connectToMQTT() {
     }
 }
 
+// เก็บ sample ทุก 2 วินาทีลง pyramid
+void samplePyramid() {
+    static unsigned long lastGood = 0;
+    static unsigned long lastReject = 0;
+
+    unsigned long good = lifetime_good_count;
+    unsigned long reject = lifetime_reject_count;
+
+    CounterBucket sample;
+    sample.t = millis() / 1000 - PYRAMID_BASE_RESOLUTION;
+    sample.good = good - lastGood;
+    sample.reject = reject - lastReject;
+    sample.run_s = isRunning ? PYRAMID_BASE_RESOLUTION : 0;
+    sample.stop_s = isRunning ? 0 : PYRAMID_BASE_RESOLUTION;
+    sample.cycle_time = cycle_time;
+    sample.cpm = cpm;
+    sample.samples = 1;
+    pyramid.add(sample);
+
+    lastGood = good;
+    lastReject = reject;
+}
+
+// ตอบกลับคำขอข้อมูลย้อนหลัง เช่น {"level":2,"from":0,"max":30,"req":"abc"}
+// server ควรดึงระดับหยาบ (level 2) ก่อน แล้วค่อยดึงระดับละเอียดโดยใช้ค่า next
+void handleBackfillRequest(const byte *payload, unsigned int length) {
+    JsonDocument req;
+    DeserializationError error = deserializeJson(req, payload, length);
+    if (error) {
+        Serial.printf("(Backfill)=> Invalid request: %s\n", error.c_str());
+        return;
+    }
+
+    uint8_t level = req["level"] | 0;
+    uint32_t from = req["from"] | 0;
+    size_t max_rows = req["max"] | BACKFILL_MAX_ROWS;
+    if (max_rows == 0 || max_rows > BACKFILL_MAX_ROWS) {
+        max_rows = BACKFILL_MAX_ROWS;
+    }
+
+    CounterBucket rows[BACKFILL_MAX_ROWS];
+    uint32_t next = from;
+    size_t n = pyramid.read(level, from, rows, max_rows, &next);
+
+    JsonDocument doc;
+    doc["machine_id"] = config.machine_id;
+    if (!req["req"].isNull()) {
+        doc["req"] = req["req"];
+    }
+    doc["level"] = level;
+    doc["resolution"] = pyramid.resolution(level);
+    doc["uptime"] = millis() / 1000; // server ใช้คำนวณเวลาจริง = เวลาที่ได้รับ - (uptime - t)
+    doc["oldest"] = pyramid.oldestSeq(level);
+    doc["head"] = pyramid.headSeq(level);
+    doc["next"] = next;
+
+    JsonArray data = doc["rows"].to<JsonArray>();
+    for (size_t i = 0; i < n; i++) {
+        JsonArray row = data.add<JsonArray>();
+        row.add(rows[i].t);
+        row.add(rows[i].good);
+        row.add(rows[i].reject);
+        row.add(rows[i].run_s);
+        row.add(rows[i].stop_s);
+        row.add(serialized(String(rows[i].cycle_time, 2)));
+        row.add(serialized(String(rows[i].cpm, 2)));
+    }
+
+    String payloadOut;
+    serializeJson(doc, payloadOut);
+
+    String responseTopic = String(DEFAULT_MQTT_TOPIC_BACKFILL_RESPONSE) + config.machine_id;
+    if (client.publish(responseTopic.c_str(), payloadOut.c_str())) {
+        Serial.printf("✅ Backfill level %d: %u rows, next %u\n", level, n, next);
+    } else {
+        Serial.println("❌ Backfill publishing failed");
+    }
+}
+
+void handleConfigRequest(const byte *payload, unsigned int length);
+
+// ส่ง block ข้อมูลทุกรอบการทำงาน ถ้าส่งไม่สำเร็จจะส่ง block เดิมซ้ำในรอบถัดไป
+void publishRawCycles() {
+    size_t length = rawLog.poll(millis(), config.raw_cycles, config.raw_interval * 1000UL, rawBlock, sizeof(rawBlock));
+    if (length == 0) {
+        return;
+    }
+
+    String topic = String(DEFAULT_MQTT_TOPIC_RAW) + config.machine_id;
+    if (client.publish(topic.c_str(), rawBlock, length)) {
+        rawLog.release();
+    } else {
+        Serial.println("❌ Failed to publish raw cycle block");
+    }
+}
+
+// ===== OTA =====
+String otaTopic(const char *suffix) { return String(DEFAULT_MQTT_TOPIC_OTA) + config.machine_id + suffix; }
+
+void publishOtaStatus() {
+    JsonDocument doc;
+    doc["machine_id"] = config.machine_id;
+    doc["state"] = ota.stateName();
+    doc["version"] = FIRMWARE_VERSION;
+    doc["target_version"] = otaTargetVersion;
+    doc["received"] = ota.received();
+    doc["next"] = ota.accepted();
+    doc["total"] = ota.total();
+    if (ota.state() == OTA_FAILED) {
+        doc["error"] = ota.error();
+    }
+
+    String payload;
+    serializeJson(doc, payload);
+    client.publish(otaTopic("/status").c_str(), payload.c_str());
+}
+
+// เริ่มอัปเดต firmware: ดาวน์โหลดทาง HTTP หรือรอรับ chunk ทาง MQTT
+void handleOtaRequest(const byte *payload, unsigned int length) {
+    JsonDocument req;
+    DeserializationError error = deserializeJson(req, payload, length);
+    if (error) {
+        Serial.printf("(OTA)=> Invalid request: %s\n", error.c_str());
+        return;
+    }
+
+    if (req["abort"] | false) {
+        ota.abort();
+        publishOtaStatus();
+        return;
+    }
+
+    size_t size = req["size"] | 0;
+    String sha256 = req["sha256"] | "";
+    String transport = req["transport"] | "http";
+    strlcpy(otaTargetVersion, req["version"] | "", sizeof(otaTargetVersion));
+
+    bool started = transport == "mqtt" ? ota.beginMqtt(size, sha256) : ota.beginHttp(req["url"] | "", size, sha256);
+    if (!started) {
+        Serial.println("(OTA)=> Request rejected");
+    }
+    publishOtaStatus();
+}
+
+// chunk ทาง MQTT: [offset uint32 LE][data]
+void handleOtaChunk(const byte *payload, unsigned int length) {
+    if (length <= 4) {
+        return;
+    }
+    uint32_t offset = payload[0] | (payload[1] << 8) | (payload[2] << 16) | ((uint32_t)payload[3] << 24);
+    ota.pushChunk(offset, payload + 4, length - 4);
+
+    // แจ้ง next ให้ server ส่ง chunk ถัดไป (หรือส่งซ้ำถ้า chunk นี้ไม่ถูกรับ)
+    publishOtaStatus();
+}
+
+// บันทึกตัวนับที่ยังไม่ได้ส่ง เพื่อให้ firmware ถัดไปส่งต่อและรายงานช่วงที่นับไม่ได้
+void saveOtaBootInfo(OtaBootState state, const char *fromVersion, const char *toVersion) {
+    OtaBootInfo info;
+    memset(&info, 0, sizeof(info));
+    info.state = state;
+    strlcpy(info.previous_version, fromVersion, sizeof(info.previous_version));
+    strlcpy(info.version, toVersion, sizeof(info.version));
+    info.lifetime_good = lifetime_good_count;
+    info.lifetime_reject = lifetime_reject_count;
+    info.unpublished_good = good_path_count;
+    info.unpublished_reject = reject_count;
+
+    Preferences preferences;
+    preferences.begin(NAME_SPACE, false);
+    preferences.putBytes(MEM_OTA_BOOT, &info, sizeof(info));
+    preferences.end();
+}
+
+void loadOtaBootInfo() {
+    Preferences preferences;
+    preferences.begin(NAME_SPACE, true);
+    bool found = preferences.getBytesLength(MEM_OTA_BOOT) == sizeof(otaBootInfo) &&
+                 preferences.getBytes(MEM_OTA_BOOT, &otaBootInfo, sizeof(otaBootInfo)) == sizeof(otaBootInfo);
+    preferences.end();
+
+    otaBootPending = StreamingOta::isPendingVerify();
+    if (!found) {
+        otaBootReport = otaBootPending;
+        memset(&otaBootInfo, 0, sizeof(otaBootInfo));
+        return;
+    }
+
+    // ส่งตัวนับที่ค้างจาก firmware ก่อนหน้าต่อ
+    good_path_count += otaBootInfo.unpublished_good;
+    reject_count += otaBootInfo.unpublished_reject;
+
+    // bootloader ไม่ได้เปิด rollback ไว้ (ไม่มี PENDING_VERIFY): ถือว่ารอยืนยันเฉพาะ image ที่เพิ่งติดตั้งและบูตเข้าได้จริง
+    // rolled_back เฉพาะที่ rollback เอง หรือติดตั้งแล้วแต่บูตกลับมาที่ version เดิม (bootloader ย้อนกลับ)
+    // ข้อมูลค้างที่ไม่ตรงทั้งสอง version (เช่น flash ผ่าน USB ทีหลัง) ส่งแค่ตัวนับที่ค้าง ไม่รายงานว่า rollback
+    bool installed = otaBootInfo.state == OTA_BOOT_INSTALLED && strcmp(otaBootInfo.version, FIRMWARE_VERSION) == 0;
+    bool previous = strcmp(otaBootInfo.previous_version, FIRMWARE_VERSION) == 0;
+    otaBootRolledBack = !installed && previous && (otaBootInfo.state == OTA_BOOT_INSTALLED || otaBootInfo.state == OTA_BOOT_ROLLED_BACK);
+    otaBootPending = otaBootPending || installed;
+    otaBootReport = true;
+    Serial.printf("(OTA)=> Booted %s (from %s), restored OK: %u, NG: %u\n", FIRMWARE_VERSION, otaBootInfo.previous_version,
+                  otaBootInfo.unpublished_good, otaBootInfo.unpublished_reject);
+}
+
+// เรียกหลัง publish สำเร็จครั้งแรก: ยืนยัน firmware และรายงานผลการอัปเดต
+void confirmOtaBoot() {
+    if (otaBootPending) {
+        StreamingOta::markValid();
+    }
+
+    JsonDocument doc;
+    doc["machine_id"] = config.machine_id;
+    doc["state"] = otaBootPending ? "confirmed" : otaBootRolledBack ? "rolled_back" : "restored";
+    doc["version"] = FIRMWARE_VERSION;
+    doc["previous_version"] = otaBootInfo.previous_version;
+    doc["target_version"] = otaBootInfo.version;
+    doc["gap_ms"] = countingStartTime; // ช่วงเวลาที่นับไม่ได้ (ตั้งแต่รีบูตจนเริ่มนับใหม่)
+    doc["good_before"] = otaBootInfo.lifetime_good;
+    doc["reject_before"] = otaBootInfo.lifetime_reject;
+    doc["restored_good"] = otaBootInfo.unpublished_good;
+    doc["restored_reject"] = otaBootInfo.unpublished_reject;
+
+    String payload;
+    serializeJson(doc, payload);
+    if (client.publish(otaTopic("/status").c_str(), payload.c_str())) {
+        Serial.println("✅ OTA boot report: " + payload);
+        Preferences preferences;
+        preferences.begin(NAME_SPACE, false);
+        preferences.remove(MEM_OTA_BOOT);
+        preferences.end();
+
+        otaBootPending = false;
+        otaBootRolledBack = false;
+        otaBootReport = false;
+    }
+}
+
+void updateOta() {
+    static OtaState lastState = OTA_IDLE;
+    static unsigned long lastStatusTime = 0;
+
+    OtaState state = ota.state();
+    if (client.connected() && (state != lastState || (state == OTA_DOWNLOADING && millis() - lastStatusTime > 2000))) {
+        publishOtaStatus();
+        lastStatusTime = millis();
+        lastState = state;
+    }
+
+    // image ผ่านการตรวจสอบแล้ว รีบูตเข้า firmware ใหม่
+    if (state == OTA_READY) {
+        Serial.println("(OTA)=> Rebooting into new firmware...");
+        client.loop();
+        delay(100);
+        saveOtaBootInfo(OTA_BOOT_INSTALLED, FIRMWARE_VERSION, otaTargetVersion);
+        ESP.restart();
+    }
+
+    // firmware ใหม่ต่อ broker ได้แล้วแต่ publish ไม่สำเร็จภายใน ota_confirm_minutes กลับไปใช้ firmware เดิม
+    // ต่อ broker ไม่ได้เลยให้เวลานานกว่า (OTA_BROKER_TIMEOUT_MINUTES นับจากบูต) เผื่อ broker ล่มชั่วคราว
+    // แต่ firmware ที่ทำ WiFi/MQTT เสียต้อง rollback
+    bool confirmExpired = otaConfirmStart != 0 && millis() - otaConfirmStart > (unsigned long)config.ota_confirm_minutes * 60000UL;
+    bool brokerExpired = otaConfirmStart == 0 && millis() > OTA_BROKER_TIMEOUT_MINUTES * 60000UL;
+    if (otaBootPending && (confirmExpired || brokerExpired)) {
+        Serial.println("(OTA)=> New firmware not confirmed, rolling back");
+        saveOtaBootInfo(OTA_BOOT_ROLLED_BACK, FIRMWARE_VERSION, otaBootInfo.previous_version);
+        StreamingOta::rollback();
+        otaBootPending = false;
+    }
+}
+
+// รับข้อความจาก MQTT broker
+void mqttCallback(char *topic, byte *payload, unsigned int length) {
+    String _topic = topic;
+    if (_topic == String(DEFAULT_MQTT_TOPIC_BACKFILL_REQUEST) + config.machine_id) {
+        handleBackfillRequest(payload, length);
+    } else if (_topic == String(DEFAULT_MQTT_TOPIC_CONFIG) + config.machine_id) {
+        handleConfigRequest(payload, length);
+    } else if (_topic == otaTopic("")) {
+        handleOtaRequest(payload, length);
+    } else if (_topic == otaTopic("/chunk")) {
+        handleOtaChunk(payload, length);
+    }
+}
+
 // Function to read data from hardware
 void readHardwareData() {
     // Update totals for 30-second aggregation
@@ -123,7 +466,7 @@ void readHardwareData() {
 
         // สร้าง payload สำหรับ live data
         JsonDocument doc;
-        doc["machine_id"] = machine_id;
+        doc["machine_id"] = config.machine_id;
         doc["status"] = status;
         doc["cycle_time"] = cycle_time;
         doc["cpm"] = cpm;
@@ -136,8 +479,11 @@ void readHardwareData() {
         serializeJson(doc, payload);
 
         // ส่งข้อมูลไปยัง MQTT broker
-        if (client.publish(mqtt_topic_liveData.c_str(), payload.c_str())) {
+        if (client.publish(config.mqtt_topic_liveData, payload.c_str())) {
             Serial.println("✅ Hardware data published successfully: " + payload);
+            if (otaBootReport) {
+                confirmOtaBoot();
+            }
             good_path_count = 0;
             reject_count = 0;
             start_time = 0;
@@ -148,13 +494,13 @@ void readHardwareData() {
 
         if (status != lastStatus) {
             JsonDocument statusDoc;
-            statusDoc["machine_id"] = machine_id;
+            statusDoc["machine_id"] = config.machine_id;
             statusDoc["status"] = status;
 
             String statusPayload;
             serializeJson(statusDoc, statusPayload);
 
-            String statusUrl = mqtt_topic_status + String(machine_id);
+            String statusUrl = String(config.mqtt_topic_status) + config.machine_id;
             if (client.publish(statusUrl.c_str(), statusPayload.c_str())) {
                 Serial.println("✅ Status published successfully: " + statusPayload);
             } else {
@@ -175,7 +521,7 @@ void sendAggregatedData() {
 
         // สร้าง payload สำหรับ record data
         JsonDocument doc;
-        doc["machine_id"] = machine_id;
+        doc["machine_id"] = config.machine_id;
         doc["cycle_time"] = avg_cycle_time;
         doc["cpm"] = avg_cpm;
         doc["good_path_count"] = total_good_path_count;
@@ -186,7 +532,7 @@ void sendAggregatedData() {
         String payload;
         serializeJson(doc, payload);
         // ส่งข้อมูลไปยัง MQTT broker
-        if (client.publish(mqtt_topic_record.c_str(), payload.c_str())) {
+        if (client.publish(config.mqtt_topic_record, payload.c_str())) {
             Serial.println("✅ Aggregated data published successfully: " + payload);
             // Reset aggregation variables
             total_cycle_time = 0;
@@ -221,7 +567,7 @@ void publishRandomData() {
 
             // สร้าง JSON payload ด้วย ArduinoJson
             JsonDocument doc;
-            doc["machine_id"] = machine_id;
+            doc["machine_id"] = config.machine_id;
             doc["status"] = _status;
             doc["cycle_time"] = _cycle_time;
             doc["cpm"] = _cpm;
@@ -233,7 +579,7 @@ void publishRandomData() {
             String payload;
             serializeJson(doc, payload);
 
-            if (client.publish(mqtt_topic_liveData.c_str(), payload.c_str())) {
+            if (client.publish(config.mqtt_topic_liveData, payload.c_str())) {
                 Serial.println("✅ Message published successfully: " + payload);
             } else {
                 Serial.println("❌ Message publishing failed");
@@ -241,13 +587,13 @@ void publishRandomData() {
 
             if (String(_status) != _lastStatus) {
                 JsonDocument statusDoc;
-                statusDoc["machine_id"] = machine_id;
+                statusDoc["machine_id"] = config.machine_id;
                 statusDoc["status"] = _status;
 
                 String statusPayload;
                 serializeJson(statusDoc, statusPayload);
 
-                String statusUrl = mqtt_topic_status + String(machine_id);
+                String statusUrl = String(config.mqtt_topic_status) + config.machine_id;
                 if (client.publish(statusUrl.c_str(), statusPayload.c_str())) {
                     Serial.println("✅ Status published successfully: " + statusPayload);
                 } else {
@@ -268,6 +614,8 @@ void processCpmTimeTask(void *parameter) {
     static unsigned long lastTimeout = 0;   // เก็บเวลา timeout
     static bool rejectStatus = false;       // เก็บเวลา timeout
 
+    countingStartTime = millis();
+
     for (;;) {
         if (cycleTimeTiggered) {
             if (firstCycleTimeTigger) {
@@ -284,17 +632,25 @@ void processCpmTimeTask(void *parameter) {
 
                 isRunning = true; // เปลี่ยนสถานะการทำงาน -> true
 
-                for (int i = 0; i < REJECT_NUMBER_PIN; i++) {
+                uint8_t rejectMask = 0;
+                for (int i = 0; i < config.reject_number_pin; i++) {
                     int readRejectSensor = digitalRead(REJECT_PINS[i]);
 
                     if (readRejectSensor == LOW) {
+                        rejectMask |= 1 << i;
                         rejectStatus = true;
                         reject_count++;
+                        lifetime_reject_count++;
                     }
                 }
 
                 if (!rejectStatus) {
                     good_path_count++;
+                    lifetime_good_count++;
+                }
+
+                if (config.raw_mode) {
+                    rawLog.add(lastCycleTimeInterrupt, rejectMask); // ใช้เวลาจาก interrupt ไม่ใช่เวลาที่ task มาประมวลผล
                 }
 
                 Serial.printf("Cycle time (s): %.2f, Result: %s, ", cycle_time, rejectStatus ? "NG" : "OK");
@@ -304,7 +660,7 @@ void processCpmTimeTask(void *parameter) {
         }
 
         // หากไม่มีสัญญานจากเซ็นเซอร์ภายใน 3 วินาที และ สถานะการทำงาน -> true
-        if (millis() - lastTimeout >= timeout && isRunning) {
+        if (millis() - lastTimeout >= config.timeout && isRunning) {
             Serial.println("Machine stopped working!!");
             isRunning = false; // เปลี่ยนสถานะการทำงาน -> false
             firstCycleTimeTigger = true;
@@ -319,74 +675,175 @@ void processCpmTimeTask(void *parameter) {
 // รีเซ็ตการตั้งค่า
 void factoryReset() {
     Serial.println("Factory reset....");
+    Preferences preferences;
     preferences.begin(NAME_SPACE, false);
-    preferences.clear(); // ลบข้อมูลทั้งหมดใน namespace "myApp"
+    preferences.clear(); // ลบข้อมูลทั้งหมดใน namespace
     preferences.end();
 
+    configRegistry.applyDefaults(&config);
+    configRegistry.save();
     delay(500);
-    preferences.begin(NAME_SPACE, false);
-    preferences.putString(MEM_WIFI_SSID, DEFAULT_WIFI_SSID);
-    preferences.putString(MEM_WIFI_PASSWORD, DEFAULT_WIFI_PASSWORD);
-    preferences.putInt(MEM_MQTT_MQTT_SERVER, DEFAULT_MQTT_PORT);
-    preferences.putString(MEM_MQTT_MQTT_PORT, DEFAULT_MQTT_SERVER);
-    preferences.putString(MEM_MQTT_MQTT_TOPIC_LIVEDATA, DEFAULT_MQTT_TOPIC_LIVEDATA);
-    preferences.putString(MEM_MQTT_MQTT_TOPIC_RECORD, DEFAULT_MQTT_TOPIC_RECORD);
-    preferences.putString(MEM_MQTT_TOPIC_STATUS, DEFAULT_MQTT_TOPIC_STATUS);
-
-    preferences.putInt(MEM_DEBOUNDE_DELAY, DEFAULT_DEBOUNDE_DELAY);
-    preferences.putInt(MEM_TIMEOUT, DEFAULT_TIMEOUT);
+}
 
-    preferences.end();
-    delay(500);
+void printConfiguration() {
+    Serial.println("================================");
+    configRegistry.print(Serial);
+    Serial.println("================================");
 }
 
-// โหลดข้อมูลการตั้งค่า
+// โหลดข้อมูลการตั้งค่า (อ่าน NVS ครั้งเดียว)
 void loadConfiguration() {
-    // เปิด Namespace "polipharm" ในโหมดอ่าน-เขียน
-    preferences.begin(NAME_SPACE, true);
-    IS_FIRST_RUN = preferences.getBool(MEM_FIRST_RUN, false);
-    if (IS_FIRST_RUN) {
-        factoryReset();
+    ConfigRegistry::LoadResult result = configRegistry.load();
+    Serial.printf("Configuration loaded (%s)\n", result == ConfigRegistry::LOAD_OK         ? "blob"
+                                                   : result == ConfigRegistry::LOAD_UPGRADED ? "upgraded"
+                                                                                             : "migrated");
+    printConfiguration();
+
+    pinMode(config.cycle_time_pin, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(config.cycle_time_pin), handleCycleTime, FALLING);
+    for (int i = 0; i < config.reject_number_pin; i++) {
+        pinMode(REJECT_PINS[i], INPUT_PULLUP);
+    }
+}
+
+// ===== apply hooks (เรียกหลังบันทึกค่าใหม่แล้ว) =====
+void applyMachineIdConfig(const void *previous) {
+    liveServer.setMachineId(config.machine_id);
+    if (client.connected()) {
+        subscribeTopics();
     }
+}
 
-    machine_id = preferences.getString(MEM_MACHINE_ID, "");
-    Serial.println("MACHINE ID: " + machine_id);
+void applyWiFiConfig(const void *previous) {
+    WiFi.disconnect(); // setupWiFi() จะเชื่อมต่อใหม่ด้วยค่าใหม่
+}
 
-    CYCLE_TIME_PIN = preferences.getInt(MEM_CYCLE_TIME_NUMBER_PIN, DEFAULT_CYCLE_TIME_PIN);
-    REJECT_NUMBER_PIN = preferences.getInt(MEM_REJECT_NUMBER_PIN, DEFAULT_REJECT_NUMBER_PIN);
-    pinMode(CYCLE_TIME_PIN, INPUT_PULLUP);
-    attachInterrupt(digitalPinToInterrupt(CYCLE_TIME_PIN), handleCycleTime, FALLING);
-    Serial.println("CYCLE_TIME_PIN: " + String(CYCLE_TIME_PIN));
-    Serial.print("REJECT_PINS: ");
-    for (int i = 0; i < REJECT_NUMBER_PIN; i++) {
+void applyMqttServerConfig(const void *previous) {
+    client.disconnect();
+    client.setServer(config.mqtt_server, config.mqtt_port);
+}
+
+void applyCycleTimePinConfig(const void *previous) {
+    const MachineConfig *old = (const MachineConfig *)previous;
+    detachInterrupt(digitalPinToInterrupt(old->cycle_time_pin));
+    pinMode(config.cycle_time_pin, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(config.cycle_time_pin), handleCycleTime, FALLING);
+}
+
+void applyRejectPinConfig(const void *previous) {
+    for (int i = 0; i < config.reject_number_pin; i++) {
         pinMode(REJECT_PINS[i], INPUT_PULLUP);
-        Serial.print(String(REJECT_PINS[i]));
-        i < REJECT_NUMBER_PIN - 1 ? Serial.print(", ") : Serial.println();
-    }
-
-    // ข้อมูล Wi-Fi
-    wifi_ssid = preferences.getString(MEM_WIFI_SSID, DEFAULT_WIFI_SSID);
-    wifi_password = preferences.getString(MEM_WIFI_PASSWORD, DEFAULT_WIFI_PASSWORD);
-    mqtt_server = preferences.getString(MEM_MQTT_MQTT_SERVER, DEFAULT_MQTT_SERVER);
-    mqtt_port = preferences.getInt(MEM_MQTT_MQTT_PORT, DEFAULT_MQTT_PORT);
-    mqtt_topic_liveData = preferences.getString(MEM_MQTT_MQTT_TOPIC_LIVEDATA, DEFAULT_MQTT_TOPIC_LIVEDATA);
-    mqtt_topic_record = preferences.getString(MEM_MQTT_MQTT_TOPIC_RECORD, DEFAULT_MQTT_TOPIC_RECORD);
-    mqtt_topic_status = preferences.getString(MEM_MQTT_TOPIC_STATUS, DEFAULT_MQTT_TOPIC_STATUS);
-    Serial.println("WIFI SSID: " + wifi_ssid);
-    Serial.println("WIFI PASS: " + wifi_password);
-    Serial.println("MQTT SERVER URL: " + mqtt_server);
-    Serial.println("MQTT SERVER PORT: " + String(mqtt_port));
-    Serial.println("MQTT TOPIC LIVE DATA: " + mqtt_topic_liveData);
-    Serial.println("MQTT TOPIC RECORD: " + mqtt_topic_record);
-    Serial.println("MQTT TOPIC STATUS: " + mqtt_topic_status);
-    Serial.println("================================");
+    }
+}
 
-    debounceDelay = preferences.getInt(MEM_DEBOUNDE_DELAY, DEFAULT_DEBOUNDE_DELAY);
-    timeout = preferences.getInt(MEM_TIMEOUT, DEFAULT_TIMEOUT);
-    Serial.println("DEBOUNDE DELAY: " + String(debounceDelay));
-    Serial.println("TIMEOUT TIMEOUT: " + String(timeout));
-    Serial.println("================================");
+void applyRawModeConfig(const void *previous) {
+    rawLog.reset();
+    Serial.printf("(RawCycle)=> %s\n", config.raw_mode ? "Enabled" : "Disabled");
+}
+
+// เปลี่ยนค่าหลายตัวพร้อมกันแบบ atomic: ตรวจสอบทุกค่าก่อน ถ้ามีค่าผิดจะไม่เปลี่ยนอะไรเลย
+// ack ถูกเรียกหลังบันทึก แต่ก่อน apply hooks (เช่นก่อนตัดการเชื่อมต่อ MQTT เมื่อเปลี่ยน broker)
+bool applyConfigBatch(JsonObjectConst values, JsonDocument &result, void (*ack)(JsonDocument &result)) {
+    MachineConfig next = config;
+    JsonArray errors = result["errors"].to<JsonArray>();
 
+    for (JsonPairConst kv : values) {
+        String key = kv.key().c_str();
+        if (key == "req") {
+            continue;
+        }
+
+        const ConfigParam *param = configRegistry.find(key);
+        String error;
+        if (param == NULL) {
+            error = "unknown parameter";
+        } else {
+            configRegistry.parse(&next, param, kv.value().as<String>(), error);
+        }
+
+        if (error.length() > 0) {
+            JsonObject e = errors.add<JsonObject>();
+            e["param"] = key;
+            e["error"] = error;
+        }
+    }
+
+    if (errors.size() > 0) {
+        result["ok"] = false;
+        if (ack) {
+            ack(result);
+        }
+        return false;
+    }
+    result.remove("errors");
+
+    // เก็บ hook ที่ต้องเรียก (ไม่ซ้ำกัน)
+    ConfigApplyHook hooks[sizeof(CONFIG_TABLE) / sizeof(CONFIG_TABLE[0])];
+    size_t hookCount = 0;
+    JsonArray changed = result["changed"].to<JsonArray>();
+    for (size_t i = 0; i < configRegistry.count(); i++) {
+        const ConfigParam *param = configRegistry.at(i);
+        if (!configRegistry.changed(&config, &next, param)) {
+            continue;
+        }
+        changed.add(param->name);
+
+        bool exists = param->apply == NULL;
+        for (size_t h = 0; h < hookCount && !exists; h++) {
+            exists = hooks[h] == param->apply;
+        }
+        if (!exists) {
+            hooks[hookCount++] = param->apply;
+        }
+    }
+
+    MachineConfig previous = config;
+    config = next;
+    bool saved = changed.size() == 0 || configRegistry.save();
+    result["ok"] = saved;
+    if (!saved) {
+        config = previous;
+        result["error"] = "save failed";
+    }
+
+    if (ack) {
+        ack(result);
+    }
+
+    if (saved) {
+        for (size_t h = 0; h < hookCount; h++) {
+            hooks[h](&previous);
+        }
+    }
+    return saved;
+}
+
+void publishConfigAck(JsonDocument &result) {
+    String payload;
+    serializeJson(result, payload);
+    String ackTopic = String(DEFAULT_MQTT_TOPIC_CONFIG) + config.machine_id + "/ack";
+    client.publish(ackTopic.c_str(), payload.c_str());
+    Serial.println("(Config)=> " + payload);
+}
+
+// ตั้งค่าผ่าน MQTT: machine/config/<machine_id>
+void handleConfigRequest(const byte *payload, unsigned int length) {
+    JsonDocument req;
+    DeserializationError error = deserializeJson(req, payload, length);
+
+    JsonDocument result;
+    result["machine_id"] = config.machine_id;
+    if (error || !req.is<JsonObject>()) {
+        result["ok"] = false;
+        result["error"] = error ? error.c_str() : "expected object";
+        publishConfigAck(result);
+        return;
+    }
+    if (!req["req"].isNull()) {
+        result["req"] = req["req"];
+    }
+
+    applyConfigBatch(req.as<JsonObjectConst>(), result, publishConfigAck);
 }
 
 void command(char cmd) {
@@ -399,16 +856,7 @@ void command(char cmd) {
         Serial.println("F: Factory Reset");
         Serial.println("S: Set specific parameter");
         Serial.println("    Parameters:");
-        Serial.println("    - machine_id (id): Set MACHINE ID");
-        Serial.println("    - wifi_ssid (ws): Set WiFi SSID");
-        Serial.println("    - wifi_password (wp): Set WiFi Password");
-        Serial.println("    - mqtt_server (ms): Set MQTT Server");
-        Serial.println("    - mqtt_port (mp): Set MQTT Port");
-        Serial.println("    - mqtt_topic_liveData (mtl): Set MQTT Topic for Live Data");
-        Serial.println("    - mqtt_topic_record (mtr): Set MQTT Topic for Record Data");
-        Serial.println("    - mqtt_topic_status (mts): Set MQTT Topic for Status");
-        Serial.println("    - debounceDelay (dd): Set debounce delay (ms)");
-        Serial.println("    - timeout (to): Set timeout (ms)");
+        configRegistry.print(Serial);
         Serial.println("======================");
         break;
     case 'D': // ตั้งค่า Development Mode
@@ -426,9 +874,7 @@ void command(char cmd) {
         break;
     case 'S': { // ตั้งค่าพารามิเตอร์เฉพาะ
         Serial.println("(SETTINGS)=> Enter parameter to configure:");
-        Serial.println("Options: machine_id (id), cycle_time_pin (ctp), reject_number_pin (rnp), wifi_ssid (ws), wifi_password (wp), mqtt_server "
-                       "(ms), mqtt_port (mp), mqtt_topic_liveData (mtl), "
-                       "mqtt_topic_record (mtr), mqtt_topic_status (mts), debounceDelay (dd), timeout (to)");
+        configRegistry.print(Serial);
 
         while (!Serial.available()) {
             delay(10); // รอรับชื่อพารามิเตอร์
@@ -443,63 +889,16 @@ void command(char cmd) {
         String value = Serial.readStringUntil('\n');
         value.trim();
 
-        preferences.begin(NAME_SPACE, false);
-        if (parameter == "machine_id" || parameter == "id") {
-            preferences.putString(MEM_MACHINE_ID, value);
-            machine_id = value;
-        } else if (parameter == "wifi_ssid" || parameter == "ws") {
-            preferences.putString(MEM_WIFI_SSID, value);
-            wifi_ssid = value;
-            WiFi.disconnect();
-            delay(500); // รอให้การตัดการเชื่อมต่อเสร็จสิ้น
-        } else if (parameter == "wifi_password" || parameter == "wp") {
-            preferences.putString(MEM_WIFI_PASSWORD, value);
-            wifi_password = value;
-            WiFi.disconnect();
-            delay(500); // รอให้การตัดการเชื่อมต่อเสร็จสิ้น
-        } else if (parameter == "mqtt_server" || parameter == "ms") {
-            preferences.putString(MEM_MQTT_MQTT_SERVER, value);
-            mqtt_server = value;
-
-            client.disconnect();
-            delay(500); // รอให้การตัดการเชื่อมต่อเสร็จสิ้น
-
-        } else if (parameter == "mqtt_port" || parameter == "mp") {
-            preferences.putInt(MEM_MQTT_MQTT_PORT, value.toInt());
-            mqtt_port = value.toInt();
-
-            client.disconnect();
-            delay(500); // รอให้การตัดการเชื่อมต่อเสร็จสิ้น
-        } else if (parameter == "mqtt_topic_liveData" || parameter == "mtl") {
-            preferences.putString(MEM_MQTT_MQTT_TOPIC_LIVEDATA, value);
-            mqtt_topic_liveData = value;
-        } else if (parameter == "mqtt_topic_record" || parameter == "mtr") {
-            preferences.putString(MEM_MQTT_MQTT_TOPIC_RECORD, value);
-            mqtt_topic_record = value;
-        } else if (parameter == "mqtt_topic_status" || parameter == "mts") {
-            preferences.putString(MEM_MQTT_TOPIC_STATUS, value);
-            mqtt_topic_status = value;
-        } else if (parameter == "debounceDelay" || parameter == "dd") {
-            preferences.putInt(MEM_DEBOUNDE_DELAY, value.toInt());
-            debounceDelay = value.toInt();
-        } else if (parameter == "cycle_time_pin" || parameter == "ctp") {
-            // ยกเลิก attachInterrupt สำหรับ CYCLE_TIME_PIN
-            detachInterrupt(digitalPinToInterrupt(CYCLE_TIME_PIN));
-            preferences.putInt(MEM_CYCLE_TIME_NUMBER_PIN, value.toInt());
-            CYCLE_TIME_PIN = value.toInt();
-            attachInterrupt(digitalPinToInterrupt(CYCLE_TIME_PIN), handleCycleTime, FALLING);
-        } else if (parameter == "reject_number_pin" || parameter == "rnp") {
-            preferences.putInt(MEM_REJECT_NUMBER_PIN, value.toInt());
-            REJECT_NUMBER_PIN = value.toInt();
-        } else if (parameter == "timeout" || parameter == "to") {
-            preferences.putInt(MEM_TIMEOUT, value.toInt());
-            timeout = value.toInt();
+        JsonDocument values;
+        values[parameter] = value;
+        JsonDocument result;
+        if (applyConfigBatch(values.as<JsonObjectConst>(), result, NULL)) {
+            Serial.println("(SETTINGS)=> " + parameter + " updated to: " + value);
         } else {
-            Serial.println("(SETTINGS)=> Unknown parameter: " + parameter);
+            String errors;
+            serializeJson(result, errors);
+            Serial.println("(SETTINGS)=> Failed: " + errors);
         }
-        preferences.end();
-
-        Serial.println("(SETTINGS)=> " + parameter + " updated to: " + value);
         break;
     }
     default:
@@ -532,8 +931,16 @@ void updateLedStatus() {
 void setup() {
     Serial.begin(115200);
     loadConfiguration();
+    loadOtaBootInfo();
+
+    const uint16_t pyramidSlots[CounterPyramid::LEVELS] = {PYRAMID_L0_SLOTS, PYRAMID_L1_SLOTS, PYRAMID_L2_SLOTS};
+    const uint16_t pyramidFactor[CounterPyramid::LEVELS] = {1, PYRAMID_L1_FACTOR, PYRAMID_L2_FACTOR};
+    pyramid.begin(pyramidSlots, pyramidFactor, PYRAMID_BASE_RESOLUTION);
+    rawLog.begin();
 
-    client.setServer(mqtt_server.c_str(), mqtt_port);
+    client.setServer(config.mqtt_server, config.mqtt_port);
+    client.setBufferSize(MQTT_BUFFER_SIZE);
+    client.setCallback(mqttCallback);
     connectToMQTT();
 
     // ตั้งค่า GPIO pins และ interrupts
@@ -572,6 +979,7 @@ void loop() {
             total_stop_time += 2;
         }
 
+        samplePyramid();
         readHardwareData();
     }
 
@@ -582,6 +990,21 @@ void loop() {
         sendAggregatedData();
     }
 
+    // ส่งค่าที่เปลี่ยนให้ client ของ live counter server
+    LiveCounterSnapshot snapshot;
+    snapshot.running = isRunning;
+    snapshot.cycle_time = cycle_time;
+    snapshot.cpm = cpm;
+    snapshot.good = lifetime_good_count;
+    snapshot.reject = lifetime_reject_count;
+    liveServer.update(snapshot);
+
+    updateOta();
+
+    if (config.raw_mode && client.connected()) {
+        publishRawCycles();
+    }
+
     if (devMode)
         publishRandomData();
 
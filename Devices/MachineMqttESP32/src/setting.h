@@ -1,12 +1,15 @@
 #define NAME_SPACE "machine_mqtt"
+#define FIRMWARE_VERSION "1.1.0"
 
 // Pins for input signals
 #define LED_STATUS 2
-int CYCLE_TIME_PIN = 34;
-int REJECT_NUMBER_PIN = 4;
 const int REJECT_PINS[] = {12, 22, 14, 15};
 
 // Preferences
+#define MEM_CONFIG "config"     // blob การตั้งค่าทั้งหมด (ดู config.h)
+#define MEM_OTA_BOOT "ota_boot" // ข้อมูลก่อนรีบูตเพื่อติดตั้ง firmware ใหม่
+
+// key เดิมแบบแยกตัว (ใช้ย้ายค่าเข้า blob ครั้งแรก)
 #define MEM_FIRST_RUN "first_run"
 #define MEM_MACHINE_ID "machine_id"
 #define MEM_WIFI_SSID "wifi_ssid"
@@ -38,6 +41,54 @@ const int REJECT_PINS[] = {12, 22, 14, 15};
 #define DEFAULT_CYCLE_TIME_PIN 34
 #define DEFAULT_REJECT_NUMBER_PIN 1
 
+// MQTT
+#define MQTT_BUFFER_SIZE 2048
+
+// Backfill (ข้อมูลย้อนหลังแบบหลายความละเอียด)
+// request:  machine/backfill/request/<machine_id>  {"level":2,"from":0,"max":30,"req":"..."}
+// response: machine/backfill/response/<machine_id> {"level":2,"resolution":900,"uptime":...,"next":...,"rows":[[t,good,reject,run_s,stop_s,cycle_time,cpm],...]}
+#define DEFAULT_MQTT_TOPIC_BACKFILL_REQUEST "machine/backfill/request/"
+#define DEFAULT_MQTT_TOPIC_BACKFILL_RESPONSE "machine/backfill/response/"
+
+// ตั้งค่าผ่าน MQTT
+// request: machine/config/<machine_id>     {"dd":40,"to":5000,"req":"..."} (ใช้ชื่อเต็มหรือชื่อย่อได้)
+// ack:     machine/config/<machine_id>/ack {"ok":true,"changed":["debounceDelay","timeout"]}
+#define DEFAULT_MQTT_TOPIC_CONFIG "machine/config/"
+
+// OTA (A/B partition)
+// request: machine/ota/<machine_id>        {"url":"http://.../fw.bin","size":123456,"sha256":"...","version":"1.2.0"}
+//                                          {"transport":"mqtt","size":123456,"sha256":"...","version":"1.2.0"}
+//                                          {"abort":true}
+// chunk:   machine/ota/<machine_id>/chunk  [offset: uint32 little-endian][data] (ส่ง chunk ถัดไปตามค่า next ใน status)
+// status:  machine/ota/<machine_id>/status {"state":"downloading","received":...,"next":...,"total":...}
+#define DEFAULT_MQTT_TOPIC_OTA "machine/ota/"
+#define OTA_CHUNK_SIZE 1024      // ต้องเล็กกว่า MQTT_BUFFER_SIZE
+#define OTA_BUFFER_SIZE 8192     // buffer ระหว่าง MQTT callback กับ OTA task
+#define DEFAULT_OTA_CONFIRM_MINUTES 5
+#define OTA_BROKER_TIMEOUT_MINUTES 30 // firmware ใหม่ต่อ broker ไม่ได้เลยนับจากบูต (WiFi/MQTT เสีย) rollback
+#define BACKFILL_MAX_ROWS 30
+
+// Raw cycle mode: ส่งข้อมูลทุกรอบการทำงาน (เวลา + reject mask) เป็น binary block
+// topic: machine/raw/<machine_id> (รูปแบบ block ดูใน RawCycleLog.h)
+#define DEFAULT_MQTT_TOPIC_RAW "machine/raw/"
+#define RAW_CYCLE_CAPACITY 300   // จำนวนรอบสูงสุดต่อ buffer (x2 buffer)
+#define DEFAULT_RAW_INTERVAL 10  // วินาที
+#define DEFAULT_RAW_CYCLES 200   // รอบ (20 รอบ/วินาที x 10 วินาที)
+
+// pyramid อยู่ใน heap อย่างเดียว (828 bucket x 28 byte ~ 23 KB) รีบูตแล้วเริ่มใหม่
+// เวลาใน bucket เป็น uptime ข้ามรีบูตไม่ได้ จึงไม่เก็บลง flash
+#define PYRAMID_BASE_RESOLUTION 2 // วินาที (ตรงกับรอบส่ง live data)
+#define PYRAMID_L0_SLOTS 300      // 2 วินาที x 300 = 10 นาที
+#define PYRAMID_L1_SLOTS 240      // 1 นาที x 240 = 4 ชั่วโมง
+#define PYRAMID_L2_SLOTS 288      // 15 นาที x 288 = 3 วัน
+#define PYRAMID_L1_FACTOR 30      // 30 x 2 วินาที = 1 นาที
+#define PYRAMID_L2_FACTOR 15      // 15 x 1 นาที = 15 นาที
+
+// Live counter server (HTTP + WebSocket สำหรับแท็บเล็ตข้างไลน์)
+#define LIVE_SERVER_PORT 80
+#define LIVE_SERVER_MAX_CLIENTS 4
+#define LIVE_SERVER_PUSH_INTERVAL 100 // ms
+
 
 // โหมดการใช้งาน
 enum ModeType { MODE_GRAM, MODE_PCS, MODE_SETTING };
@@ -0,0 +1,338 @@
+#include "AuditLog.h"
+#include "SDCard.h"
+#include <esp_heap_caps.h>
+
+namespace {
+
+const uint32_t SECONDS_PER_DAY = 86400;
+
+// วันนับจาก 1970-01-01 <-> ปี/เดือน/วัน (ปฏิทินเกรกอเรียน ไม่ต้องใช้ตาราง)
+uint32_t daysFromCivil(int32_t year, uint32_t month, uint32_t day) {
+    year -= month <= 2;
+    int32_t era = year / 400;
+    uint32_t yearOfEra = year - era * 400;
+    uint32_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+void civilFromDays(uint32_t days, int32_t &year, uint32_t &month, uint32_t &day) {
+    int32_t z = days + 719468;
+    int32_t era = z / 146097;
+    uint32_t dayOfEra = z - era * 146097;
+    uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    uint32_t mp = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = yearOfEra + era * 400 + (month <= 2);
+}
+
+void *allocate(size_t size) {
+    void *data = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    return data != NULL ? data : malloc(size);
+}
+
+} // namespace
+
+AuditLog::AuditLog() : fs(NULL), index(NULL), block(NULL), indexDay(0), indexCount(0) { memset(&statistics, 0, sizeof(statistics)); }
+
+uint32_t AuditLog::dayOf(uint32_t time) {
+    int32_t year;
+    uint32_t month, day;
+    civilFromDays(time / SECONDS_PER_DAY, year, month, day);
+    return year * 10000 + month * 100 + day;
+}
+
+uint32_t AuditLog::timeOf(uint32_t day) { return daysFromCivil(day / 10000, day / 100 % 100, day % 100) * SECONDS_PER_DAY; }
+
+void AuditLog::formatTime(uint32_t time, char *text, size_t size) {
+    int32_t year;
+    uint32_t month, day;
+    civilFromDays(time / SECONDS_PER_DAY, year, month, day);
+    uint32_t seconds = time % SECONDS_PER_DAY;
+    snprintf(text, size, "%04ld-%02lu-%02lu %02lu:%02lu:%02lu", (long)year, (unsigned long)month, (unsigned long)day,
+             (unsigned long)(seconds / 3600), (unsigned long)(seconds / 60 % 60), (unsigned long)(seconds % 60));
+}
+
+String AuditLog::path(uint32_t day, const char *extension) {
+    char text[32];
+    snprintf(text, sizeof(text), AUDIT_DIR "/%08lu%s", (unsigned long)day, extension);
+    return String(text);
+}
+
+bool AuditLog::begin(fs::FS &fs) {
+    if (index == NULL) {
+        index = (uint32_t *)allocate(AUDIT_INDEX_MAX * sizeof(uint32_t));
+        block = (AuditRecord *)allocate(AUDIT_INDEX_STRIDE * sizeof(AuditRecord));
+        if (index == NULL || block == NULL) {
+            Serial.println("(Audit)=> Allocate index failed");
+            return false;
+        }
+    }
+    this->fs = &fs;
+    indexDay = 0;
+    if (!fs.exists(AUDIT_DIR)) {
+        fs.mkdir(AUDIT_DIR);
+    }
+
+    // เลขลำดับต่อจาก record สุดท้ายของวันล่าสุดที่มีข้อมูล (การ์ดใหม่เริ่มที่ 0) ข้ามเศษจากไฟดับ (magic = 0)
+    statistics.ready = true;
+    statistics.sequence = 0;
+    uint32_t recent[8];
+    uint16_t found = days(recent, 8);
+    for (uint16_t i = 0; i < found; i++) {
+        uint32_t records = count(recent[i]);
+        uint32_t first = records - min(records, (uint32_t)AUDIT_INDEX_STRIDE);
+        uint32_t n = records > 0 ? read(recent[i], first, block, records - first) : 0;
+        while (n > 0 && block[n - 1].magic != AUDIT_MAGIC) {
+            n--;
+        }
+        if (n > 0) {
+            statistics.sequence = block[n - 1].sequence + 1;
+            break;
+        }
+    }
+    Serial.printf("(Audit)=> Ready, next sequence %lu\n", (unsigned long)statistics.sequence);
+    return true;
+}
+
+void AuditLog::end() {
+    statistics.ready = false;
+    indexDay = 0;
+}
+
+bool AuditLog::append(AuditRecord &record) {
+    if (!statistics.ready) {
+        statistics.dropped++;
+        return false;
+    }
+    uint32_t day = dayOf(record.time);
+    File file = fs->open(path(day, ".dat"), FILE_APPEND);
+    if (!file) {
+        statistics.dropped++;
+        return false;
+    }
+
+    // ไฟดับระหว่างเขียน: เติม 0 ให้เศษเต็ม record (magic = 0) ให้ record ถัดไปยังอยู่ตรงตำแหน่ง n * 32
+    size_t size = file.size();
+    size_t torn = size % sizeof(AuditRecord);
+    if (torn != 0) {
+        uint8_t zero[sizeof(AuditRecord)] = {0};
+        file.write(zero, sizeof(AuditRecord) - torn);
+        size += sizeof(AuditRecord) - torn;
+    }
+    uint32_t number = size / sizeof(AuditRecord);
+    record.sequence = statistics.sequence;
+    record.magic = AUDIT_MAGIC;
+    bool ok = file.write((const uint8_t *)&record, sizeof(record)) == sizeof(record);
+    file.close();
+    if (!ok) {
+        statistics.dropped++;
+        return false;
+    }
+
+    // .idx ที่เขียนไม่สำเร็จ/ไม่ครบ ลบทิ้ง loadIndex() สร้างใหม่จาก .dat ตอนค้น
+    if (number % AUDIT_INDEX_STRIDE == 0) {
+        String indexPath = path(day, ".idx");
+        File indexFile = fs->open(indexPath, FILE_APPEND);
+        bool aligned = indexFile && indexFile.size() == number / AUDIT_INDEX_STRIDE * sizeof(uint32_t);
+        if (!aligned || indexFile.write((const uint8_t *)&record.time, sizeof(record.time)) != sizeof(record.time)) {
+            indexFile.close();
+            fs->remove(indexPath);
+        }
+        indexFile.close();
+    }
+    statistics.sequence++;
+    statistics.appended++;
+    return true;
+}
+
+uint16_t AuditLog::days(uint32_t *days, uint16_t max) {
+    if (!statistics.ready) {
+        return 0;
+    }
+    File dir = fs->open(AUDIT_DIR);
+    if (!dir || !dir.isDirectory()) {
+        return 0;
+    }
+
+    // เก็บ max วันล่าสุด เรียงใหม่ไปเก่า (insertion sort ระหว่างอ่าน ไม่ต้องเก็บรายชื่อทั้งหมด)
+    uint16_t found = 0;
+    for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+        const char *name = file.name();
+        const char *slash = strrchr(name, '/');
+        name = slash != NULL ? slash + 1 : name;
+        file.close();
+        if (strlen(name) != 12 || strcmp(name + 8, ".dat") != 0) {
+            continue;
+        }
+        uint32_t day = strtoul(name, NULL, 10);
+        uint16_t i = found < max ? found++ : max;
+        while (i > 0 && days[i - 1] < day) {
+            if (i < max) {
+                days[i] = days[i - 1];
+            }
+            i--;
+        }
+        if (i < max) {
+            days[i] = day;
+        }
+    }
+    dir.close();
+    return found;
+}
+
+uint32_t AuditLog::count(uint32_t day) {
+    if (!statistics.ready) {
+        return 0;
+    }
+    String name = path(day, ".dat");
+    if (!fs->exists(name)) {
+        return 0;
+    }
+    File file = fs->open(name, FILE_READ);
+    uint32_t records = file ? file.size() / sizeof(AuditRecord) : 0;
+    file.close();
+    return records;
+}
+
+uint32_t AuditLog::read(uint32_t day, uint32_t first, AuditRecord *records, uint32_t max) {
+    if (!statistics.ready) {
+        return 0;
+    }
+    File file = fs->open(path(day, ".dat"), FILE_READ);
+    if (!file || !file.seek(first * sizeof(AuditRecord))) {
+        file.close();
+        return 0;
+    }
+    size_t bytes = file.read((uint8_t *)records, max * sizeof(AuditRecord));
+    file.close();
+    return bytes / sizeof(AuditRecord);
+}
+
+bool AuditLog::loadIndex(uint32_t day, uint32_t records) {
+    if (indexDay == day && indexCount == records) {
+        return true;
+    }
+    uint32_t expected = min((records + AUDIT_INDEX_STRIDE - 1) / AUDIT_INDEX_STRIDE, (uint32_t)AUDIT_INDEX_MAX);
+    File file = fs->open(path(day, ".idx"), FILE_READ);
+    uint32_t loaded = file ? file.read((uint8_t *)index, expected * sizeof(uint32_t)) / sizeof(uint32_t) : 0;
+    file.close();
+
+    // เขียน .idx ไม่ทัน (ไฟดับ/ถอดการ์ด) อ่านเวลาจาก .dat แล้วเขียนเพิ่ม
+    if (loaded < expected) {
+        File data = fs->open(path(day, ".dat"), FILE_READ);
+        File out = fs->open(path(day, ".idx"), loaded == 0 ? FILE_WRITE : FILE_APPEND);
+        for (uint32_t i = loaded; data && i < expected; i++) {
+            AuditRecord record;
+            if (!data.seek(i * AUDIT_INDEX_STRIDE * sizeof(AuditRecord)) || data.read((uint8_t *)&record, sizeof(record)) != sizeof(record)) {
+                break;
+            }
+            index[i] = record.time;
+            if (out) {
+                out.write((const uint8_t *)&record.time, sizeof(record.time));
+            }
+            loaded++;
+        }
+        data.close();
+        out.close();
+        Serial.printf("(Audit)=> Rebuilt index of %08lu (%lu entries)\n", (unsigned long)day, (unsigned long)loaded);
+    }
+    indexDay = day;
+    indexCount = records;
+    return loaded == expected;
+}
+
+uint32_t AuditLog::find(uint32_t day, uint32_t time) {
+    uint32_t records = count(day);
+    if (records == 0 || !loadIndex(day, records)) {
+        return records;
+    }
+
+    // ช่วงสุดท้ายที่เวลาเริ่มต้น < time แล้วไล่ใน record ของช่วงนั้น
+    uint32_t entries = min((records + AUDIT_INDEX_STRIDE - 1) / AUDIT_INDEX_STRIDE, (uint32_t)AUDIT_INDEX_MAX);
+    uint32_t low = 0, high = entries;
+    while (low < high) {
+        uint32_t middle = (low + high) / 2;
+        if (index[middle] < time) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low == 0) {
+        return 0;
+    }
+    uint32_t first = (low - 1) * AUDIT_INDEX_STRIDE;
+    uint32_t n = read(day, first, block, AUDIT_INDEX_STRIDE);
+    for (uint32_t i = 0; i < n; i++) {
+        if (block[i].time >= time) {
+            return first + i;
+        }
+    }
+    return min(first + AUDIT_INDEX_STRIDE, records);
+}
+
+bool AuditLog::exportCsv(uint32_t day, const char *csvPath) {
+    if (!statistics.ready) {
+        return false;
+    }
+    SdReader reader;
+    SdWriter writer;
+    if (!reader.open(*fs, path(day, ".dat").c_str()) || !writer.open(*fs, csvPath)) {
+        return false;
+    }
+    static const char HEADER[] = "sequence,time,mode,value,low,high,result,operator1,operator2,printed\r\n";
+    writer.write((const uint8_t *)HEADER, sizeof(HEADER) - 1);
+
+    AuditRecord record;
+    while (reader.read((uint8_t *)&record, sizeof(record)) == sizeof(record)) {
+        if (record.magic != AUDIT_MAGIC) {
+            continue; // เศษจากไฟดับ (ดู append)
+        }
+        char time[20];
+        char line[128];
+        formatTime(record.time, time, sizeof(time));
+        int length = snprintf(line, sizeof(line), "%lu,%s,%s,%.2f,%.2f,%.2f,%s,%ld,%ld,%d\r\n", (unsigned long)record.sequence, time,
+                              record.mode == 0 ? "gram" : "pcs", record.value, record.low, record.high, record.pass ? "PASS" : "FAIL",
+                              (long)record.operator1, (long)record.operator2, record.printed);
+        writer.write((const uint8_t *)line, length);
+    }
+    reader.close();
+    return writer.close();
+}
+
+bool AuditLog::benchmark(uint32_t lookups, AuditBenchmark &result) {
+    memset(&result, 0, sizeof(result));
+    uint32_t *list = (uint32_t *)allocate(AUDIT_DAYS_MAX * sizeof(uint32_t));
+    if (list == NULL) {
+        return false;
+    }
+    uint32_t start = micros();
+    result.days = days(list, AUDIT_DAYS_MAX);
+    result.listUs = micros() - start;
+    for (uint16_t i = 0; i < result.days; i++) {
+        result.records += count(list[i]);
+    }
+
+    // สุ่มวันและเวลา แล้วอ่าน 1 หน้าจากตำแหน่งที่ค้นได้ (เหมือนเลือกชั่วโมงในหน้าตั้งค่า)
+    uint32_t seed = 12345;
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < lookups && result.days > 0; i++) {
+        seed = seed * 1664525 + 1013904223;
+        uint32_t day = list[(seed >> 8) % result.days];
+        seed = seed * 1664525 + 1013904223;
+        uint32_t time = timeOf(day) + (seed >> 8) % SECONDS_PER_DAY;
+        AuditRecord page[AUDIT_PAGE_SIZE];
+        start = micros();
+        read(day, find(day, time), page, AUDIT_PAGE_SIZE);
+        uint32_t elapsed = micros() - start;
+        total += elapsed;
+        result.maxUs = max(result.maxUs, elapsed);
+        result.lookups++;
+    }
+    result.averageUs = result.lookups > 0 ? total / result.lookups : 0;
+    free(list);
+    return result.lookups > 0;
+}
@@ -0,0 +1,85 @@
+#ifndef AUDIT_LOG_H
+#define AUDIT_LOG_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+#define AUDIT_DIR "/audit"
+#define AUDIT_INDEX_STRIDE 64 // 1 entry ใน .idx ต่อ record เท่านี้ (ค้นเวลาแล้วอ่านต่อไม่เกิน 64 record = 2 KB)
+#define AUDIT_INDEX_MAX 4096  // entry สูงสุดที่ find() ใช้ต่อวัน (262144 record/วัน, 16 KB ใน PSRAM)
+#define AUDIT_PAGE_SIZE 8     // record ต่อหน้าในหน้าประวัติ (และที่ benchmark อ่านต่อครั้ง)
+#define AUDIT_DAYS_MAX 400    // วันสูงสุดที่ benchmark สุ่มเลือก
+#define AUDIT_MAGIC 0xA5
+
+// ผลชั่ง/นับ 1 ครั้งใน log บน SD (32 byte คงที่ ไม่คร่อม sector: record ที่ n อยู่ที่ byte n * 32)
+struct AuditRecord {
+    uint32_t time;     // unix time ตาม RTC (เวลาท้องถิ่น)
+    uint32_t sequence; // เลขลำดับตลอดอายุการ์ด เลขขาด = มี record หาย
+    float value;       // MODE_GRAM: น้ำหนัก, MODE_PCS: จำนวนชิ้น
+    float low;         // MODE_GRAM: น้ำหนักต่ำสุด, MODE_PCS: จำนวนที่ตั้งไว้
+    float high;        // MODE_GRAM: น้ำหนักสูงสุด, MODE_PCS: จำนวนที่ตั้งไว้
+    int32_t operator1;
+    int32_t operator2;
+    uint8_t mode; // MODE_GRAM / MODE_PCS
+    bool pass;
+    bool printed;
+    uint8_t magic; // AUDIT_MAGIC (append เติมให้) เศษ record จากไฟดับเป็น 0
+};
+
+struct AuditStats {
+    bool ready;        // การ์ด mount อยู่และอ่านเลขลำดับล่าสุดแล้ว
+    uint32_t sequence; // เลขลำดับของ record ถัดไป
+    uint32_t appended;
+    uint32_t dropped; // ไม่มีการ์ด/เขียนไม่สำเร็จ
+};
+
+struct AuditBenchmark {
+    uint16_t days;
+    uint32_t records;
+    uint32_t lookups;
+    uint32_t listUs; // อ่านรายชื่อวันทั้งหมด
+    uint32_t averageUs;
+    uint32_t maxUs; // find() + read() 1 หน้า
+};
+
+// log ผลชั่งแบบต่อท้ายอย่างเดียวบน SD card แยกไฟล์รายวัน /audit/YYYYMMDD.dat
+// record ขนาดคงที่: จำนวน record = ขนาดไฟล์ / 32, อ่านหน้าใดก็ได้ด้วย seek ครั้งเดียว
+// /audit/YYYYMMDD.idx เก็บเวลาของ record ที่ 0, 64, 128, ... ค้นเวลาด้วย binary search แล้วอ่าน data ไม่เกิน 1 ช่วง
+// (record ในวันเดียวกันเรียงตามเวลาที่เขียน ถ้าตั้งนาฬิกาถอยหลังผลค้นเวลาจะคลาดได้ แต่ข้อมูลครบ)
+// ไม่มีการ lock: เรียกจาก task เดียว (loop) ตรวจว่าการ์ด mount อยู่ก่อน begin()
+class AuditLog {
+  public:
+    AuditLog();
+    bool begin(fs::FS &fs); // หลัง mount การ์ด: สร้างโฟลเดอร์ อ่านเลขลำดับต่อจาก record ล่าสุด
+    void end();             // หลังถอดการ์ด
+    bool append(AuditRecord &record); // เติม sequence ให้
+
+    // วันที่มี log เป็น YYYYMMDD เรียงใหม่ไปเก่า
+    uint16_t days(uint32_t *days, uint16_t max);
+    uint32_t count(uint32_t day);
+    uint32_t read(uint32_t day, uint32_t first, AuditRecord *records, uint32_t max); // รวมเศษจากไฟดับ (magic != AUDIT_MAGIC)
+    // ลำดับของ record แรกในวันที่เวลา >= time (= count() ถ้าไม่มี)
+    uint32_t find(uint32_t day, uint32_t time);
+    bool exportCsv(uint32_t day, const char *csvPath);
+
+    bool benchmark(uint32_t lookups, AuditBenchmark &result);
+
+    AuditStats stats() const { return statistics; }
+
+    static uint32_t dayOf(uint32_t time); // unix time -> YYYYMMDD
+    static uint32_t timeOf(uint32_t day); // YYYYMMDD -> unix time ตอน 00:00:00
+    static void formatTime(uint32_t time, char *text, size_t size); // "YYYY-MM-DD hh:mm:ss"
+
+  private:
+    fs::FS *fs;
+    AuditStats statistics;
+    uint32_t *index;     // .idx ของวันที่ค้นล่าสุด (PSRAM)
+    AuditRecord *block;  // record 1 ช่วงของ index ที่ find() อ่านมาไล่หา
+    uint32_t indexDay;
+    uint32_t indexCount; // จำนวน record ของวันนั้นตอนอ่าน .idx (เพิ่มขึ้น = อ่านใหม่)
+
+    bool loadIndex(uint32_t day, uint32_t records);
+    static String path(uint32_t day, const char *extension);
+};
+
+#endif // AUDIT_LOG_H
@@ -0,0 +1,298 @@
+#include "BalanceProtocol.h"
+
+namespace {
+
+// ตัวอ่านข้อมูลทีละตัวอักษร (ไม่ copy ข้อความ)
+struct Cursor {
+    const char *p;
+    const char *end;
+
+    bool done() const { return p >= end; }
+    char peek() const { return p < end ? *p : '\0'; }
+    void skipSpaces() {
+        while (p < end && *p == ' ') {
+            p++;
+        }
+    }
+    bool skip(char c) {
+        skipSpaces();
+        if (peek() == c) {
+            p++;
+            return true;
+        }
+        return false;
+    }
+    // อ่านตัวอักษรติดกันเป็น token เช่น "ST", "kg" (ไม่รวมช่องว่างและ ',')
+    size_t token(const char **start) {
+        skipSpaces();
+        *start = p;
+        while (p < end && *p != ' ' && *p != ',' && *p != ';' && !isDigit(*p) && *p != '+' && *p != '-' && *p != '.') {
+            p++;
+        }
+        return p - *start;
+    }
+};
+
+bool tokenIs(const char *token, size_t length, const char *text) {
+    size_t i = 0;
+    for (; i < length && text[i]; i++) {
+        if (tolower(token[i]) != tolower(text[i])) {
+            return false;
+        }
+    }
+    return i == length && text[i] == '\0';
+}
+
+// [sign] [spaces] digits [. digits]
+bool parseNumber(Cursor &c, float &value) {
+    c.skipSpaces();
+    bool negative = false;
+    if (c.peek() == '+' || c.peek() == '-') {
+        negative = c.peek() == '-';
+        c.p++;
+        c.skipSpaces();
+    }
+
+    uint32_t mantissa = 0;
+    uint32_t scale = 1;
+    int digits = 0;
+    bool fraction = false;
+    while (!c.done()) {
+        char ch = c.peek();
+        if (isDigit(ch)) {
+            if (mantissa < 100000000) {
+                mantissa = mantissa * 10 + (ch - '0');
+                if (fraction) {
+                    scale *= 10;
+                }
+            }
+            digits++;
+        } else if (ch == '.' && !fraction) {
+            fraction = true;
+        } else {
+            break;
+        }
+        c.p++;
+    }
+    if (digits == 0) {
+        return false;
+    }
+    value = (float)mantissa / scale;
+    if (negative) {
+        value = -value;
+    }
+    return true;
+}
+
+BalanceUnit parseUnit(Cursor &c) {
+    const char *token;
+    size_t length = c.token(&token);
+    if (length == 0) {
+        return UNIT_NONE;
+    }
+    if (tokenIs(token, length, "g")) {
+        return UNIT_G;
+    }
+    if (tokenIs(token, length, "kg")) {
+        return UNIT_KG;
+    }
+    if (tokenIs(token, length, "mg")) {
+        return UNIT_MG;
+    }
+    if (tokenIs(token, length, "pcs") || tokenIs(token, length, "pc") || tokenIs(token, length, "pce")) {
+        return UNIT_PCS;
+    }
+    return UNIT_OTHER;
+}
+
+void clearReading(BalanceReading &reading) {
+    reading.value = 0;
+    reading.unit = UNIT_NONE;
+    reading.stable = false;
+    reading.overload = false;
+}
+
+const GenericProtocol genericProtocol;
+const SicsProtocol sicsProtocol;
+const AndProtocol andProtocol;
+const SbiProtocol sbiProtocol;
+
+} // namespace
+
+const BalanceProtocol &BalanceProtocol::get(int type) {
+    switch (type) {
+    case BALANCE_SICS:
+        return sicsProtocol;
+    case BALANCE_AND:
+        return andProtocol;
+    case BALANCE_SBI:
+        return sbiProtocol;
+    default:
+        return genericProtocol;
+    }
+}
+
+const char *BalanceProtocol::options() { return "Generic / CSV\nMettler SICS\nA&D\nSartorius SBI"; }
+
+float BalanceProtocol::toGram(const BalanceReading &reading) {
+    switch (reading.unit) {
+    case UNIT_KG:
+        return reading.value * 1000.0f;
+    case UNIT_MG:
+        return reading.value / 1000.0f;
+    default:
+        return reading.value;
+    }
+}
+
+const char *BalanceProtocol::unitName(BalanceUnit unit) {
+    switch (unit) {
+    case UNIT_G:
+        return "g";
+    case UNIT_KG:
+        return "kg";
+    case UNIT_MG:
+        return "mg";
+    case UNIT_PCS:
+        return "pcs";
+    case UNIT_OTHER:
+        return "?";
+    default:
+        return "";
+    }
+}
+
+// [สถานะ,] ค่า [หน่วย] [,สถานะ]
+// สถานะ: ST/S = นิ่ง, US/D = ไม่นิ่ง, OL = เกินพิกัด ถ้าไม่มีสถานะถือว่านิ่ง (เครื่องชั่งที่ส่งเฉพาะค่านิ่ง)
+bool GenericProtocol::parse(const char *line, size_t length, BalanceReading &reading) const {
+    clearReading(reading);
+    Cursor c = {line, line + length};
+    bool hasValue = false;
+    reading.stable = true;
+
+    while (!c.done()) {
+        c.skipSpaces();
+        if (c.peek() == ',' || c.peek() == ';') {
+            c.p++;
+            continue;
+        }
+
+        const char *token;
+        size_t n = c.token(&token);
+        if (n > 0) {
+            if (tokenIs(token, n, "ST") || tokenIs(token, n, "S")) {
+                reading.stable = true;
+            } else if (tokenIs(token, n, "US") || tokenIs(token, n, "D")) {
+                reading.stable = false;
+            } else if (tokenIs(token, n, "OL")) {
+                reading.overload = true;
+            } else if (hasValue && reading.unit == UNIT_NONE) {
+                Cursor unit = {token, token + n};
+                reading.unit = parseUnit(unit);
+            } else {
+                return false;
+            }
+            continue;
+        }
+
+        if (hasValue || !parseNumber(c, reading.value)) {
+            return false;
+        }
+        hasValue = true;
+    }
+
+    if (reading.overload) {
+        reading.stable = false;
+        return true;
+    }
+    return hasValue;
+}
+
+// "S S     12.345 g" (S = นิ่ง, D = ไม่นิ่ง, + / - = เกิน/ต่ำกว่าพิกัด, I = เครื่องไม่ว่าง)
+bool SicsProtocol::parse(const char *line, size_t length, BalanceReading &reading) const {
+    clearReading(reading);
+    Cursor c = {line, line + length};
+    const char *token;
+    size_t n = c.token(&token);
+    if (!tokenIs(token, n, "S")) {
+        return false;
+    }
+
+    c.skipSpaces();
+    char status = c.peek();
+    c.p++;
+    if (status == '+' || status == '-') {
+        reading.overload = true;
+        return true;
+    }
+    if (status != 'S' && status != 'D') {
+        return false;
+    }
+    reading.stable = status == 'S';
+
+    if (!parseNumber(c, reading.value)) {
+        return false;
+    }
+    reading.unit = parseUnit(c);
+    return true;
+}
+
+// "ST,+00012.34  g" (ST = นิ่ง, US = ไม่นิ่ง, QT = จำนวนชิ้นนิ่ง, OL = เกินพิกัด)
+bool AndProtocol::parse(const char *line, size_t length, BalanceReading &reading) const {
+    clearReading(reading);
+    Cursor c = {line, line + length};
+    const char *header;
+    size_t n = c.token(&header);
+    if (n != 2 || !c.skip(',')) {
+        return false;
+    }
+
+    if (tokenIs(header, n, "OL")) {
+        reading.overload = true;
+        return true;
+    }
+    if (tokenIs(header, n, "ST") || tokenIs(header, n, "QT")) {
+        reading.stable = true;
+    } else if (!tokenIs(header, n, "US")) {
+        return false;
+    }
+
+    if (!parseNumber(c, reading.value)) {
+        return false;
+    }
+    reading.unit = parseUnit(c);
+    if (tokenIs(header, n, "QT") && reading.unit == UNIT_NONE) {
+        reading.unit = UNIT_PCS;
+    }
+    return true;
+}
+
+// 16 ตัว "+     12.345 g  " หรือ 22 ตัวที่มีรหัสนำหน้า "N     +     12.345 g  "
+// SBI ไม่มีสถานะแยก: ค่านิ่งจะมีหน่วยต่อท้าย, ค่าไม่นิ่งหน่วยเป็นช่องว่าง
+bool SbiProtocol::parse(const char *line, size_t length, BalanceReading &reading) const {
+    clearReading(reading);
+    Cursor c = {line, line + length};
+
+    const char *id;
+    size_t n = c.token(&id);
+    if (n > 0) {
+        if (tokenIs(id, n, "High") || tokenIs(id, n, "Low") || tokenIs(id, n, "H") || tokenIs(id, n, "L")) {
+            reading.overload = true;
+            return true;
+        }
+        // รหัสนำหน้า เช่น N, G, T, Qnt
+        if (tokenIs(id, n, "Qnt")) {
+            reading.unit = UNIT_PCS;
+        }
+    }
+
+    if (!parseNumber(c, reading.value)) {
+        return false;
+    }
+    BalanceUnit unit = parseUnit(c);
+    reading.stable = unit != UNIT_NONE;
+    if (unit != UNIT_NONE) {
+        reading.unit = unit;
+    }
+    return true;
+}
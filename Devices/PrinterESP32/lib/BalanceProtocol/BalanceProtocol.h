@@ -0,0 +1,62 @@
+#ifndef BALANCE_PROTOCOL_H
+#define BALANCE_PROTOCOL_H
+
+#include <Arduino.h>
+
+// รูปแบบข้อมูลของเครื่องชั่ง (ค่าเก็บใน Preferences ห้ามเปลี่ยนลำดับ)
+enum BalanceProtocolType {
+    BALANCE_GENERIC = 0, // "+ 12.50 g" หรือ CSV เช่น "ST,+12.50,g"
+    BALANCE_SICS = 1,    // Mettler Toledo MT-SICS: "S S      12.50 g"
+    BALANCE_AND = 2,     // A&D: "ST,+00012.50  g"
+    BALANCE_SBI = 3,     // Sartorius SBI: "N     +     12.50 g  "
+    BALANCE_PROTOCOL_COUNT
+};
+
+enum BalanceUnit { UNIT_NONE, UNIT_G, UNIT_KG, UNIT_MG, UNIT_PCS, UNIT_OTHER };
+
+struct BalanceReading {
+    float value;      // มีเครื่องหมาย (ติดลบได้เมื่อ tare)
+    BalanceUnit unit; // UNIT_NONE ถ้าไม่มีหน่วยมากับข้อมูล
+    bool stable;      // ค่านิ่งแล้ว
+    bool overload;    // เกินพิกัด / ต่ำกว่าพิกัด (ไม่มีค่า value)
+};
+
+// driver แปลงข้อมูล 1 บรรทัดจากเครื่องชั่ง อ่านรอบเดียว ไม่จอง memory
+// คืนค่า false ถ้าไม่ใช่ข้อมูลน้ำหนัก (เช่น คำตอบของคำสั่งอื่น หรือข้อมูลเสีย)
+class BalanceProtocol {
+  public:
+    virtual const char *name() const = 0;
+    virtual bool parse(const char *line, size_t length, BalanceReading &reading) const = 0;
+
+    static const BalanceProtocol &get(int type);
+    static const char *options(); // รายการสำหรับ lv_dropdown เรียงตาม BalanceProtocolType
+
+    static float toGram(const BalanceReading &reading);
+    static const char *unitName(BalanceUnit unit);
+};
+
+class GenericProtocol : public BalanceProtocol {
+  public:
+    const char *name() const override { return "Generic / CSV"; }
+    bool parse(const char *line, size_t length, BalanceReading &reading) const override;
+};
+
+class SicsProtocol : public BalanceProtocol {
+  public:
+    const char *name() const override { return "Mettler SICS"; }
+    bool parse(const char *line, size_t length, BalanceReading &reading) const override;
+};
+
+class AndProtocol : public BalanceProtocol {
+  public:
+    const char *name() const override { return "A&D"; }
+    bool parse(const char *line, size_t length, BalanceReading &reading) const override;
+};
+
+class SbiProtocol : public BalanceProtocol {
+  public:
+    const char *name() const override { return "Sartorius SBI"; }
+    bool parse(const char *line, size_t length, BalanceReading &reading) const override;
+};
+
+#endif // BALANCE_PROTOCOL_H
@@ -0,0 +1,63 @@
+#include "BatchUploader.h"
+
+BatchUploader::BatchUploader() {
+    memset(&statistics, 0, sizeof(statistics));
+    // server ในโรงงานใช้ cert self-signed ไม่ตรวจ CA (เหมือน http.begin(url) เดิม)
+    secureClient.setInsecure();
+    http.setReuse(true);
+    http.setTimeout(UPLOAD_TIMEOUT);
+}
+
+void BatchUploader::setServer(const String &baseUrl, const String &token) {
+    if (baseUrl == this->baseUrl && token == this->token) {
+        return;
+    }
+    close();
+    this->baseUrl = baseUrl;
+    this->token = token;
+}
+
+void BatchUploader::close() {
+    plainClient.stop();
+    secureClient.stop();
+}
+
+WiFiClient &BatchUploader::client() { return baseUrl.startsWith("https://") ? (WiFiClient &)secureClient : plainClient; }
+
+int BatchUploader::send(const String &url, const String &body) {
+    WiFiClient &connection = client();
+    if (!connection.connected()) {
+        statistics.connects++;
+    }
+    http.begin(connection, url);
+    http.addHeader("Content-Type", "application/json");
+    http.addHeader("Authorization", String("Bearer ") + token);
+    int code = http.POST(body);
+    lastResponse = code > 0 ? http.getString() : http.errorToString(code);
+    http.end(); // setReuse(true): ไม่ปิด connection ถ้า server ตอบ keep-alive
+    return code;
+}
+
+int BatchUploader::post(const char *path, const String &body, uint16_t records) {
+    String url = baseUrl + path;
+    uint32_t start = millis();
+    bool reused = client().connected();
+    int code = send(url, body);
+    // server ปิด connection ที่ค้างไว้ระหว่างรอ ต่อใหม่แล้วส่งอีกครั้ง เฉพาะที่ request ยังไม่ออกไป (ต่อไม่ได้/ส่ง header ไม่ได้)
+    // read timeout/connection หลุดหลังส่งแล้ว server อาจบันทึกไปแล้ว ส่งซ้ำจะได้แถวซ้ำ ให้ outbox ส่งใหม่ตามรอบแทน
+    if (reused && (code == HTTPC_ERROR_CONNECTION_REFUSED || code == HTTPC_ERROR_SEND_HEADER_FAILED)) {
+        close();
+        code = send(url, body);
+    }
+    statistics.postMs += millis() - start;
+    statistics.requests++;
+    if (code == HTTP_CODE_OK || code == HTTP_CODE_CREATED) {
+        statistics.records += records;
+    } else {
+        statistics.failures++;
+        if (code < 0) {
+            close();
+        }
+    }
+    return code;
+}
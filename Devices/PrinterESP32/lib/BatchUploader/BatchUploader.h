@@ -0,0 +1,46 @@
+#ifndef BATCH_UPLOADER_H
+#define BATCH_UPLOADER_H
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+
+#define UPLOAD_TIMEOUT 5000 // ms ต่อ request
+
+// สถิติการส่ง ใช้เทียบ records/s และเวลาต่อ record
+struct UploadStats {
+    uint32_t requests;
+    uint32_t records;
+    uint32_t failures; // request ที่ไม่ได้ 2xx (รวม transport error)
+    uint32_t connects; // จำนวนครั้งที่ต้องต่อ TCP/TLS ใหม่
+    uint32_t postMs;   // เวลารวมที่ใช้ใน POST (รวม handshake)
+};
+
+// POST ไป server ผ่าน connection เดียวที่เปิดค้างไว้ (HTTP/1.1 keep-alive)
+// ใบถัดไปไม่ต้อง handshake TCP/TLS ใหม่ จนกว่า server จะปิด connection หรือเปลี่ยน server
+// ถ้า connection ที่ค้างไว้ถูกปิดไปแล้ว (request ยังไม่ออก) จะต่อใหม่แล้วส่งซ้ำให้ 1 ครั้ง
+// ไม่มีการ lock: เรียกจาก task เดียว (processQueueTask)
+class BatchUploader {
+  public:
+    BatchUploader();
+    void setServer(const String &baseUrl, const String &token); // เปลี่ยนแล้วปิด connection เดิม
+    int post(const char *path, const String &body, uint16_t records);
+    const String &response() const { return lastResponse; }
+    void close();
+
+    const UploadStats &stats() const { return statistics; }
+
+  private:
+    HTTPClient http;
+    WiFiClient plainClient;
+    WiFiClientSecure secureClient;
+    String baseUrl;
+    String token;
+    String lastResponse;
+    UploadStats statistics;
+
+    WiFiClient &client();
+    int send(const String &url, const String &body);
+};
+
+#endif // BATCH_UPLOADER_H
@@ -1,17 +1,18 @@
 #include "Printer.h"
 
-Printer::Printer() : printer(Serial2) {}
+Printer::Printer() : printer(&Serial1) {}
 
-void Printer::begin() {
+void Printer::begin(Print &output) {
+    this->printer = &output;
     this->reset();
+    delay(100); // หน่วงเวลา 100 มิลลิวินาที
 }
 
-void Printer::write(u_int8_t command) { this->printer.write(command); }
+void Printer::write(u_int8_t command) { this->printer->write(command); }
 
 void Printer::reset() {
-    this->printer.write(ESC);
-    this->printer.write('@');
-    delay(100); // หน่วงเวลา 100 มิลลิวินาที
+    this->printer->write(ESC);
+    this->printer->write('@');
 }
 
 // ขนาดตัวอักษร
@@ -36,12 +37,12 @@ void Printer::setBold(SetBoldStyle style) {
 }
 
 void Printer::print(const String &text) {
-    this->printer.print(text); // ส่งข้อความไปยังเครื่องพิมพ์
+    this->printer->print(text); // ส่งข้อความไปยังเครื่องพิมพ์
 }
 
 void Printer::println(const String &text) {
-    this->printer.print(text); // ส่งข้อความ
-    this->printer.write('\n'); // ส่ง newline เพื่อขึ้นบรรทัดใหม่
+    this->printer->print(text); // ส่งข้อความ
+    this->printer->write('\n'); // ส่ง newline เพื่อขึ้นบรรทัดใหม่
 }
 
 void Printer::feed(uint8_t n) {
@@ -67,19 +68,19 @@ void Printer::printLogo() {
 
 void Printer::printAndCut(const String &text) {
     // # เน้น (เลือกขนาดตัวอักษรปกติ)
-    this->printer.write(ESC);
-    this->printer.write('M');
-    this->printer.write(0x00);
+    this->printer->write(ESC);
+    this->printer->write('M');
+    this->printer->write(0x00);
 
-    this->printer.print(text); // ส่งข้อความ
+    this->printer->print(text); // ส่งข้อความ
     this->feed(3); // เลื่อนกระดาษขึ้น 3 บรรทัดเพื่อให้มีพื้นที่ก่อนตัด
     this->cut(); // ตัดกระดาษ
 }
 
 void Printer::setAlign(TextAlign align) {
-    this->printer.write(ESC);
-    this->printer.write('a');
-    this->printer.write(align);
+    this->printer->write(ESC);
+    this->printer->write('a');
+    this->printer->write(align);
 }
 
-void Printer::sendCommand(PrinterCommands command) { this->printer.write(command); }
+void Printer::sendCommand(PrinterCommands command) { this->printer->write(command); }
@@ -36,7 +36,7 @@ enum HighlightText {
 class Printer {
   public:
     Printer();
-    void begin();
+    void begin(Print &output);
     void write(u_int8_t command);
     void reset();
     void setFontSize(SetFontSize size);
@@ -51,7 +51,7 @@ class Printer {
     void setAlign(TextAlign align = ALIGN_CENTER);
 
   private:
-    HardwareSerial &printer;
+    Print *printer;
     long baudRate;
     uint32_t config;
     int8_t rxPin;
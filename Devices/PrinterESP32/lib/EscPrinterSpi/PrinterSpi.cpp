@@ -1,22 +1,149 @@
 #include "PrinterSpi.h"
 #include <SPI.h>
+#include <esp_heap_caps.h>
 
-PrinterSpi::PrinterSpi() {}
+PrinterSpi::PrinterSpi() : csPin(-1), device(NULL), buffers{NULL, NULL}, inFlight{false, false}, active(0), length(0) {}
 
-void PrinterSpi::begin(int csPin) {
+bool PrinterSpi::begin(int csPin, int sckPin, int mosiPin, const SPISettings &settings) {
     this->csPin = csPin;
+    // PSRAM ใช้กับ DMA ของ SPI ไม่ได้ ต้องจองจาก RAM ภายใน
+    for (int i = 0; i < 2; i++) {
+        buffers[i] = (uint8_t *)heap_caps_malloc(PRINTER_SPI_BUFFER_SIZE, MALLOC_CAP_DMA);
+        if (buffers[i] == NULL) {
+            Serial.println("(PrinterSpi)=> Allocate DMA buffer failed");
+            end();
+            return false;
+        }
+    }
+
+    spi_bus_config_t bus = {};
+    bus.mosi_io_num = mosiPin;
+    bus.miso_io_num = -1; // เครื่องพิมพ์ไม่ตอบกลับทาง SPI
+    bus.sclk_io_num = sckPin;
+    bus.quadwp_io_num = -1;
+    bus.quadhd_io_num = -1;
+    bus.max_transfer_sz = PRINTER_SPI_BUFFER_SIZE;
+    esp_err_t err = spi_bus_initialize(PRINTER_SPI_HOST, &bus, SPI_DMA_CH_AUTO);
+    if (err != ESP_OK) {
+        Serial.printf("(PrinterSpi)=> SPI bus init failed (%s)\n", esp_err_to_name(err));
+        end();
+        return false;
+    }
+    if (!addDevice(settings)) {
+        spi_bus_free(PRINTER_SPI_HOST);
+        end();
+        return false;
+    }
     this->reset();
+    return true;
 }
 
-void PrinterSpi::write(uint8_t command) {
-    digitalWrite(this->csPin , LOW); // เลือกเครื่องพิมพ์ (Slave)
-    SPI.transfer(command); // ส่งคำสั่งผ่าน SPI
-    digitalWrite(this->csPin , HIGH); // ปล่อยเครื่องพิมพ์
+void PrinterSpi::end() {
+    if (device != NULL) {
+        flush();
+        wait();
+        spi_bus_remove_device(device);
+        spi_bus_free(PRINTER_SPI_HOST);
+        device = NULL;
+    }
+    for (int i = 0; i < 2; i++) {
+        heap_caps_free(buffers[i]);
+        buffers[i] = NULL;
+    }
+    length = 0;
+}
+
+// ค่าเดียวกับ SPI.beginTransaction() แต่ตั้งครั้งเดียวตอนเพิ่ม device ไม่ต้องตั้งใหม่ทุก transaction
+bool PrinterSpi::addDevice(const SPISettings &settings) {
+    spi_device_interface_config_t config = {};
+    config.clock_speed_hz = settings._clock;
+    config.mode = settings._dataMode;
+    config.spics_io_num = csPin; // driver คุม CS: ลงครั้งเดียวตลอด transaction
+    config.queue_size = 2;
+    config.flags = settings._bitOrder == LSBFIRST ? SPI_DEVICE_BIT_LSBFIRST : 0;
+    esp_err_t err = spi_bus_add_device(PRINTER_SPI_HOST, &config, &device);
+    if (err != ESP_OK) {
+        Serial.printf("(PrinterSpi)=> Add device failed (%s)\n", esp_err_to_name(err));
+        device = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool PrinterSpi::setSettings(const SPISettings &settings) {
+    if (device == NULL) {
+        return false;
+    }
+    flush();
+    wait();
+    spi_bus_remove_device(device);
+    return addDevice(settings);
+}
+
+size_t PrinterSpi::write(uint8_t command) { return write(&command, 1); }
+
+size_t PrinterSpi::write(const uint8_t *buffer, size_t size) {
+    if (device == NULL) {
+        return 0;
+    }
+    size_t written = 0;
+    while (written < size) {
+        size_t n = min(size - written, (size_t)PRINTER_SPI_BUFFER_SIZE - length);
+        memcpy(buffers[active] + length, buffer + written, n);
+        length += n;
+        written += n;
+        if (length == PRINTER_SPI_BUFFER_SIZE) {
+            flush();
+        }
+    }
+    return written;
+}
+
+void PrinterSpi::flush() {
+    if (device == NULL || length == 0) {
+        return;
+    }
+    spi_transaction_t &transaction = transactions[active];
+    memset(&transaction, 0, sizeof(transaction));
+    transaction.length = length * 8; // หน่วยเป็น bit
+    transaction.tx_buffer = buffers[active];
+    esp_err_t err = spi_device_queue_trans(device, &transaction, portMAX_DELAY);
+    if (err != ESP_OK) {
+        Serial.printf("(PrinterSpi)=> Queue %u bytes failed (%s)\n", length, esp_err_to_name(err));
+        length = 0;
+        return;
+    }
+    inFlight[active] = true;
+
+    // สลับไปเขียนอีกชุด ถ้าชุดนั้นยังส่งไม่จบต้องรอก่อน
+    active ^= 1;
+    length = 0;
+    if (inFlight[active]) {
+        finish(active);
+    }
+}
+
+// transaction จบตามลำดับที่ queue ดึงผลออกจนถึงชุดที่ต้องการ
+void PrinterSpi::finish(uint8_t index) {
+    while (inFlight[index]) {
+        spi_transaction_t *done;
+        if (spi_device_get_trans_result(device, &done, portMAX_DELAY) != ESP_OK) {
+            return;
+        }
+        inFlight[done == &transactions[0] ? 0 : 1] = false;
+    }
+}
+
+void PrinterSpi::wait() {
+    finish(active ^ 1);
+    finish(active);
 }
 
 void PrinterSpi::reset() {
     this->write(ESC);
     this->write('@');
+    this->flush();
+    this->wait();
     delay(100); // หน่วงเวลา 100 มิลลิวินาที
 }
 
@@ -39,11 +166,7 @@ void PrinterSpi::setBold(SetBoldStyle style) {
 }
 
 void PrinterSpi::print(const String &text) {
-    digitalWrite(this->csPin , LOW); // เลือกเครื่องพิมพ์ (Slave)
-    for (size_t i = 0; i < text.length(); i++) {
-        SPI.transfer(text[i]); // ส่งแต่ละตัวอักษรผ่าน SPI
-    }
-    digitalWrite(this->csPin , HIGH); // ปล่อยเครื่องพิมพ์
+    this->write((const uint8_t *)text.c_str(), text.length()); // copy ลง buffer ทั้งก้อน
 }
 
 void PrinterSpi::println(const String &text) {
@@ -62,6 +185,7 @@ void PrinterSpi::cut() {
     this->write('V');
     this->write(65);
     this->write(42);
+    this->flush(); // จบใบแล้ว ส่งที่ค้างทั้งหมด
 }
 
 void PrinterSpi::printLogo() {
@@ -3,6 +3,11 @@
 
 #include <Arduino.h>
 #include <SPI.h> // รวมไลบรารี SPI
+#include <driver/spi_master.h>
+
+#define PRINTER_SPI_HOST SPI3_HOST     // bus ของเครื่องพิมพ์ (แยกจาก SPI ของ SD card)
+#define PRINTER_SPI_BUFFER_SIZE 4096   // byte ต่อ 1 transaction (จอง 2 ชุดใน RAM ที่ DMA เข้าถึงได้)
+#define PRINTER_SPI_CLOCK 1000000      // Hz ค่าเริ่มต้น ถ้าไม่ส่ง SPISettings มา
 
 enum PrinterCommands {
   LF = 0x0A,
@@ -41,15 +46,25 @@ enum HighlightText {
       0x30, // เน้น (ตัวอักษรขยายทั้งแนวตั้งและแนวนอน)
 };
 
-class PrinterSpi {
+// คำสั่งทั้งหมดเขียนลง buffer ก่อน แล้วส่งทีละก้อนด้วย DMA (CS ลง/ขึ้นครั้งเดียวต่อ flush)
+// ใช้ buffer สลับ 2 ชุด: ระหว่าง DMA ส่งชุดหนึ่ง เขียนคำสั่งถัดไปลงอีกชุดได้เลย
+// ข้อมูลถึงเครื่องพิมพ์เมื่อ buffer เต็ม, flush(), cut() หรือ reset() เท่านั้น
+class PrinterSpi : public Print {
 public:
   PrinterSpi();
-  void begin(int csPin);
-  void write(uint8_t command);
+  bool begin(int csPin, int sckPin, int mosiPin,
+             const SPISettings &settings = SPISettings(PRINTER_SPI_CLOCK, MSBFIRST, SPI_MODE0));
+  void end();
+  bool setSettings(const SPISettings &settings); // เปลี่ยน clock/bit order/mode (รอข้อมูลค้างส่งจบก่อน)
+  size_t write(uint8_t command) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  void flush();   // เริ่มส่งข้อมูลใน buffer (ไม่รอ DMA จบ)
+  void wait();    // รอทุก transaction ส่งจบ
   void reset();
   void setFontSize(SetFontSize size);
   void highlight(HighlightText style);
   void setBold(SetBoldStyle style);
+  using Print::print;
   void print(const String &text);
   void println(const String &text);
   void feed(uint8_t n);
@@ -60,7 +75,15 @@ public:
 
 private:
   int csPin;
+  spi_device_handle_t device;
+  uint8_t *buffers[2];
+  spi_transaction_t transactions[2];
+  bool inFlight[2];
+  uint8_t active; // buffer ที่กำลังเขียน
+  size_t length;  // byte ใน buffer ที่กำลังเขียน
   void sendCommand(PrinterCommands command);
+  bool addDevice(const SPISettings &settings);
+  void finish(uint8_t index);
 };
 
 #endif // PRINTER_H
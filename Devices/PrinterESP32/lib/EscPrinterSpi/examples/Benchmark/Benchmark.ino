@@ -0,0 +1,83 @@
+// วัดความเร็ว (bytes/s) ของการส่งใบเสร็จผ่าน SPI
+// 1) แบบเดิม: CS ลง/ขึ้น และ SPI.transfer() ทีละ byte
+// 2) แบบใหม่: PrinterSpi เขียนลง buffer แล้วส่งด้วย DMA ครั้งละก้อน
+// ต่อ logic analyzer หรือเครื่องพิมพ์ที่ขา CS/SCK/MOSI แล้วดูผลทาง Serial
+#include <PrinterSpi.h>
+#include <SPI.h>
+
+#define CS_PIN 10
+#define SCK_PIN 12
+#define MOSI_PIN 11
+#define CLOCK 4000000
+#define ROUNDS 20
+
+PrinterSpi printer;
+String ticket;
+
+void legacyWrite(SPIClass &spi, uint8_t c) {
+    digitalWrite(CS_PIN, LOW);
+    spi.transfer(c);
+    digitalWrite(CS_PIN, HIGH);
+}
+
+// ใบเสร็จแบบเดียวกับที่ PrintSpooler ส่ง: คำสั่ง ESC สั้นๆ สลับกับข้อความ
+void buildTicket() {
+    for (int i = 0; i < 20; i++) {
+        ticket += "\x1b" "a\x01";
+        ticket += "\x1b!\x10";
+        ticket += "Weight      12.345 kg   PASS\n";
+        ticket += "\x1b!";
+        ticket += (char)0x00; // ต่อ string literal ที่มี \x00 ไม่ได้
+        ticket += "2026-10-19 10:00:00  OP-01  #" + String(i) + "\n";
+    }
+    ticket += "\x1b" "d\x03\x1dV\x41\x2a";
+}
+
+uint32_t benchLegacy() {
+    SPIClass spi(HSPI);
+    spi.begin(SCK_PIN, -1, MOSI_PIN, -1);
+    pinMode(CS_PIN, OUTPUT);
+    digitalWrite(CS_PIN, HIGH);
+    spi.beginTransaction(SPISettings(CLOCK, MSBFIRST, SPI_MODE0));
+    uint32_t start = micros();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (size_t i = 0; i < ticket.length(); i++) {
+            legacyWrite(spi, ticket[i]);
+        }
+    }
+    uint32_t elapsed = micros() - start;
+    spi.endTransaction();
+    spi.end();
+    return elapsed;
+}
+
+uint32_t benchDma() {
+    if (!printer.begin(CS_PIN, SCK_PIN, MOSI_PIN, SPISettings(CLOCK, MSBFIRST, SPI_MODE0))) {
+        return 0;
+    }
+    uint32_t start = micros();
+    for (int r = 0; r < ROUNDS; r++) {
+        printer.print(ticket);
+    }
+    printer.flush();
+    printer.wait();
+    uint32_t elapsed = micros() - start;
+    printer.end();
+    return elapsed;
+}
+
+void report(const char *name, uint32_t us) {
+    size_t bytes = ticket.length() * ROUNDS;
+    Serial.printf("%-8s %6u bytes %8u us %9.0f bytes/s\n", name, bytes, us, us > 0 ? bytes * 1e6 / us : 0.0);
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+    buildTicket();
+    Serial.printf("SPI clock %d Hz, wire limit %d bytes/s\n", CLOCK, CLOCK / 8);
+    report("per-byte", benchLegacy());
+    report("dma", benchDma());
+}
+
+void loop() {}
@@ -0,0 +1,111 @@
+#include "Code128.h"
+
+namespace {
+
+// ความกว้าง แท่ง/ช่องว่าง/แท่ง/ช่องว่าง/แท่ง/ช่องว่าง ของแต่ละค่า (รวม 11 module)
+const char PATTERNS[107][8] = {
+    "212222", "222122", "222221", "121223", "121322", "131222", "122213", "122312", "132212", "221213", "221312", "231212", "112232",
+    "122132", "122231", "113222", "123122", "123221", "223211", "221132", "221231", "213212", "223112", "312131", "311222", "321122",
+    "321221", "312212", "322112", "322211", "212123", "212321", "232121", "111323", "131123", "131321", "112313", "132113", "132311",
+    "211313", "231113", "231311", "112133", "112331", "132131", "113123", "113321", "133121", "313121", "211331", "231131", "213113",
+    "213311", "213131", "311123", "311321", "331121", "312113", "312311", "332111", "314111", "221411", "431111", "111224", "111422",
+    "121124", "121421", "141122", "141221", "112214", "112412", "122114", "122411", "142112", "142211", "241211", "221114", "413111",
+    "241112", "134111", "111242", "121142", "121241", "114212", "124112", "124211", "411212", "421112", "421211", "212141", "214121",
+    "412121", "111143", "111341", "131141", "114113", "114311", "411113", "411311", "113141", "114131", "311141", "411131", "211412",
+    "211214", "211232", "2331112",
+};
+
+enum Code128Value : uint8_t { CODE_C = 99, CODE_B = 100, START_B = 104, START_C = 105, STOP = 106 };
+
+size_t digitRun(const char *text) {
+    size_t n = 0;
+    while (isdigit((unsigned char)text[n])) {
+        n++;
+    }
+    return n;
+}
+
+} // namespace
+
+Code128::Code128() : count(0) {}
+
+bool Code128::add(uint8_t value) {
+    if (count >= CODE128_MAX_SYMBOLS - 1) {
+        return false;
+    }
+    values[count++] = value;
+    return true;
+}
+
+bool Code128::encode(const char *text) {
+    count = 0;
+    size_t length = strlen(text);
+    if (length == 0) {
+        return false;
+    }
+
+    // code C (ตัวเลข 2 หลักต่อ symbol) คุ้มเมื่อมีตัวเลขติดกัน >= 4 ตัวที่ต้น/ท้าย หรือ >= 6 ตัวตรงกลาง
+    size_t run = digitRun(text);
+    bool setC = run >= 4 || (run == length && run % 2 == 0);
+    add(setC ? START_C : START_B);
+
+    const char *p = text;
+    while (*p) {
+        run = digitRun(p);
+        if (setC) {
+            if (run >= 2) {
+                if (!add((p[0] - '0') * 10 + (p[1] - '0'))) {
+                    return false;
+                }
+                p += 2;
+                continue;
+            }
+            if (!add(CODE_B)) {
+                return false;
+            }
+            setC = false;
+        }
+
+        bool atEnd = p[run] == '\0';
+        if (run >= 6 || (run >= 4 && atEnd)) {
+            // ตัวเลขคี่: ตัวแรกพิมพ์ใน B ก่อน ให้ที่เหลือเป็นคู่
+            if (run % 2 == 1) {
+                if (!add(*p++ - 32)) {
+                    return false;
+                }
+            }
+            if (!add(CODE_C)) {
+                return false;
+            }
+            setC = true;
+            continue;
+        }
+
+        if (*p < 32 || *p > 126 || !add(*p - 32)) {
+            return false;
+        }
+        p++;
+    }
+
+    uint32_t checksum = values[0];
+    for (uint8_t i = 1; i < count; i++) {
+        checksum += (uint32_t)i * values[i];
+    }
+    return add(checksum % 103);
+}
+
+void Code128::draw(uint8_t *row, uint16_t x, uint8_t moduleWidth) const {
+    for (uint8_t i = 0; i <= count; i++) {
+        const char *pattern = PATTERNS[i < count ? values[i] : (uint8_t)STOP];
+        for (uint8_t k = 0; pattern[k]; k++) {
+            uint16_t w = (pattern[k] - '0') * moduleWidth;
+            if (k % 2 == 0) {
+                for (uint16_t end = x + w; x < end; x++) {
+                    row[x >> 3] |= 0x80 >> (x & 7);
+                }
+            } else {
+                x += w;
+            }
+        }
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef CODE128_H
+#define CODE128_H
+
+#include <Arduino.h>
+
+#define CODE128_MAX_SYMBOLS 64 // รวม start, checksum และการสลับ code set
+
+// barcode Code 128 (code set B สำหรับข้อความ ASCII 32-126, สลับเป็น C เมื่อมีตัวเลขติดกันยาว)
+class Code128 {
+  public:
+    Code128();
+    bool encode(const char *text);
+
+    // ความกว้างทั้งหมดเป็น module (ไม่รวม quiet zone)
+    uint16_t width() const { return count * 11 + 13; }
+    // วาดแท่งลงแถวของภาพ 1-bpp (MSB = ซ้าย) เริ่มที่ x ความกว้าง module ละ moduleWidth จุด
+    void draw(uint8_t *row, uint16_t x, uint8_t moduleWidth) const;
+
+  private:
+    uint8_t values[CODE128_MAX_SYMBOLS];
+    uint8_t count; // ไม่รวม stop
+
+    bool add(uint8_t value);
+};
+
+#endif // CODE128_H
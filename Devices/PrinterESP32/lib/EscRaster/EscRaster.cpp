@@ -0,0 +1,235 @@
+#include "EscRaster.h"
+#include <esp_heap_caps.h>
+
+namespace {
+
+// ข้าม whitespace และ comment (#...) ในหัวไฟล์ PBM แล้วอ่านตัวเลข
+long readPbmNumber(Stream &input) {
+    int c = input.read();
+    while (c == '#' || isspace(c)) {
+        if (c == '#') {
+            while (c >= 0 && c != '\n') {
+                c = input.read();
+            }
+        }
+        c = input.read();
+    }
+    long value = 0;
+    if (!isdigit(c)) {
+        return -1;
+    }
+    while (isdigit(c)) {
+        value = value * 10 + (c - '0');
+        c = input.read(); // whitespace ตัวเดียวหลังตัวเลข (ก่อน bitmap ต้องมีตัวเดียวพอดี)
+    }
+    return value;
+}
+
+} // namespace
+
+EscRaster::EscRaster() : useCounter(0) {
+    memset(&logo, 0, sizeof(logo));
+    memset(cache, 0, sizeof(cache));
+    memset(&statistics, 0, sizeof(statistics));
+}
+
+// จัดที่ (ใช้ buffer เดิมถ้าพอ) เขียนหัว GS v 0 แล้วคืนตำแหน่ง bitmap ที่ล้างเป็นสีขาวแล้ว
+uint8_t *EscRaster::allocate(Entry &entry, uint16_t width, uint16_t height) {
+    uint16_t bytesPerRow = (width + 7) / 8;
+    size_t size = 8 + (size_t)bytesPerRow * height;
+    if (entry.capacity < size) {
+        free(entry.data);
+        entry.data = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+        if (entry.data == NULL) {
+            entry.data = (uint8_t *)malloc(size);
+        }
+        entry.capacity = entry.data != NULL ? size : 0;
+        if (entry.data == NULL) {
+            Serial.printf("(Raster)=> Allocate %u bytes failed\n", size);
+            entry.size = 0;
+            return NULL;
+        }
+    }
+
+    uint8_t header[] = {0x1D, 'v', '0', 0, (uint8_t)(bytesPerRow & 0xFF), (uint8_t)(bytesPerRow >> 8), (uint8_t)(height & 0xFF),
+                        (uint8_t)(height >> 8)};
+    memcpy(entry.data, header, sizeof(header));
+    memset(entry.data + 8, 0, size - 8);
+    entry.size = size;
+    return entry.data + 8;
+}
+
+bool EscRaster::loadLogo(Stream &pbm, size_t maxBytes) {
+    if (pbm.read() != 'P' || pbm.read() != '4') {
+        Serial.println("(Raster)=> Logo is not a binary PBM (P4)");
+        return false;
+    }
+    long width = readPbmNumber(pbm);
+    long height = readPbmNumber(pbm);
+    if (width <= 0 || width > RASTER_MAX_WIDTH || height <= 0 || height > RASTER_MAX_HEIGHT) {
+        Serial.printf("(Raster)=> Logo size %ldx%ld not supported (max %dx%d)\n", width, height, RASTER_MAX_WIDTH, RASTER_MAX_HEIGHT);
+        return false;
+    }
+    // โลโก้ที่ใหญ่เกินที่เหลือในใบ ทุกใบที่มี @logo จะถูกข้ามเพราะเกินขนาดงานพิมพ์
+    size_t size = 8 + (size_t)((width + 7) / 8) * height;
+    if (size > maxBytes) {
+        Serial.printf("(Raster)=> Logo %ldx%ld needs %u bytes, only %u fit in a receipt\n", width, height, size, maxBytes);
+        return false;
+    }
+
+    // แถวของ P4 เติมเต็ม byte และ 1 = ดำ เหมือน GS v 0 อ่านตรงลง buffer ได้เลย
+    uint8_t *bitmap = allocate(logo, width, height);
+    if (bitmap == NULL) {
+        return false;
+    }
+    size_t expected = logo.size - 8;
+    if (pbm.readBytes((char *)bitmap, expected) != expected) {
+        Serial.println("(Raster)=> Logo file truncated");
+        free(logo.data);
+        memset(&logo, 0, sizeof(logo));
+        return false;
+    }
+    logo.kind = RASTER_LOGO;
+    Serial.printf("(Raster)=> Logo %ldx%ld loaded (%u bytes)\n", width, height, logo.size);
+    return true;
+}
+
+EscRaster::Entry *EscRaster::lookup(RasterKind kind, uint8_t param, const char *text, bool &hit) {
+    if (strlen(text) >= RASTER_KEY_SIZE) {
+        return NULL;
+    }
+    useCounter++;
+    // ไม่เจอ: ใช้ช่องว่าง หรือช่องที่ไม่ได้ใช้นานที่สุด
+    Entry *victim = NULL;
+    for (int i = 0; i < RASTER_CACHE_SLOTS; i++) {
+        Entry &entry = cache[i];
+        if (entry.size > 0 && entry.kind == kind && entry.param == param && strcmp(entry.key, text) == 0) {
+            entry.lastUse = useCounter;
+            hit = true;
+            return &entry;
+        }
+        if (victim == NULL || (victim->size > 0 && (entry.size == 0 || entry.lastUse < victim->lastUse))) {
+            victim = &entry;
+        }
+    }
+
+    hit = false;
+    victim->kind = kind;
+    victim->param = param;
+    strcpy(victim->key, text);
+    victim->lastUse = useCounter;
+    victim->size = 0;
+    return victim;
+}
+
+size_t EscRaster::send(Print &output, const Entry &entry) {
+    statistics.bytesSent += entry.size;
+    return output.write(entry.data, entry.size);
+}
+
+size_t EscRaster::printLogo(Print &output) { return hasLogo() ? send(output, logo) : 0; }
+
+size_t EscRaster::printQr(Print &output, const char *text, uint8_t scale) {
+    bool hit;
+    Entry *entry = lookup(RASTER_QR, scale, text, hit);
+    if (entry == NULL) {
+        return 0;
+    }
+    if (!hit) {
+        uint32_t start = micros();
+        bool ok = renderQr(*entry, text, scale);
+        statistics.renderUs += micros() - start;
+        statistics.misses++;
+        if (!ok) {
+            entry->size = 0;
+            return 0;
+        }
+    } else {
+        statistics.hits++;
+    }
+    return send(output, *entry);
+}
+
+size_t EscRaster::printBarcode(Print &output, const char *text, uint8_t height) {
+    bool hit;
+    Entry *entry = lookup(RASTER_BARCODE, height, text, hit);
+    if (entry == NULL) {
+        return 0;
+    }
+    if (!hit) {
+        uint32_t start = micros();
+        bool ok = renderBarcode(*entry, text, height);
+        statistics.renderUs += micros() - start;
+        statistics.misses++;
+        if (!ok) {
+            entry->size = 0;
+            return 0;
+        }
+    } else {
+        statistics.hits++;
+    }
+    return send(output, *entry);
+}
+
+bool EscRaster::renderQr(Entry &entry, const char *text, uint8_t scale) {
+    if (!qr.encode((const uint8_t *)text, strlen(text), QR_ECC_MEDIUM)) {
+        Serial.printf("(Raster)=> QR too long (%u bytes)\n", strlen(text));
+        return false;
+    }
+
+    // ขยาย module ละ scale จุด ลดลงถ้ากว้างเกินหัวพิมพ์
+    uint16_t modules = qr.size() + RASTER_QR_QUIET * 2;
+    scale = constrain(scale, 1, RASTER_MAX_WIDTH / modules);
+    uint16_t width = modules * scale;
+    uint8_t *bitmap = allocate(entry, width, width);
+    if (bitmap == NULL) {
+        return false;
+    }
+
+    uint16_t bytesPerRow = (width + 7) / 8;
+    uint8_t *row = bitmap + RASTER_QR_QUIET * scale * bytesPerRow;
+    for (uint8_t y = 0; y < qr.size(); y++) {
+        for (uint8_t x = 0; x < qr.size(); x++) {
+            if (!qr.module(x, y)) {
+                continue;
+            }
+            for (uint16_t dot = (x + RASTER_QR_QUIET) * scale, end = dot + scale; dot < end; dot++) {
+                row[dot >> 3] |= 0x80 >> (dot & 7);
+            }
+        }
+        // แถวเดียวกันซ้ำ scale ครั้ง
+        for (uint8_t k = 1; k < scale; k++) {
+            memcpy(row + k * bytesPerRow, row, bytesPerRow);
+        }
+        row += scale * bytesPerRow;
+    }
+    return true;
+}
+
+bool EscRaster::renderBarcode(Entry &entry, const char *text, uint8_t height) {
+    if (!barcode.encode(text)) {
+        Serial.printf("(Raster)=> Barcode cannot encode '%s'\n", text);
+        return false;
+    }
+
+    // ไม่ย่อ module ให้แคบกว่า RASTER_BARCODE_MODULE: ข้อความยาวเกินหัวพิมพ์ไม่พิมพ์ barcode (ตัดข้อความจะได้ค่าผิด)
+    uint16_t modules = barcode.width() + RASTER_BARCODE_QUIET * 2;
+    uint8_t moduleWidth = RASTER_BARCODE_MODULE;
+    if (modules * moduleWidth > RASTER_MAX_WIDTH) {
+        Serial.printf("(Raster)=> Barcode '%s' too wide (%u modules, max %d)\n", text, modules, RASTER_MAX_WIDTH / RASTER_BARCODE_MODULE);
+        return false;
+    }
+    uint16_t width = modules * moduleWidth;
+    height = max(height, (uint8_t)8);
+    uint8_t *bitmap = allocate(entry, width, height);
+    if (bitmap == NULL) {
+        return false;
+    }
+
+    uint16_t bytesPerRow = (width + 7) / 8;
+    barcode.draw(bitmap, RASTER_BARCODE_QUIET * moduleWidth, moduleWidth);
+    for (uint8_t k = 1; k < height; k++) {
+        memcpy(bitmap + k * bytesPerRow, bitmap, bytesPerRow);
+    }
+    return true;
+}
@@ -0,0 +1,68 @@
+#ifndef ESC_RASTER_H
+#define ESC_RASTER_H
+
+#include <Arduino.h>
+
+#include "Code128.h"
+#include "QrCode.h"
+
+#define RASTER_MAX_WIDTH 384     // จุดต่อแถว (หัวพิมพ์ 58 mm, 203 dpi)
+#define RASTER_MAX_HEIGHT 1024   // แถวสูงสุดของภาพ 1 ภาพ
+#define RASTER_CACHE_SLOTS 4     // จำนวนภาพ QR/barcode ที่จำไว้ (ไม่นับโลโก้)
+#define RASTER_KEY_SIZE 224      // ข้อความยาวสุดที่ใช้เป็น key ของ cache
+#define RASTER_QR_QUIET 4        // ขอบขาวรอบ QR (module)
+#define RASTER_BARCODE_QUIET 10  // ขอบขาวซ้าย/ขวาของ barcode (module)
+#define RASTER_BARCODE_MODULE 2  // จุดต่อ module (1 จุดแคบเกินสแกนได้แน่นอนบนหัว 203 dpi)
+
+enum RasterKind : uint8_t { RASTER_LOGO, RASTER_QR, RASTER_BARCODE };
+
+// สถิติการ render ใช้วัดผล (ดูผ่าน Serial ตอนพิมพ์)
+struct RasterStats {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t renderUs;  // เวลารวมที่ใช้สร้างภาพ (ไม่นับครั้งที่ได้จาก cache)
+    uint32_t bytesSent; // ขนาดคำสั่ง GS v 0 รวมที่เขียนลง Print
+};
+
+// สร้างภาพขาวดำ 1-bpp เป็นคำสั่ง GS v 0 (โลโก้, QR code, Code 128) ให้เครื่องพิมพ์ไม่ต้องเก็บโลโก้ไว้ในตัวเอง
+// ภาพที่สร้างแล้วเก็บไว้ใน PSRAM พร้อมหัวคำสั่ง ใบถัดไปที่ข้อความเดิมเหลือแค่ copy
+// ไม่มีการ lock: เรียกจาก task เดียว (loop)
+class EscRaster {
+  public:
+    EscRaster();
+    // ไฟล์ PBM แบบ binary (P4) กว้างไม่เกิน RASTER_MAX_WIDTH, maxBytes: ขนาดคำสั่ง GS v 0 สูงสุดที่ใส่ในใบเดียวได้
+    bool loadLogo(Stream &pbm, size_t maxBytes);
+    bool hasLogo() const { return logo.data != NULL; }
+
+    size_t printLogo(Print &output);
+    size_t printQr(Print &output, const char *text, uint8_t scale);
+    size_t printBarcode(Print &output, const char *text, uint8_t height);
+
+    const RasterStats &stats() const { return statistics; }
+
+  private:
+    struct Entry {
+        RasterKind kind;
+        uint8_t param;
+        char key[RASTER_KEY_SIZE];
+        uint8_t *data; // หัวคำสั่ง 8 byte + bitmap
+        size_t size;
+        size_t capacity;
+        uint32_t lastUse;
+    };
+
+    Entry logo;
+    Entry cache[RASTER_CACHE_SLOTS];
+    uint32_t useCounter;
+    RasterStats statistics;
+    QrCode qr;
+    Code128 barcode;
+
+    Entry *lookup(RasterKind kind, uint8_t param, const char *text, bool &hit);
+    static uint8_t *allocate(Entry &entry, uint16_t width, uint16_t height);
+    size_t send(Print &output, const Entry &entry);
+    bool renderQr(Entry &entry, const char *text, uint8_t scale);
+    bool renderBarcode(Entry &entry, const char *text, uint8_t height);
+};
+
+#endif // ESC_RASTER_H
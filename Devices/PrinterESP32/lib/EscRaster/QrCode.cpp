@@ -0,0 +1,396 @@
+#include "QrCode.h"
+#include <limits.h>
+
+namespace {
+
+// ตาราง ISO/IEC 18004 สำหรับ version 1-10 (index 0 ไม่ใช้)
+const uint8_t ECC_PER_BLOCK[4][QR_MAX_VERSION + 1] = {
+    {0, 7, 10, 15, 20, 26, 18, 20, 24, 30, 18},  // L
+    {0, 10, 16, 26, 18, 24, 16, 18, 22, 22, 26}, // M
+    {0, 13, 22, 18, 26, 18, 24, 18, 22, 20, 24}, // Q
+    {0, 17, 28, 22, 16, 22, 28, 26, 26, 24, 28}, // H
+};
+const uint8_t ECC_BLOCKS[4][QR_MAX_VERSION + 1] = {
+    {0, 1, 1, 1, 1, 1, 2, 2, 2, 2, 4}, // L
+    {0, 1, 1, 1, 2, 2, 4, 4, 4, 5, 5}, // M
+    {0, 1, 1, 2, 2, 4, 4, 6, 6, 8, 8}, // Q
+    {0, 1, 1, 2, 4, 4, 4, 5, 6, 8, 8}, // H
+};
+const uint8_t FORMAT_ECC_BITS[4] = {1, 0, 3, 2};
+const uint8_t MAX_ECC_PER_BLOCK = 30;
+
+uint8_t gfMultiply(uint8_t x, uint8_t y) {
+    uint16_t z = 0;
+    for (int i = 7; i >= 0; i--) {
+        z = (z << 1) ^ ((z >> 7) * 0x11D);
+        z ^= ((y >> i) & 1) * x;
+    }
+    return z;
+}
+
+// Reed-Solomon: เศษจากการหาร data ด้วย generator polynomial ดีกรี degree
+void reedSolomon(const uint8_t *data, size_t length, uint8_t degree, uint8_t *ecc) {
+    uint8_t divisor[MAX_ECC_PER_BLOCK];
+    memset(divisor, 0, degree);
+    divisor[degree - 1] = 1;
+    uint8_t root = 1;
+    for (uint8_t i = 0; i < degree; i++) {
+        for (uint8_t j = 0; j < degree; j++) {
+            divisor[j] = gfMultiply(divisor[j], root);
+            if (j + 1 < degree) {
+                divisor[j] ^= divisor[j + 1];
+            }
+        }
+        root = gfMultiply(root, 0x02);
+    }
+
+    memset(ecc, 0, degree);
+    for (size_t i = 0; i < length; i++) {
+        uint8_t factor = data[i] ^ ecc[0];
+        memmove(ecc, ecc + 1, degree - 1);
+        ecc[degree - 1] = 0;
+        for (uint8_t j = 0; j < degree; j++) {
+            ecc[j] ^= gfMultiply(divisor[j], factor);
+        }
+    }
+}
+
+struct BitWriter {
+    uint8_t *buffer;
+    size_t bits;
+
+    void put(uint32_t value, uint8_t count) {
+        for (int i = count - 1; i >= 0; i--) {
+            if ((value >> i) & 1) {
+                buffer[bits >> 3] |= 0x80 >> (bits & 7);
+            }
+            bits++;
+        }
+    }
+};
+
+bool maskBit(uint8_t mask, int x, int y) {
+    switch (mask) {
+    case 0:
+        return (x + y) % 2 == 0;
+    case 1:
+        return y % 2 == 0;
+    case 2:
+        return x % 3 == 0;
+    case 3:
+        return (x + y) % 3 == 0;
+    case 4:
+        return (x / 3 + y / 2) % 2 == 0;
+    case 5:
+        return x * y % 2 + x * y % 3 == 0;
+    case 6:
+        return (x * y % 2 + x * y % 3) % 2 == 0;
+    default:
+        return ((x + y) % 2 + x * y % 3) % 2 == 0;
+    }
+}
+
+} // namespace
+
+QrCode::QrCode() : modules(0), ver(0), ecc(QR_ECC_MEDIUM) {}
+
+uint16_t QrCode::rawCodewords(uint8_t version) {
+    uint32_t bits = (16 * version + 128) * version + 64;
+    if (version >= 2) {
+        uint32_t align = version / 7 + 2;
+        bits -= (25 * align - 10) * align - 55;
+        if (version >= 7) {
+            bits -= 36;
+        }
+    }
+    return bits / 8;
+}
+
+void QrCode::setFunction(uint8_t x, uint8_t y, bool dark) { grid[y][x] = FUNCTION | (dark ? DARK : 0); }
+
+void QrCode::drawFinder(int cx, int cy) {
+    for (int dy = -4; dy <= 4; dy++) {
+        for (int dx = -4; dx <= 4; dx++) {
+            int x = cx + dx;
+            int y = cy + dy;
+            if (x < 0 || y < 0 || x >= modules || y >= modules) {
+                continue;
+            }
+            int distance = max(abs(dx), abs(dy));
+            setFunction(x, y, distance != 2 && distance != 4);
+        }
+    }
+}
+
+void QrCode::drawAlignment(int cx, int cy) {
+    for (int dy = -2; dy <= 2; dy++) {
+        for (int dx = -2; dx <= 2; dx++) {
+            setFunction(cx + dx, cy + dy, max(abs(dx), abs(dy)) != 1);
+        }
+    }
+}
+
+void QrCode::drawFunctionPatterns() {
+    for (uint8_t i = 0; i < modules; i++) {
+        setFunction(6, i, i % 2 == 0);
+        setFunction(i, 6, i % 2 == 0);
+    }
+
+    drawFinder(3, 3);
+    drawFinder(modules - 4, 3);
+    drawFinder(3, modules - 4);
+
+    if (ver >= 2) {
+        uint8_t count = ver / 7 + 2;
+        uint8_t step = (ver * 4 + count * 2 + 1) / (count * 2 - 2) * 2;
+        uint8_t positions[3];
+        positions[0] = 6;
+        for (uint8_t i = count - 1, pos = modules - 7; i >= 1; i--, pos -= step) {
+            positions[i] = pos;
+        }
+        for (uint8_t i = 0; i < count; i++) {
+            for (uint8_t j = 0; j < count; j++) {
+                // ไม่ทับ finder 3 มุม
+                if ((i == 0 && j == 0) || (i == 0 && j == count - 1) || (i == count - 1 && j == 0)) {
+                    continue;
+                }
+                drawAlignment(positions[i], positions[j]);
+            }
+        }
+    }
+
+    // จองตำแหน่ง format/version ไว้ก่อน (ค่าจริงเขียนหลังเลือก mask)
+    drawFormat(0);
+    drawVersion();
+}
+
+void QrCode::drawFormat(uint8_t mask) {
+    uint16_t data = FORMAT_ECC_BITS[ecc] << 3 | mask;
+    uint16_t rem = data;
+    for (int i = 0; i < 10; i++) {
+        rem = (rem << 1) ^ ((rem >> 9) * 0x537);
+    }
+    uint16_t bits = (data << 10 | rem) ^ 0x5412;
+
+    for (int i = 0; i <= 5; i++) {
+        setFunction(8, i, (bits >> i) & 1);
+    }
+    setFunction(8, 7, (bits >> 6) & 1);
+    setFunction(8, 8, (bits >> 7) & 1);
+    setFunction(7, 8, (bits >> 8) & 1);
+    for (int i = 9; i < 15; i++) {
+        setFunction(14 - i, 8, (bits >> i) & 1);
+    }
+
+    for (int i = 0; i < 8; i++) {
+        setFunction(modules - 1 - i, 8, (bits >> i) & 1);
+    }
+    for (int i = 8; i < 15; i++) {
+        setFunction(8, modules - 15 + i, (bits >> i) & 1);
+    }
+    setFunction(8, modules - 8, true);
+}
+
+void QrCode::drawVersion() {
+    if (ver < 7) {
+        return;
+    }
+    uint32_t rem = ver;
+    for (int i = 0; i < 12; i++) {
+        rem = (rem << 1) ^ ((rem >> 11) * 0x1F25);
+    }
+    uint32_t bits = (uint32_t)ver << 12 | rem;
+    for (int i = 0; i < 18; i++) {
+        bool dark = (bits >> i) & 1;
+        int a = modules - 11 + i % 3;
+        int b = i / 3;
+        setFunction(a, b, dark);
+        setFunction(b, a, dark);
+    }
+}
+
+// วาง codeword แบบ zigzag คู่คอลัมน์จากขวาไปซ้าย
+void QrCode::drawCodewords(size_t count) {
+    size_t i = 0;
+    for (int right = modules - 1; right >= 1; right -= 2) {
+        if (right == 6) {
+            right = 5;
+        }
+        for (int vert = 0; vert < modules; vert++) {
+            for (int j = 0; j < 2; j++) {
+                int x = right - j;
+                bool upward = ((right + 1) & 2) == 0;
+                int y = upward ? modules - 1 - vert : vert;
+                if ((grid[y][x] & FUNCTION) == 0 && i < count * 8) {
+                    grid[y][x] = (codewords[i >> 3] >> (7 - (i & 7))) & 1;
+                    i++;
+                }
+            }
+        }
+    }
+}
+
+void QrCode::applyMask(uint8_t mask) {
+    for (int y = 0; y < modules; y++) {
+        for (int x = 0; x < modules; x++) {
+            if ((grid[y][x] & FUNCTION) == 0 && maskBit(mask, x, y)) {
+                grid[y][x] ^= DARK;
+            }
+        }
+    }
+}
+
+long QrCode::penalty() const {
+    long score = 0;
+    int dark = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (int a = 0; a < modules; a++) {
+            int run = 0;
+            bool previous = false;
+            for (int b = 0; b < modules; b++) {
+                bool color = pass == 0 ? module(b, a) : module(a, b);
+                if (b > 0 && color == previous) {
+                    run++;
+                } else {
+                    if (run >= 5) {
+                        score += 3 + (run - 5);
+                    }
+                    run = 1;
+                    previous = color;
+                }
+
+                // 1:1:3:1:1 (finder) ที่มีช่องว่าง 4 module ด้านใดด้านหนึ่ง (นอกขอบถือว่าขาว)
+                if (b + 7 <= modules) {
+                    static const bool FINDER[7] = {true, false, true, true, true, false, true};
+                    bool found = true;
+                    for (int k = 0; k < 7 && found; k++) {
+                        found = (pass == 0 ? module(b + k, a) : module(a, b + k)) == FINDER[k];
+                    }
+                    if (found) {
+                        bool lightBefore = true;
+                        bool lightAfter = true;
+                        for (int k = 1; k <= 4; k++) {
+                            int before = b - k;
+                            int after = b + 6 + k;
+                            if (before >= 0 && (pass == 0 ? module(before, a) : module(a, before))) {
+                                lightBefore = false;
+                            }
+                            if (after < modules && (pass == 0 ? module(after, a) : module(a, after))) {
+                                lightAfter = false;
+                            }
+                        }
+                        if (lightBefore || lightAfter) {
+                            score += 40;
+                        }
+                    }
+                }
+            }
+            if (run >= 5) {
+                score += 3 + (run - 5);
+            }
+        }
+    }
+
+    for (int y = 0; y < modules; y++) {
+        for (int x = 0; x < modules; x++) {
+            bool color = module(x, y);
+            if (color) {
+                dark++;
+            }
+            if (x + 1 < modules && y + 1 < modules && color == module(x + 1, y) && color == module(x, y + 1) && color == module(x + 1, y + 1)) {
+                score += 3;
+            }
+        }
+    }
+
+    long total = (long)modules * modules;
+    long k = (labs(dark * 20L - total * 10L) + total - 1) / total - 1;
+    return score + k * 10;
+}
+
+bool QrCode::encode(const uint8_t *data, size_t length, QrEcc ecc, int8_t mask) {
+    this->ecc = ecc;
+    ver = 0;
+    uint16_t dataCodewords = 0;
+    for (uint8_t v = 1; v <= QR_MAX_VERSION; v++) {
+        uint16_t capacity = rawCodewords(v) - ECC_PER_BLOCK[ecc][v] * ECC_BLOCKS[ecc][v];
+        size_t bits = 4 + (v < 10 ? 8 : 16) + length * 8;
+        if (bits <= capacity * 8UL) {
+            ver = v;
+            dataCodewords = capacity;
+            break;
+        }
+    }
+    if (ver == 0) {
+        modules = 0;
+        return false;
+    }
+    modules = ver * 4 + 17;
+
+    // byte mode: 0100, จำนวนตัวอักษร, ข้อมูล, terminator, เติม 0xEC 0x11 จนเต็ม
+    uint8_t stream[QR_MAX_SIZE * QR_MAX_SIZE / 8];
+    memset(stream, 0, dataCodewords);
+    BitWriter writer = {stream, 0};
+    writer.put(0x4, 4);
+    writer.put(length, ver < 10 ? 8 : 16);
+    for (size_t i = 0; i < length; i++) {
+        writer.put(data[i], 8);
+    }
+    writer.put(0, min((size_t)4, dataCodewords * 8 - writer.bits));
+    writer.bits = (writer.bits + 7) & ~7;
+    for (uint8_t pad = 0xEC; writer.bits < dataCodewords * 8UL; pad ^= 0xEC ^ 0x11) {
+        writer.put(pad, 8);
+    }
+
+    // แบ่ง block (block สั้นอยู่ก่อน) คำนวณ ECC แล้วสลับ codeword ข้าม block
+    uint8_t blocks = ECC_BLOCKS[ecc][ver];
+    uint8_t eccLength = ECC_PER_BLOCK[ecc][ver];
+    uint16_t raw = rawCodewords(ver);
+    uint8_t longBlocks = raw % blocks;
+    uint8_t shortData = raw / blocks - eccLength;
+    uint16_t out = 0;
+    for (uint8_t i = 0; i <= shortData; i++) {
+        uint16_t offset = 0;
+        for (uint8_t b = 0; b < blocks; b++) {
+            uint8_t blockData = shortData + (b >= blocks - longBlocks ? 1 : 0);
+            if (i < blockData) {
+                codewords[out++] = stream[offset + i];
+            }
+            offset += blockData;
+        }
+    }
+    uint16_t offset = 0;
+    uint8_t blockEcc[8][MAX_ECC_PER_BLOCK];
+    for (uint8_t b = 0; b < blocks; b++) {
+        uint8_t blockData = shortData + (b >= blocks - longBlocks ? 1 : 0);
+        reedSolomon(stream + offset, blockData, eccLength, blockEcc[b]);
+        offset += blockData;
+    }
+    for (uint8_t i = 0; i < eccLength; i++) {
+        for (uint8_t b = 0; b < blocks; b++) {
+            codewords[out++] = blockEcc[b][i];
+        }
+    }
+
+    memset(grid, 0, sizeof(grid));
+    drawFunctionPatterns();
+    drawCodewords(raw);
+
+    if (mask < 0) {
+        long best = LONG_MAX;
+        for (uint8_t m = 0; m < 8; m++) {
+            applyMask(m);
+            drawFormat(m);
+            long score = penalty();
+            if (score < best) {
+                best = score;
+                mask = m;
+            }
+            applyMask(m); // XOR ซ้ำเพื่อคืนค่าเดิม
+        }
+    }
+    applyMask(mask);
+    drawFormat(mask);
+    return true;
+}
@@ -0,0 +1,45 @@
+#ifndef QR_CODE_H
+#define QR_CODE_H
+
+#include <Arduino.h>
+
+#define QR_MAX_VERSION 10                       // 57x57 modules, byte mode ECC M ได้ 213 ตัวอักษร
+#define QR_MAX_SIZE (QR_MAX_VERSION * 4 + 17)
+
+enum QrEcc { QR_ECC_LOW, QR_ECC_MEDIUM, QR_ECC_QUARTILE, QR_ECC_HIGH };
+
+// สร้าง QR code (byte mode) ขนาด version 1-QR_MAX_VERSION เลือก version เล็กที่สุดที่ข้อมูลพอดี
+// ใช้ memory คงที่ในตัว object ไม่จอง heap
+class QrCode {
+  public:
+    QrCode();
+    // mask < 0: เลือก mask ที่ penalty ต่ำสุดตามมาตรฐาน
+    bool encode(const uint8_t *data, size_t length, QrEcc ecc = QR_ECC_MEDIUM, int8_t mask = -1);
+
+    uint8_t size() const { return modules; }
+    uint8_t version() const { return ver; }
+    bool module(uint8_t x, uint8_t y) const { return (grid[y][x] & DARK) != 0; }
+
+  private:
+    static const uint8_t DARK = 0x01;
+    static const uint8_t FUNCTION = 0x02;
+
+    uint8_t grid[QR_MAX_SIZE][QR_MAX_SIZE];
+    uint8_t codewords[QR_MAX_SIZE * QR_MAX_SIZE / 8];
+    uint8_t modules;
+    uint8_t ver;
+    QrEcc ecc;
+
+    static uint16_t rawCodewords(uint8_t version);
+    void setFunction(uint8_t x, uint8_t y, bool dark);
+    void drawFinder(int cx, int cy);
+    void drawAlignment(int cx, int cy);
+    void drawFunctionPatterns();
+    void drawFormat(uint8_t mask);
+    void drawVersion();
+    void drawCodewords(size_t count);
+    void applyMask(uint8_t mask);
+    long penalty() const;
+};
+
+#endif // QR_CODE_H
@@ -0,0 +1,331 @@
+#include "Outbox.h"
+
+namespace {
+
+const uint8_t FRAME_MAGIC = 0xA5;
+const uint32_t ACK_MAGIC = 0x4B434F57; // "WOCK"
+
+struct AckFile {
+    uint32_t magic;
+    OutboxPosition position;
+    uint32_t crc;
+};
+
+// CRC-32 (IEEE) ทีละ 4 bit ใช้ตารางแค่ 16 ค่า
+uint32_t crc32(uint32_t crc, const uint8_t *data, size_t length) {
+    static const uint32_t TABLE[16] = {0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+                                       0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+    crc = ~crc;
+    while (length--) {
+        crc = TABLE[(crc ^ *data) & 0x0F] ^ (crc >> 4);
+        crc = TABLE[(crc ^ (*data >> 4)) & 0x0F] ^ (crc >> 4);
+        data++;
+    }
+    return ~crc;
+}
+
+} // namespace
+
+Outbox::Outbox() : fs(NULL), readCount(0), readSize(0), length(0), buffered(0), maxSegments(0) {
+    memset(&acked, 0, sizeof(acked));
+    memset(&statistics, 0, sizeof(statistics));
+    readEnd = tail = acked;
+}
+
+String Outbox::segmentPath(uint32_t segment) {
+    char path[32];
+    snprintf(path, sizeof(path), OUTBOX_DIR "/%08lu.log", (unsigned long)segment);
+    return path;
+}
+
+bool Outbox::begin(fs::FS &fs, size_t capacity) {
+    maxSegments = min((size_t)OUTBOX_MAX_SEGMENTS, capacity / OUTBOX_SEGMENT_SIZE);
+    if (maxSegments == 0) {
+        Serial.printf("(Outbox)=> Only %u bytes available, need at least %d\n", capacity, OUTBOX_SEGMENT_SIZE);
+        return false;
+    }
+    this->fs = &fs;
+    if (!fs.exists(OUTBOX_DIR) && !fs.mkdir(OUTBOX_DIR)) {
+        Serial.println("(Outbox)=> Create " OUTBOX_DIR " failed");
+        this->fs = NULL;
+        return false;
+    }
+    scan();
+    Serial.printf("(Outbox)=> %lu records waiting, resume at segment %lu offset %lu, up to %lu segments\n", (unsigned long)statistics.pending,
+                  (unsigned long)acked.segment, (unsigned long)acked.offset, (unsigned long)maxSegments);
+    return true;
+}
+
+// หาไฟล์แรก/สุดท้าย อ่านตำแหน่ง ack แล้วไล่ frame ที่ยังไม่ ack จนเจอท้าย log
+void Outbox::scan() {
+    uint32_t first = UINT32_MAX;
+    uint32_t last = 0;
+    File dir = fs->open(OUTBOX_DIR);
+    for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+        const char *name = strrchr(file.name(), '/');
+        name = name != NULL ? name + 1 : file.name();
+        if (strstr(name, ".log") != NULL) {
+            uint32_t segment = strtoul(name, NULL, 10);
+            first = min(first, segment);
+            last = max(last, segment);
+        }
+        file.close();
+    }
+    dir.close();
+
+    bool known = loadAck();
+    if (!known) {
+        memset(&acked, 0, sizeof(acked));
+        acked.segment = first != UINT32_MAX ? first : 0;
+    }
+    // ไฟล์ที่ ack หมดแล้วแต่ยังไม่ได้ลบ (ไฟดับหลังบันทึก ack)
+    for (uint32_t segment = first; first != UINT32_MAX && segment < acked.segment; segment++) {
+        fs->remove(segmentPath(segment));
+    }
+    if (first == UINT32_MAX || last < acked.segment) {
+        tail = readEnd = acked;
+        return;
+    }
+
+    OutboxPosition position = acked;
+    uint8_t payload[OUTBOX_RECORD_MAX];
+    bool torn = false;
+    for (; position.segment <= last; position.segment++, position.offset = 0) {
+        File file = fs->open(segmentPath(position.segment), "r");
+        if (!file) {
+            torn = false;
+            continue;
+        }
+        file.seek(position.offset);
+        uint8_t size;
+        uint32_t seq;
+        while (readFrame(file, payload, size, seq)) {
+            if (!known) {
+                acked.seq = seq; // ไม่มี ack: เริ่มนับจาก record แรกที่ยังอยู่
+                known = true;
+            }
+            position.offset += size + OUTBOX_FRAME_OVERHEAD;
+            position.seq = seq + 1;
+            statistics.pending++;
+        }
+        torn = position.offset < file.size();
+        file.close();
+        if (position.segment == last) {
+            break;
+        }
+    }
+
+    // ท้ายไฟล์สุดท้ายเสีย: เขียนต่อในไฟล์ใหม่ ไม่ต่อท้ายข้อมูลที่เสีย
+    tail = position;
+    if (torn) {
+        Serial.printf("(Outbox)=> Segment %lu has a torn tail, continuing in a new segment\n", (unsigned long)tail.segment);
+        tail.segment++;
+        tail.offset = 0;
+    }
+    readEnd = acked;
+}
+
+bool Outbox::readFrame(File &file, uint8_t *payload, uint8_t &size, uint32_t &seq) {
+    uint8_t header[6];
+    if (file.read(header, sizeof(header)) != sizeof(header) || header[0] != FRAME_MAGIC || header[1] > OUTBOX_RECORD_MAX) {
+        return false;
+    }
+    size = header[1];
+    uint32_t crc;
+    if (file.read(payload, size) != size || file.read((uint8_t *)&crc, sizeof(crc)) != sizeof(crc)) {
+        return false;
+    }
+    if (crc32(crc32(0, header + 1, sizeof(header) - 1), payload, size) != crc) {
+        return false;
+    }
+    memcpy(&seq, header + 2, sizeof(seq));
+    return true;
+}
+
+bool Outbox::loadAck() {
+    File file = fs->open(OUTBOX_DIR "/ack", "r");
+    if (!file) {
+        return false;
+    }
+    AckFile ack;
+    bool ok = file.read((uint8_t *)&ack, sizeof(ack)) == sizeof(ack) && ack.magic == ACK_MAGIC &&
+              ack.crc == crc32(0, (const uint8_t *)&ack.position, sizeof(ack.position));
+    file.close();
+    if (ok) {
+        acked = ack.position;
+    } else {
+        Serial.println("(Outbox)=> Ack pointer corrupt, resending from the oldest segment");
+    }
+    return ok;
+}
+
+// ไฟล์เล็กเขียนทับทั้งไฟล์ LittleFS แทนที่ข้อมูลเดิมตอน close ครั้งเดียว (ไฟดับได้ค่าเก่าหรือค่าใหม่อย่างใดอย่างหนึ่ง)
+bool Outbox::saveAck(const OutboxPosition &position) {
+    AckFile ack;
+    ack.magic = ACK_MAGIC;
+    ack.position = position;
+    ack.crc = crc32(0, (const uint8_t *)&ack.position, sizeof(ack.position));
+    File file = fs->open(OUTBOX_DIR "/ack", "w");
+    if (!file) {
+        return false;
+    }
+    bool ok = file.write((const uint8_t *)&ack, sizeof(ack)) == sizeof(ack);
+    file.close();
+    return ok;
+}
+
+bool Outbox::append(const void *data, uint8_t size) {
+    if (fs == NULL || size > OUTBOX_RECORD_MAX) {
+        statistics.dropped++;
+        return false;
+    }
+    if (length + size + OUTBOX_FRAME_OVERHEAD > sizeof(buffer) && !commit()) {
+        statistics.dropped++;
+        return false;
+    }
+
+    uint8_t *frame = buffer + length;
+    uint32_t seq = tail.seq + buffered;
+    frame[0] = FRAME_MAGIC;
+    frame[1] = size;
+    memcpy(frame + 2, &seq, sizeof(seq));
+    memcpy(frame + 6, data, size);
+    uint32_t crc = crc32(0, frame + 1, size + 5);
+    memcpy(frame + 6 + size, &crc, sizeof(crc));
+    length += size + OUTBOX_FRAME_OVERHEAD;
+    buffered++;
+    statistics.appended++;
+    return true;
+}
+
+// เขียนทุก frame ที่รอใน buffer ด้วย write + flush ครั้งเดียว
+bool Outbox::commit() {
+    if (buffered == 0) {
+        return true;
+    }
+    if (tail.offset > 0 && tail.offset + length > OUTBOX_SEGMENT_SIZE) {
+        writer.close();
+        tail.segment++;
+        tail.offset = 0;
+    }
+
+    bool ok = tail.segment - acked.segment < maxSegments;
+    if (!ok) {
+        Serial.printf("(Outbox)=> Full (%lu segments not acknowledged), %u records not stored\n", (unsigned long)maxSegments, buffered);
+    } else {
+        uint32_t start = micros();
+        if (!writer) {
+            writer = fs->open(segmentPath(tail.segment), "a");
+        }
+        ok = writer && writer.write(buffer, length) == length;
+        if (ok) {
+            writer.flush();
+        }
+        statistics.commitUs += micros() - start;
+        if (!ok) {
+            // frame ที่เขียนไม่ครบจะ crc ไม่ผ่าน ข้ามไฟล์นี้ไป
+            Serial.printf("(Outbox)=> Write %u bytes failed, %u records not stored\n", length, buffered);
+            writer.close();
+            tail.segment++;
+            tail.offset = 0;
+        }
+    }
+
+    if (ok) {
+        tail.offset += length;
+        tail.seq += buffered;
+        statistics.pending += buffered;
+        statistics.commits++;
+        statistics.bytesWritten += length;
+    } else {
+        statistics.dropped += buffered;
+    }
+    length = 0;
+    buffered = 0;
+    return ok;
+}
+
+// ไล่ frame จาก position เก็บ record ที่ขนาดตรง recordSize ไม่เกิน max (records = NULL นับอย่างเดียว)
+// position ขยับไปหลัง record สุดท้ายที่นับ
+uint16_t Outbox::walk(OutboxPosition &position, void *records, uint8_t recordSize, uint16_t max, uint32_t *seqs) {
+    uint16_t count = 0;
+    uint8_t payload[OUTBOX_RECORD_MAX];
+    while (count < max && position.seq < tail.seq) {
+        File file = fs->open(segmentPath(position.segment), "r");
+        if (file) {
+            file.seek(position.offset);
+            uint8_t size;
+            uint32_t seq;
+            while (count < max && readFrame(file, payload, size, seq)) {
+                position.offset += size + OUTBOX_FRAME_OVERHEAD;
+                position.seq = seq + 1;
+                if (size == recordSize) {
+                    if (records != NULL) {
+                        memcpy((uint8_t *)records + count * recordSize, payload, size);
+                    }
+                    if (seqs != NULL) {
+                        seqs[count] = seq;
+                    }
+                    count++;
+                } else if (records != NULL) {
+                    Serial.printf("(Outbox)=> Skip record %lu (%u bytes, expected %u)\n", (unsigned long)seq, size, recordSize);
+                }
+            }
+            file.close();
+            if (count == max || position.segment >= tail.segment) {
+                break;
+            }
+        } else if (position.segment >= tail.segment) {
+            break;
+        }
+        // จบไฟล์ (หรือเจอ frame เสีย) ต่อไฟล์ถัดไป
+        position.segment++;
+        position.offset = 0;
+    }
+    return count;
+}
+
+uint16_t Outbox::read(void *records, uint8_t recordSize, uint16_t max, uint32_t *seqs) {
+    readEnd = acked;
+    readCount = 0;
+    readSize = recordSize;
+    if (fs == NULL) {
+        return 0;
+    }
+
+    readCount = walk(readEnd, records, recordSize, max, seqs);
+    if (readCount == 0 && readEnd.seq != acked.seq) {
+        ack(); // มีแต่ record ที่ข้าม
+    }
+    return readCount;
+}
+
+bool Outbox::ack() { return advance(readEnd); }
+
+// server รับไปแค่บางส่วน: ไล่ใหม่จากตำแหน่ง ack เดิมให้ได้ตำแหน่งหลัง record ที่ count
+bool Outbox::ack(uint16_t count) {
+    if (count >= readCount) {
+        return ack();
+    }
+    OutboxPosition position = acked;
+    walk(position, NULL, readSize, count, NULL);
+    return advance(position);
+}
+
+bool Outbox::advance(const OutboxPosition &position) {
+    if (position.seq == acked.seq && position.segment == acked.segment) {
+        return true;
+    }
+    if (!saveAck(position)) {
+        Serial.println("(Outbox)=> Save ack pointer failed");
+        return false;
+    }
+    for (uint32_t segment = acked.segment; segment < position.segment; segment++) {
+        fs->remove(segmentPath(segment));
+    }
+    statistics.pending -= min(statistics.pending, position.seq - acked.seq);
+    acked = position;
+    return true;
+}
+
+OutboxStats Outbox::stats() const { return statistics; }
@@ -0,0 +1,79 @@
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+#define OUTBOX_DIR "/outbox"
+#define OUTBOX_RECORD_MAX 200      // payload สูงสุดต่อ record (byte)
+#define OUTBOX_COMMIT_SIZE 2048    // buffer ของ group commit (เต็มแล้ว commit เอง)
+#define OUTBOX_SEGMENT_SIZE 65536  // ขึ้นไฟล์ใหม่เมื่อไฟล์ปัจจุบันถึงขนาดนี้
+#define OUTBOX_MAX_SEGMENTS 32     // ไฟล์ที่ยังส่งไม่หมดได้มากสุด ถ้า capacity ใน begin() น้อยกว่าจะใช้ตาม capacity
+#define OUTBOX_FRAME_OVERHEAD 10   // magic + length + seq + crc32
+
+// ตำแหน่งใน log: ไฟล์ที่ segment, byte ที่ offset, seq ของ record ถัดไป
+struct OutboxPosition {
+    uint32_t segment;
+    uint32_t offset;
+    uint32_t seq;
+};
+
+struct OutboxStats {
+    uint32_t pending;  // record ที่ commit แล้วแต่ server ยังไม่ ack
+    uint32_t appended; // ตั้งแต่เปิดเครื่อง
+    uint32_t commits;
+    uint32_t bytesWritten;
+    uint32_t commitUs; // เวลารวมที่ใช้ write + flush
+    uint32_t dropped;  // record ที่ commit ไม่สำเร็จ (พื้นที่เต็ม/เขียนไม่ได้) ผู้เรียกเก็บไว้ append ใหม่ได้
+};
+
+// log แบบ append-only ของ record ที่ต้องส่งถึง server ให้ได้ (ไม่หายเมื่อรีเซ็ตหรือไฟดับ)
+// frame: [0xA5][length][seq 4 byte][payload][crc32 ของ length..payload]
+// append() ลง buffer ใน RAM, commit() เขียนทั้ง buffer ครั้งเดียวแล้ว flush (group commit)
+// ตำแหน่งที่ server ยืนยันแล้ว (ack) เก็บแยกในไฟล์ OUTBOX_DIR "/ack" เปิดเครื่องใหม่อ่านต่อจากตรงนั้น
+// frame ที่เขียนไม่จบ (ไฟดับระหว่างเขียน) crc ไม่ผ่าน: ข้ามไปไฟล์ถัดไป และ append ต่อในไฟล์ใหม่
+// ไม่มีการ lock: เรียกจาก task เดียว (processQueueTask)
+class Outbox {
+  public:
+    Outbox();
+    // capacity: byte ของ fs ที่ outbox ใช้ได้ (ไฟล์ที่ยังส่งไม่หมดเต็ม capacity แล้ว commit() คืน false)
+    bool begin(fs::FS &fs, size_t capacity);
+    bool ready() const { return fs != NULL; }
+    bool full() const { return tail.segment - acked.segment >= maxSegments; } // commit() ไม่สำเร็จเพราะพื้นที่เต็ม
+
+    bool append(const void *data, uint8_t length);
+    bool commit();
+
+    // อ่าน record ที่ยังไม่ ack ตามลำดับ (ไม่เกิน max, ขนาด recordSize ต่อ record) ไม่ขยับตำแหน่ง ack
+    // seqs: seq ของแต่ละ record (ไม่ซ้ำตลอดอายุ outbox ให้ server ใช้ตัด record ที่ส่งซ้ำ) NULL = ไม่ต้องการ
+    // record ที่ขนาดไม่ตรง recordSize (firmware คนละรุ่น) ถูกข้าม
+    uint16_t read(void *records, uint8_t recordSize, uint16_t max, uint32_t *seqs);
+    bool ack();               // ยืนยันทุก record ที่ read() ครั้งล่าสุดคืนมา
+    bool ack(uint16_t count); // ยืนยันแค่ count record แรก ที่เหลือ read() ครั้งหน้าได้อีก
+
+    OutboxStats stats() const;
+
+  private:
+    fs::FS *fs;
+    File writer;
+    OutboxPosition acked;
+    OutboxPosition readEnd; // ตำแหน่งหลัง record สุดท้ายที่ read() คืนมา
+    uint16_t readCount;     // จำนวน record ที่ read() ครั้งล่าสุดคืนมา
+    uint8_t readSize;
+    OutboxPosition tail;    // ตำแหน่งที่ commit ถัดไปจะเขียน
+    uint8_t buffer[OUTBOX_COMMIT_SIZE];
+    size_t length;
+    uint16_t buffered;
+    uint32_t maxSegments;
+    OutboxStats statistics;
+
+    static String segmentPath(uint32_t segment);
+    bool readFrame(File &file, uint8_t *payload, uint8_t &size, uint32_t &seq);
+    uint16_t walk(OutboxPosition &position, void *records, uint8_t recordSize, uint16_t max, uint32_t *seqs);
+    bool advance(const OutboxPosition &position);
+    bool saveAck(const OutboxPosition &position);
+    bool loadAck();
+    void scan();
+};
+
+#endif // OUTBOX_H
@@ -0,0 +1,281 @@
+#include "PrintSpooler.h"
+#include <esp_heap_caps.h>
+
+namespace {
+
+enum EscPosByte : uint8_t { BYTE_DLE = 0x10, BYTE_EOT = 0x04 };
+
+// DLE EOT n: ขอสถานะแบบ real-time (เครื่องพิมพ์ตอบ 1 byte รูปแบบ 0xx1xx10)
+enum StatusFunction : uint8_t { STATUS_OFFLINE_CAUSE = 2, STATUS_PAPER_SENSOR = 4 };
+
+} // namespace
+
+PrintJob::PrintJob() : bytes(NULL), length(0), overflow(false) {}
+
+bool PrintJob::begin() {
+    if (bytes == NULL) {
+        bytes = (uint8_t *)heap_caps_malloc(PRINT_JOB_SIZE, MALLOC_CAP_SPIRAM);
+    }
+    return bytes != NULL;
+}
+
+size_t PrintJob::write(uint8_t c) {
+    if (bytes == NULL || length >= PRINT_JOB_SIZE) {
+        overflow = true;
+        return 0;
+    }
+    bytes[length++] = c;
+    return 1;
+}
+
+size_t PrintJob::write(const uint8_t *buffer, size_t size) {
+    size_t n = bytes != NULL ? min(size, (size_t)(PRINT_JOB_SIZE - length)) : 0;
+    memcpy(bytes + length, buffer, n);
+    length += n;
+    if (n < size) {
+        overflow = true;
+    }
+    return n;
+}
+
+void PrintJob::clear() {
+    length = 0;
+    overflow = false;
+}
+
+PrintSpooler::PrintSpooler()
+    : serial(NULL), freeQueue(NULL), printQueue(NULL), state(SPOOLER_IDLE), printing(false), status(PRINTER_STATUS_OK), pollStatus(false),
+      lastPoll(0), missed(0), callback(NULL), printed(0), failed(0) {}
+
+bool PrintSpooler::begin(HardwareSerial &serial, int8_t ctsPin, bool pollStatus, BaseType_t core) {
+    this->serial = &serial;
+    this->pollStatus = pollStatus;
+    freeQueue = xQueueCreate(PRINT_QUEUE_DEPTH, sizeof(PrintJob *));
+    printQueue = xQueueCreate(PRINT_QUEUE_DEPTH, sizeof(PrintJob *));
+    if (freeQueue == NULL || printQueue == NULL) {
+        Serial.println("(Spooler)=> Create queue failed");
+        return false;
+    }
+    for (int i = 0; i < PRINT_QUEUE_DEPTH; i++) {
+        PrintJob *job = &jobs[i];
+        if (!job->begin()) {
+            Serial.println("(Spooler)=> Allocate job buffer failed");
+            return false;
+        }
+        xQueueSend(freeQueue, &job, 0);
+    }
+
+    // เครื่องพิมพ์ดึง CTS เมื่อ buffer ภายในเต็ม (กระดาษหมด, ฝาเปิด) UART จะหยุดส่งเอง
+    if (ctsPin >= 0) {
+        serial.setPins(-1, -1, ctsPin, -1);
+        serial.setHwFlowCtrlMode(HW_FLOWCTRL_CTS);
+    }
+
+    return xTaskCreatePinnedToCore(task, "Print Spooler", 4096, this, 1, NULL, core) == pdPASS;
+}
+
+PrintJob *PrintSpooler::acquire() {
+    PrintJob *job;
+    if (freeQueue == NULL || xQueueReceive(freeQueue, &job, 0) != pdTRUE) {
+        if (status & PRINTER_STATUS_BLOCKING) {
+            setState(SPOOLER_PAUSED, statusText(status)); // คิวเต็มเพราะหยุดรอ แสดงสาเหตุต่อ
+        } else {
+            setState(SPOOLER_ERROR, "Queue full");
+        }
+        return NULL;
+    }
+    job->clear();
+    return job;
+}
+
+bool PrintSpooler::submit(PrintJob *job) {
+    if (job->overflowed()) {
+        Serial.printf("(Spooler)=> Job too large (> %d bytes)\n", PRINT_JOB_SIZE);
+        xQueueSend(freeQueue, &job, 0);
+        setState(SPOOLER_ERROR, "Job too large");
+        return false;
+    }
+    // มี slot ว่างเท่ากับจำนวน job เสมอ ไม่ต้องรอ
+    xQueueSend(printQueue, &job, 0);
+    if (status & PRINTER_STATUS_BLOCKING) {
+        setState(SPOOLER_PAUSED, statusText(status));
+    } else if (!printing) {
+        setState(SPOOLER_QUEUED);
+    }
+    return true;
+}
+
+uint8_t PrintSpooler::pending() const { return (printQueue != NULL ? uxQueueMessagesWaiting(printQueue) : 0) + (printing ? 1 : 0); }
+
+bool PrintSpooler::service(TickType_t wait) {
+    if (printQueue == NULL) {
+        return false;
+    }
+
+    // ถามสถานะตอนว่างเท่านั้น ใบเสร็จที่เข้าคิวใช้ผลล่าสุด (ไม่เก่ากว่า PRINT_STATUS_INTERVAL) ไม่ต้องรอถาม
+    if (pollStatus) {
+        TickType_t interval = pdMS_TO_TICKS(PRINT_STATUS_INTERVAL);
+        if (millis() - lastPoll >= PRINT_STATUS_INTERVAL) {
+            updateStatus();
+        }
+        if (status & PRINTER_STATUS_BLOCKING) {
+            vTaskDelay(min(wait, interval)); // หยุดคิวไว้ งานที่ค้างอยู่ยังไม่หาย
+            return false;
+        }
+        wait = min(wait, interval);
+    }
+
+    PrintJob *job;
+    if (xQueueReceive(printQueue, &job, wait) != pdTRUE) {
+        return false;
+    }
+
+    printing = true;
+    setState(SPOOLER_PRINTING);
+    uint32_t start = millis();
+    bool ok = stream(job);
+    printing = false;
+
+    // ส่งไม่ออกเพราะกระดาษหมด/ฝาเปิด: เก็บใบนี้ไว้หัวคิว พิมพ์ใหม่ทั้งใบเมื่อพร้อม
+    if (!ok && pollStatus && !updateStatus()) {
+        xQueueSendToFront(printQueue, &job, 0);
+        Serial.printf("(Spooler)=> Printer paused (%s), ticket kept for reprint\n", statusText(status));
+        return true;
+    }
+
+    if (ok) {
+        printed++;
+        Serial.printf("(Spooler)=> Printed %u bytes in %lu ms\n", job->size(), millis() - start);
+    } else {
+        failed++;
+        Serial.printf("(Spooler)=> Printer not responding, %u bytes dropped\n", job->size());
+    }
+    xQueueSend(freeQueue, &job, 0);
+
+    if (!ok) {
+        setState(SPOOLER_ERROR, "Printer not responding");
+    } else {
+        setState(uxQueueMessagesWaiting(printQueue) > 0 ? SPOOLER_QUEUED : SPOOLER_IDLE);
+    }
+    return true;
+}
+
+// ส่งเท่าที่ TX buffer ว่าง ถ้าไม่มีที่ว่างนานเกิน PRINT_WRITE_TIMEOUT ถือว่าเครื่องพิมพ์ไม่รับ
+bool PrintSpooler::stream(const PrintJob *job) {
+    size_t offset = 0;
+    uint32_t lastProgress = millis();
+    while (offset < job->size()) {
+        int space = serial->availableForWrite();
+        if (space > 0) {
+            size_t n = min((size_t)space, job->size() - offset);
+            offset += serial->write(job->data() + offset, n);
+            lastProgress = millis();
+        } else if (millis() - lastProgress > PRINT_WRITE_TIMEOUT) {
+            return false;
+        } else {
+            vTaskDelay(pdMS_TO_TICKS(2));
+        }
+    }
+    return true;
+}
+
+// ส่ง DLE EOT แล้วรอคำตอบ (ทิ้ง byte ที่ไม่ใช่รูปแบบสถานะ)
+bool PrintSpooler::query(uint8_t function, uint8_t &response) {
+    while (serial->available() > 0) {
+        serial->read();
+    }
+    uint8_t command[] = {BYTE_DLE, BYTE_EOT, function};
+    serial->write(command, sizeof(command));
+
+    uint32_t start = millis();
+    while (millis() - start < PRINT_STATUS_TIMEOUT) {
+        int c = serial->read();
+        if (c < 0) {
+            vTaskDelay(pdMS_TO_TICKS(2));
+        } else if ((c & 0x93) == 0x12) {
+            response = c;
+            return true;
+        }
+    }
+    return false;
+}
+
+// อ่านสถานะใหม่ แจ้ง callback เมื่อเปลี่ยน คืนค่า false ถ้าต้องหยุดคิว
+bool PrintSpooler::updateStatus() {
+    uint8_t next = PRINTER_STATUS_OK;
+    uint8_t offline;
+    uint8_t paper;
+    lastPoll = millis();
+
+    if (!query(STATUS_OFFLINE_CAUSE, offline)) {
+        // ไม่ตอบครั้งเดียวอาจเป็นเพราะ CTS ค้างระหว่างเครื่องพิมพ์ยังพิมพ์ใบก่อน
+        if (++missed < PRINT_STATUS_RETRIES) {
+            return (status & PRINTER_STATUS_BLOCKING) == 0;
+        }
+        next = PRINTER_NO_RESPONSE;
+    } else {
+        missed = 0;
+        if (offline & 0x04) {
+            next |= PRINTER_COVER_OPEN;
+        }
+        if (offline & 0x20) {
+            next |= PRINTER_PAPER_OUT;
+        }
+        if (offline & 0x40) {
+            next |= PRINTER_FAULT;
+        }
+        if (query(STATUS_PAPER_SENSOR, paper)) {
+            if (paper & 0x60) {
+                next |= PRINTER_PAPER_OUT;
+            }
+            if (paper & 0x0C) {
+                next |= PRINTER_PAPER_NEAR_END;
+            }
+        }
+    }
+
+    uint8_t previous = status;
+    status = next;
+    if (next != previous) {
+        Serial.printf("(Spooler)=> Printer status: %s\n", statusText(next));
+        if (next & PRINTER_STATUS_BLOCKING) {
+            setState(SPOOLER_PAUSED, statusText(next));
+        } else {
+            setState(uxQueueMessagesWaiting(printQueue) > 0 ? SPOOLER_QUEUED : SPOOLER_IDLE);
+        }
+    }
+    return (next & PRINTER_STATUS_BLOCKING) == 0;
+}
+
+const char *PrintSpooler::statusText(uint8_t status) {
+    if (status & PRINTER_NO_RESPONSE) {
+        return "No response";
+    }
+    if (status & PRINTER_COVER_OPEN) {
+        return "Cover open";
+    }
+    if (status & PRINTER_PAPER_OUT) {
+        return "Paper out";
+    }
+    if (status & PRINTER_FAULT) {
+        return "Printer fault";
+    }
+    if (status & PRINTER_PAPER_NEAR_END) {
+        return "Paper low";
+    }
+    return "OK";
+}
+
+void PrintSpooler::setState(SpoolerState state, const char *error) {
+    this->state = state;
+    if (callback != NULL) {
+        callback(state, pending(), error);
+    }
+}
+
+void PrintSpooler::task(void *param) {
+    PrintSpooler *spooler = (PrintSpooler *)param;
+    for (;;) {
+        spooler->service(portMAX_DELAY);
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef PRINT_SPOOLER_H
+#define PRINT_SPOOLER_H
+
+#include <Arduino.h>
+
+#define PRINT_JOB_SIZE 16384     // byte สูงสุดต่อใบ (รวมภาพ GS v 0) จองใน PSRAM
+#define PRINT_QUEUE_DEPTH 4      // จำนวนใบที่รอพิมพ์ได้
+#define PRINT_WRITE_TIMEOUT 5000 // ms ที่เครื่องพิมพ์ไม่รับข้อมูล (CTS ค้าง) ก่อนถือว่าผิดพลาด
+#define PRINT_STATUS_INTERVAL 1000 // ms ถามสถานะตอนว่าง/หยุดรอ (ก่อนพิมพ์ใช้ค่าล่าสุดถ้าไม่เก่ากว่านี้)
+#define PRINT_STATUS_TIMEOUT 100   // ms รอคำตอบ DLE EOT
+#define PRINT_STATUS_RETRIES 2     // ไม่ตอบติดกันกี่ครั้งจึงถือว่าเครื่องพิมพ์ไม่พร้อม
+
+enum SpoolerState { SPOOLER_IDLE, SPOOLER_QUEUED, SPOOLER_PRINTING, SPOOLER_ERROR, SPOOLER_PAUSED };
+
+// สถานะเครื่องพิมพ์จาก DLE EOT (bit รวมกันได้)
+enum PrinterStatusFlag : uint8_t {
+    PRINTER_STATUS_OK = 0x00,
+    PRINTER_NO_RESPONSE = 0x01,    // ไม่ตอบ (ปิดเครื่อง/สายหลุด)
+    PRINTER_COVER_OPEN = 0x02,     // ฝาเปิด
+    PRINTER_PAPER_OUT = 0x04,      // กระดาษหมด
+    PRINTER_FAULT = 0x08,          // error อื่น (cutter, หัวพิมพ์ร้อน)
+    PRINTER_PAPER_NEAR_END = 0x10, // กระดาษใกล้หมด (ยังพิมพ์ต่อ)
+};
+#define PRINTER_STATUS_BLOCKING (PRINTER_NO_RESPONSE | PRINTER_COVER_OPEN | PRINTER_PAPER_OUT | PRINTER_FAULT)
+
+// buffer ของใบเสร็จ 1 ใบ (เขียนผ่าน Print เหมือนเขียนลง Serial)
+class PrintJob : public Print {
+  public:
+    PrintJob();
+    bool begin();
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    void clear();
+    size_t size() const { return length; }
+    bool overflowed() const { return overflow; }
+    const uint8_t *data() const { return bytes; }
+
+  private:
+    uint8_t *bytes;
+    uint16_t length;
+    bool overflow;
+};
+
+typedef void (*SpoolerStateCallback)(SpoolerState state, uint8_t pending, const char *error);
+
+// คิวงานพิมพ์: loop สร้างใบเสร็จลง buffer แล้วส่งต่อทันที task ของ spooler ค่อยๆ ส่งออก UART
+// job มีจำนวนจำกัด (PRINT_QUEUE_DEPTH) ถ้าเต็ม acquire() คืนค่า NULL
+// pollStatus: ถามสถานะ (DLE EOT) ใน task ของ spooler ตอนว่าง ถ้ากระดาษหมด/ฝาเปิดจะหยุดคิวไว้จนกว่าจะพร้อม
+// (ต้องต่อสาย TX ของเครื่องพิมพ์เข้าขา RX ของ UART)
+class PrintSpooler {
+  public:
+    PrintSpooler();
+    bool begin(HardwareSerial &serial, int8_t ctsPin = -1, bool pollStatus = false, BaseType_t core = 0);
+    void onStateChange(SpoolerStateCallback callback) { this->callback = callback; }
+
+    PrintJob *acquire();
+    bool submit(PrintJob *job);
+    bool service(TickType_t wait); // ส่ง 1 งาน (task เรียกวนไป, simulator เรียกเอง)
+
+    SpoolerState getState() const { return state; }
+    bool statusEnabled() const { return pollStatus; }
+    uint8_t printerStatus() const { return status; } // PrinterStatusFlag ล่าสุด
+    static const char *statusText(uint8_t status);
+    uint8_t pending() const;
+    uint32_t jobsPrinted() const { return printed; }
+    uint32_t jobsFailed() const { return failed; }
+
+  private:
+    HardwareSerial *serial;
+    PrintJob jobs[PRINT_QUEUE_DEPTH];
+    QueueHandle_t freeQueue;
+    QueueHandle_t printQueue;
+    volatile SpoolerState state;
+    volatile bool printing;
+    volatile uint8_t status;
+    bool pollStatus;
+    uint32_t lastPoll;
+    uint8_t missed;
+    SpoolerStateCallback callback;
+    uint32_t printed;
+    uint32_t failed;
+
+    bool stream(const PrintJob *job);
+    bool query(uint8_t function, uint8_t &response);
+    bool updateStatus();
+    void setState(SpoolerState state, const char *error = NULL);
+    static void task(void *param);
+};
+
+#endif // PRINT_SPOOLER_H
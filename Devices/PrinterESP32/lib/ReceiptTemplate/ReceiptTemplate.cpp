@@ -0,0 +1,334 @@
+#include "ReceiptTemplate.h"
+
+namespace {
+
+enum EscPosByte : uint8_t { BYTE_LF = 0x0A, BYTE_FS = 0x1C, BYTE_GS = 0x1D, BYTE_ESC = 0x1B };
+
+struct Keyword {
+    const char *name;
+    uint8_t value;
+};
+
+// ค่าเดียวกับ enum ใน Printer.h (ให้ใบเสร็จออกมาเหมือนเดิม)
+const Keyword ALIGN_KEYWORDS[] = {{"left", 0x00}, {"center", 0x01}, {"right", 0x02}};
+const Keyword SIZE_KEYWORDS[] = {{"normal", 0x00}, {"large", 0x01}};
+const Keyword BOLD_KEYWORDS[] = {{"on", 0x00}, {"off", 0x01}};
+const Keyword HIGHLIGHT_KEYWORDS[] = {{"off", 0x00}, {"underline", 0x08}, {"larger", 0x10}, {"tall", 0x20}, {"big", 0x30}};
+
+bool matches(const char *text, size_t n, const char *name) { return strlen(name) == n && strncmp(text, name, n) == 0; }
+
+template <size_t N> bool findKeyword(const Keyword (&keywords)[N], const char *text, size_t n, uint8_t &value) {
+    for (size_t i = 0; i < N; i++) {
+        if (matches(text, n, keywords[i].name)) {
+            value = keywords[i].value;
+            return true;
+        }
+    }
+    return false;
+}
+
+int findName(const char *const *names, uint8_t count, const char *text, size_t n) {
+    for (uint8_t i = 0; i < count; i++) {
+        if (matches(text, n, names[i])) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+ReceiptTemplate::ReceiptTemplate() : length(0), segmentCount(0), mergeFrom(0), valid(false), lineNumber(0) { errorText[0] = '\0'; }
+
+bool ReceiptTemplate::fail(const char *message, const char *detail, size_t detailLength) {
+    if (detail != NULL) {
+        snprintf(errorText, sizeof(errorText), "line %d: %s '%.*s'", lineNumber, message, (int)min(detailLength, (size_t)20), detail);
+    } else {
+        snprintf(errorText, sizeof(errorText), "line %d: %s", lineNumber, message);
+    }
+    valid = false;
+    return false;
+}
+
+bool ReceiptTemplate::addSegment(SegmentType type, uint8_t arg, int8_t width) {
+    if (segmentCount >= RECEIPT_MAX_SEGMENTS) {
+        return fail("too many fields/commands");
+    }
+    Segment &segment = segments[segmentCount++];
+    segment.type = type;
+    segment.arg = arg;
+    segment.width = width;
+    segment.offset = length;
+    segment.length = 0;
+    return true;
+}
+
+// ต่อท้ายข้อความคงที่ (รวมกับ segment ก่อนหน้าถ้าเป็นข้อความคงที่เหมือนกัน)
+bool ReceiptTemplate::emit(const uint8_t *data, size_t n) {
+    if (length + n > RECEIPT_MAX_BYTES) {
+        return fail("template too long");
+    }
+    if (segmentCount == mergeFrom || segments[segmentCount - 1].type != SEGMENT_BYTES) {
+        if (!addSegment(SEGMENT_BYTES, 0, 0)) {
+            return false;
+        }
+    }
+    memcpy(bytes + length, data, n);
+    length += n;
+    segments[segmentCount - 1].length += n;
+    return true;
+}
+
+bool ReceiptTemplate::emit3(uint8_t a, uint8_t b, uint8_t c) {
+    uint8_t data[] = {a, b, c};
+    return emit(data, sizeof(data));
+}
+
+// @qr / @barcode: <field> [ขนาด]
+bool ReceiptTemplate::compileGraphic(SegmentType type, const char *arg, size_t n, const char *const *fields, uint8_t fieldCount, int defaultSize,
+                                     int maxSize) {
+    const char *space = (const char *)memchr(arg, ' ', n);
+    size_t nameLength = space != NULL ? space - arg : n;
+    int field = findName(fields, fieldCount, arg, nameLength);
+    if (field < 0) {
+        return fail("unknown field", arg, nameLength);
+    }
+    int size = space != NULL ? atoi(space + 1) : defaultSize;
+    if (size < 1 || size > maxSize) {
+        return size < 1 ? fail("size must be positive") : fail("size too large");
+    }
+    if (!addSegment(type, field, 0)) {
+        return false;
+    }
+    segments[segmentCount - 1].length = size;
+    return true;
+}
+
+bool ReceiptTemplate::compileDirective(const char *line, size_t n, const char *const *fields, uint8_t fieldCount, const char *const *flags,
+                                       uint8_t flagCount, uint8_t *ifStack, uint8_t &depth) {
+    // @name [arg]
+    const char *name = line + 1;
+    const char *end = line + n;
+    const char *p = name;
+    while (p < end && *p != ' ') {
+        p++;
+    }
+    size_t nameLength = p - name;
+    while (p < end && *p == ' ') {
+        p++;
+    }
+    const char *arg = p;
+    size_t argLength = end - p;
+    uint8_t value;
+
+    if (matches(name, nameLength, "reset")) {
+        uint8_t data[] = {BYTE_ESC, '@'};
+        return emit(data, sizeof(data));
+    }
+    if (matches(name, nameLength, "align")) {
+        return findKeyword(ALIGN_KEYWORDS, arg, argLength, value) ? emit3(BYTE_ESC, 'a', value) : fail("unknown align", arg, argLength);
+    }
+    if (matches(name, nameLength, "size")) {
+        return findKeyword(SIZE_KEYWORDS, arg, argLength, value) ? emit3(BYTE_ESC, 'M', value) : fail("unknown size", arg, argLength);
+    }
+    if (matches(name, nameLength, "bold")) {
+        return findKeyword(BOLD_KEYWORDS, arg, argLength, value) ? emit3(BYTE_ESC, '!', value) : fail("unknown bold", arg, argLength);
+    }
+    if (matches(name, nameLength, "highlight")) {
+        return findKeyword(HIGHLIGHT_KEYWORDS, arg, argLength, value) ? emit3(BYTE_ESC, '!', value) : fail("unknown highlight", arg, argLength);
+    }
+    if (matches(name, nameLength, "feed")) {
+        int lines = atoi(arg);
+        return lines > 0 && lines < 256 ? emit3(BYTE_ESC, 'd', lines) : fail("feed needs 1-255");
+    }
+    if (matches(name, nameLength, "logo")) {
+        // เก็บคำสั่งพิมพ์โลโก้ในเครื่องพิมพ์ไว้ใช้เมื่อไม่มีภาพโลโก้
+        uint8_t data[] = {BYTE_FS, 'p', 0x01, 0x00};
+        if (length + sizeof(data) > RECEIPT_MAX_BYTES) {
+            return fail("template too long");
+        }
+        if (!addSegment(SEGMENT_LOGO, 0, 0)) {
+            return false;
+        }
+        memcpy(bytes + length, data, sizeof(data));
+        length += sizeof(data);
+        segments[segmentCount - 1].length = sizeof(data);
+        return true;
+    }
+    if (matches(name, nameLength, "qr")) {
+        return compileGraphic(SEGMENT_QR, arg, argLength, fields, fieldCount, 4, 16);
+    }
+    if (matches(name, nameLength, "barcode")) {
+        return compileGraphic(SEGMENT_BARCODE, arg, argLength, fields, fieldCount, 60, 255);
+    }
+    if (matches(name, nameLength, "cut")) {
+        uint8_t data[] = {BYTE_GS, 'V', 65, 42};
+        return emit(data, sizeof(data));
+    }
+    if (matches(name, nameLength, "if")) {
+        int flag = findName(flags, flagCount, arg, argLength);
+        if (flag < 0) {
+            return fail("unknown flag", arg, argLength);
+        }
+        if (depth >= RECEIPT_MAX_NESTING) {
+            return fail("@if nested too deep");
+        }
+        ifStack[depth++] = segmentCount;
+        if (!addSegment(SEGMENT_IF, flag, 0)) {
+            return false;
+        }
+        mergeFrom = segmentCount;
+        return true;
+    }
+    if (matches(name, nameLength, "endif")) {
+        if (depth == 0) {
+            return fail("@endif without @if");
+        }
+        uint8_t index = ifStack[--depth];
+        segments[index].length = segmentCount - index - 1;
+        mergeFrom = segmentCount;
+        return true;
+    }
+    return fail("unknown command", name, nameLength);
+}
+
+bool ReceiptTemplate::compileText(const char *line, size_t n, const char *const *fields, uint8_t fieldCount) {
+    const char *end = line + n;
+    const char *p = line;
+    while (p < end) {
+        const char *open = (const char *)memchr(p, '{', end - p);
+        if (open == NULL) {
+            break;
+        }
+        if (open > p && !emit((const uint8_t *)p, open - p)) {
+            return false;
+        }
+        const char *close = (const char *)memchr(open, '}', end - open);
+        if (close == NULL) {
+            return fail("missing '}'");
+        }
+
+        // {name} หรือ {name:width}
+        const char *name = open + 1;
+        const char *colon = (const char *)memchr(name, ':', close - name);
+        size_t nameLength = (colon != NULL ? colon : close) - name;
+        int field = findName(fields, fieldCount, name, nameLength);
+        if (field < 0) {
+            return fail("unknown field", name, nameLength);
+        }
+        int width = colon != NULL ? atoi(colon + 1) : 0;
+        if (width < -64 || width > 64) {
+            return fail("width must be -64..64");
+        }
+        if (!addSegment(SEGMENT_FIELD, field, width)) {
+            return false;
+        }
+        p = close + 1;
+    }
+    if (p < end && !emit((const uint8_t *)p, end - p)) {
+        return false;
+    }
+    uint8_t lf = BYTE_LF;
+    return emit(&lf, 1);
+}
+
+bool ReceiptTemplate::compile(const char *source, const char *const *fields, uint8_t fieldCount, const char *const *flags, uint8_t flagCount) {
+    length = 0;
+    segmentCount = 0;
+    mergeFrom = 0;
+    valid = false;
+    lineNumber = 0;
+    errorText[0] = '\0';
+
+    uint8_t ifStack[RECEIPT_MAX_NESTING];
+    uint8_t depth = 0;
+    const char *p = source;
+    while (*p) {
+        lineNumber++;
+        const char *end = strchr(p, '\n');
+        if (end == NULL) {
+            end = p + strlen(p);
+        }
+        size_t n = end - p;
+        if (n > 0 && p[n - 1] == '\r') {
+            n--;
+        }
+
+        bool ok = true;
+        if (n > 0 && p[0] == '#') {
+            // comment
+        } else if (n > 0 && p[0] == '@') {
+            ok = compileDirective(p, n, fields, fieldCount, flags, flagCount, ifStack, depth);
+        } else {
+            ok = compileText(p, n, fields, fieldCount);
+        }
+        if (!ok) {
+            return false;
+        }
+        p = *end ? end + 1 : end;
+    }
+
+    if (depth > 0) {
+        return fail("missing @endif");
+    }
+    valid = true;
+    return true;
+}
+
+size_t ReceiptTemplate::render(Print &output, const char *const *values, uint32_t flags, EscRaster *raster) const {
+    if (!valid) {
+        return 0;
+    }
+
+    size_t written = 0;
+    uint8_t i = 0;
+    while (i < segmentCount) {
+        const Segment &segment = segments[i++];
+        switch (segment.type) {
+        case SEGMENT_BYTES:
+            written += output.write(bytes + segment.offset, segment.length);
+            break;
+
+        case SEGMENT_FIELD: {
+            const char *value = values[segment.arg] != NULL ? values[segment.arg] : "";
+            int valueLength = strlen(value);
+            int pad = abs(segment.width) - valueLength;
+            for (int k = 0; segment.width > 0 && k < pad; k++) {
+                written += output.write(' ');
+            }
+            written += output.write((const uint8_t *)value, valueLength);
+            for (int k = 0; segment.width < 0 && k < pad; k++) {
+                written += output.write(' ');
+            }
+            break;
+        }
+
+        case SEGMENT_IF:
+            if ((flags & (1UL << segment.arg)) == 0) {
+                i += segment.length;
+            }
+            break;
+
+        case SEGMENT_LOGO:
+            if (raster != NULL && raster->hasLogo()) {
+                written += raster->printLogo(output);
+            } else {
+                written += output.write(bytes + segment.offset, segment.length);
+            }
+            break;
+
+        case SEGMENT_QR:
+            if (raster != NULL && values[segment.arg] != NULL) {
+                written += raster->printQr(output, values[segment.arg], segment.length);
+            }
+            break;
+
+        case SEGMENT_BARCODE:
+            if (raster != NULL && values[segment.arg] != NULL) {
+                written += raster->printBarcode(output, values[segment.arg], segment.length);
+            }
+            break;
+        }
+    }
+    return written;
+}
@@ -0,0 +1,70 @@
+#ifndef RECEIPT_TEMPLATE_H
+#define RECEIPT_TEMPLATE_H
+
+#include "EscRaster.h"
+#include <Arduino.h>
+
+#define RECEIPT_MAX_BYTES 512    // คำสั่งและข้อความคงที่ทั้งหมดของ 1 template
+#define RECEIPT_MAX_SEGMENTS 64  // จำนวนช่วง (ข้อความคงที่, field, @if)
+#define RECEIPT_MAX_NESTING 4    // @if ซ้อนกันได้กี่ชั้น
+#define RECEIPT_ERROR_SIZE 64
+
+// แปลง template ของใบเสร็จเป็นชุดคำสั่ง ESC/POS ล่วงหน้า (compile ครั้งเดียวตอนเปิดเครื่องหรือแก้ไข)
+// ตอนพิมพ์เหลือแค่ copy ข้อความคงที่และเติมค่า field ลง Print (เช่น PrintJob) ไม่จอง memory
+//
+// รูปแบบ template (บรรทัดละคำสั่ง):
+//   ข้อความ {field} {field:8} {field:-8}   พิมพ์ข้อความแล้วขึ้นบรรทัดใหม่ (:8 ชิดขวากว้าง 8, :-8 ชิดซ้าย)
+//   @reset                                 ESC @
+//   @align left|center|right
+//   @size normal|large
+//   @bold on|off
+//   @highlight off|underline|larger|tall|big
+//   @feed <n>
+//   @logo                                  พิมพ์โลโก้ (ภาพจาก EscRaster ถ้าโหลดไว้ ไม่งั้นใช้โลโก้ที่เก็บในเครื่องพิมพ์)
+//   @qr <field> [scale]                    QR code ของค่า field (module ละ scale จุด, ค่าเริ่มต้น 4)
+//   @barcode <field> [height]              Code 128 ของค่า field สูง height จุด (ค่าเริ่มต้น 60) ยาวไม่เกิน 12 ตัวอักษร/24 ตัวเลข
+//   @cut
+//   @if <flag> ... @endif                  พิมพ์เฉพาะเมื่อ flag เป็นจริง
+//   # comment
+class ReceiptTemplate {
+  public:
+    ReceiptTemplate();
+    // fields / flags: ชื่อที่ใช้ใน template ตามลำดับ index ที่จะส่งให้ render()
+    bool compile(const char *source, const char *const *fields, uint8_t fieldCount, const char *const *flags, uint8_t flagCount);
+    // raster = NULL: ข้าม @qr/@barcode และใช้โลโก้ในเครื่องพิมพ์
+    size_t render(Print &output, const char *const *values, uint32_t flags, EscRaster *raster = NULL) const;
+
+    bool isValid() const { return valid; }
+    const char *error() const { return errorText; }
+    size_t size() const { return length; }
+
+  private:
+    enum SegmentType : uint8_t { SEGMENT_BYTES, SEGMENT_FIELD, SEGMENT_IF, SEGMENT_LOGO, SEGMENT_QR, SEGMENT_BARCODE };
+    struct Segment {
+        SegmentType type;
+        uint8_t arg;     // index ของ field หรือ flag
+        int8_t width;    // field: ความกว้าง (+ ชิดขวา, - ชิดซ้าย)
+        uint16_t offset; // bytes: ตำแหน่งใน bytes[]
+        uint16_t length; // bytes/logo: จำนวน byte, if: จำนวน segment ที่ข้ามเมื่อ flag เป็นเท็จ, qr/barcode: scale/ความสูง
+    };
+
+    uint8_t bytes[RECEIPT_MAX_BYTES];
+    Segment segments[RECEIPT_MAX_SEGMENTS];
+    uint16_t length;
+    uint8_t segmentCount;
+    uint8_t mergeFrom; // segment แรกที่ต่อข้อความได้ (ห้ามต่อข้าม @if / @endif)
+    bool valid;
+    int lineNumber;
+    char errorText[RECEIPT_ERROR_SIZE];
+
+    bool emit(const uint8_t *data, size_t n);
+    bool emit3(uint8_t a, uint8_t b, uint8_t c);
+    bool addSegment(SegmentType type, uint8_t arg, int8_t width);
+    bool compileDirective(const char *line, size_t n, const char *const *fields, uint8_t fieldCount, const char *const *flags, uint8_t flagCount,
+                          uint8_t *ifStack, uint8_t &depth);
+    bool compileGraphic(SegmentType type, const char *arg, size_t n, const char *const *fields, uint8_t fieldCount, int defaultSize, int maxSize);
+    bool compileText(const char *line, size_t n, const char *const *fields, uint8_t fieldCount);
+    bool fail(const char *message, const char *detail = NULL, size_t detailLength = 0);
+};
+
+#endif // RECEIPT_TEMPLATE_H
@@ -0,0 +1,83 @@
+#include "RecordPool.h"
+#include <esp_heap_caps.h>
+
+namespace {
+
+inline uint32_t pack(uint32_t old, uint16_t index) { return ((old + 0x10000) & 0xFFFF0000) | index; }
+
+} // namespace
+
+RecordPool::RecordPool() : records(NULL), next(NULL), capacity(0), head(RECORD_POOL_EMPTY), inUse(0), highWater(0), acquired(0), dropped(0) {}
+
+bool RecordPool::begin(uint16_t capacity) {
+    if (records != NULL || capacity == 0 || capacity >= RECORD_POOL_EMPTY) {
+        return false;
+    }
+    records = (WeighRecord *)heap_caps_malloc((size_t)capacity * sizeof(WeighRecord), MALLOC_CAP_SPIRAM);
+    if (records == NULL) {
+        records = (WeighRecord *)malloc((size_t)capacity * sizeof(WeighRecord));
+    }
+    next = (std::atomic<uint16_t> *)malloc(capacity * sizeof(std::atomic<uint16_t>));
+    if (records == NULL || next == NULL) {
+        Serial.printf("(RecordPool)=> Allocate %u records failed\n", capacity);
+        free(records);
+        free(next);
+        records = NULL;
+        next = NULL;
+        return false;
+    }
+
+    // slot ทั้งหมดเริ่มอยู่ใน free list เรียง 0, 1, 2, ...
+    for (uint16_t i = 0; i < capacity; i++) {
+        next[i].store(i + 1 < capacity ? i + 1 : RECORD_POOL_EMPTY, std::memory_order_relaxed);
+    }
+    this->capacity = capacity;
+    head.store(0);
+    Serial.printf("(RecordPool)=> %u records x %u bytes\n", capacity, sizeof(WeighRecord));
+    return true;
+}
+
+WeighRecord *RecordPool::acquire() {
+    uint32_t old = head.load(std::memory_order_acquire);
+    uint16_t index;
+    do {
+        index = old & 0xFFFF;
+        if (index == RECORD_POOL_EMPTY) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return NULL;
+        }
+    } while (!head.compare_exchange_weak(old, pack(old, next[index].load(std::memory_order_relaxed)), std::memory_order_acq_rel,
+                                         std::memory_order_acquire));
+
+    acquired.fetch_add(1, std::memory_order_relaxed);
+    uint16_t used = inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint16_t peak = highWater.load(std::memory_order_relaxed);
+    while (used > peak && !highWater.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+    }
+
+    WeighRecord *record = &records[index];
+    memset(record, 0, sizeof(WeighRecord));
+    return record;
+}
+
+void RecordPool::release(WeighRecord *record) {
+    if (record == NULL || record < records || record >= records + capacity) {
+        return;
+    }
+    uint16_t index = record - records;
+    uint32_t old = head.load(std::memory_order_relaxed);
+    do {
+        next[index].store(old & 0xFFFF, std::memory_order_relaxed);
+    } while (!head.compare_exchange_weak(old, pack(old, index), std::memory_order_release, std::memory_order_relaxed));
+    inUse.fetch_sub(1, std::memory_order_relaxed);
+}
+
+RecordPoolStats RecordPool::stats() const {
+    RecordPoolStats s;
+    s.capacity = capacity;
+    s.inUse = inUse.load(std::memory_order_relaxed);
+    s.highWater = highWater.load(std::memory_order_relaxed);
+    s.acquired = acquired.load(std::memory_order_relaxed);
+    s.dropped = dropped.load(std::memory_order_relaxed);
+    return s;
+}
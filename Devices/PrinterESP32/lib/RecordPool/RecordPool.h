@@ -0,0 +1,60 @@
+#ifndef RECORD_POOL_H
+#define RECORD_POOL_H
+
+#include <Arduino.h>
+#include <atomic>
+
+#define RECORD_POOL_EMPTY 0xFFFF // index ว่างของ free list (capacity ต้องน้อยกว่านี้)
+
+// ผลชั่ง/นับ 1 ครั้ง เก็บเป็นค่าดิบ แปลงเป็น JSON ตอนส่งเท่านั้น
+// ไม่มี pointer: copy ทั้งก้อนลง outbox แล้วอ่านกลับหลังรีเซ็ตได้
+struct WeighRecord {
+    char timestamp[20]; // "YYYY-MM-DD hh:mm:ss"
+    int32_t operator1;
+    int32_t operator2;
+    uint8_t mode; // MODE_GRAM / MODE_PCS
+    bool pass;
+    float minWeight; // MODE_GRAM
+    float maxWeight;
+    float weight;
+    int32_t target; // MODE_PCS
+    int32_t pcs;
+    char ticket[8];         // queued/held/skipped, "" = ไม่ได้พิมพ์ (ยังไม่ส่ง server)
+    char printerStatus[16]; // ใช้เมื่อพิมพ์ (ยังไม่ส่ง server)
+    uint32_t created;       // millis() ตอนชั่ง ใช้วัดเวลาจนส่งถึง server
+};
+
+// สถิติการใช้ pool ดูใน tab หน่วยความจำ
+struct RecordPoolStats {
+    uint16_t capacity;
+    uint16_t inUse;
+    uint16_t highWater; // ใช้พร้อมกันมากสุดตั้งแต่เปิดเครื่อง
+    uint32_t acquired;
+    uint32_t dropped; // pool เต็ม ข้อมูลชั่งครั้งนั้นไม่ได้ส่ง
+};
+
+// pool ขนาดคงที่ของ WeighRecord จองใน PSRAM ครั้งเดียวตอน begin() ไม่มี new/delete ต่อการชั่ง
+// free list เป็น stack แบบ lock-free (compare-exchange ที่ head) acquire/release ได้จากทุก task
+// head เก็บ index ตัวบนสุด 16 bit + tag 16 bit ที่เพิ่มทุกครั้ง กัน ABA เมื่อ slot ถูกคืนแล้วยืมซ้ำระหว่าง CAS
+class RecordPool {
+  public:
+    RecordPool();
+    bool begin(uint16_t capacity);
+
+    WeighRecord *acquire(); // NULL เมื่อ pool เต็ม
+    void release(WeighRecord *record);
+
+    RecordPoolStats stats() const;
+
+  private:
+    WeighRecord *records;
+    std::atomic<uint16_t> *next; // slot ถัดไปใน free list (อ่านพร้อมกับ task ที่คืน slot เดียวกันได้)
+    uint16_t capacity;
+    std::atomic<uint32_t> head;
+    std::atomic<uint16_t> inUse;
+    std::atomic<uint16_t> highWater;
+    std::atomic<uint32_t> acquired;
+    std::atomic<uint32_t> dropped;
+};
+
+#endif // RECORD_POOL_H
@@ -0,0 +1,457 @@
+#include "SDCard.h"
+#include <esp_heap_caps.h>
+
+namespace {
+
+// buffer ของ SdWriter/SdReader: DMA-capable และ aligned 4 byte ให้ SPI ส่งตรงจาก buffer ไม่ต้อง copy ซ้ำ
+uint8_t *allocateBuffer() {
+    uint8_t *buffer = (uint8_t *)heap_caps_aligned_alloc(4, SD_BUFFER_SIZE, MALLOC_CAP_DMA);
+    if (buffer == NULL) {
+        Serial.printf("(SD)=> Allocate %d bytes buffer failed\n", SD_BUFFER_SIZE);
+    }
+    return buffer;
+}
+
+void copyWhitespace(SdReader &input, Print *output) {
+    while (isspace(input.peek())) {
+        int c = input.read();
+        if (output != NULL) {
+            output->write((uint8_t)c);
+        }
+    }
+}
+
+// copy string ของ JSON (รวมเครื่องหมายคำพูด) เก็บเนื้อหาลง capture ถ้าให้มา (ตัดที่ size - 1)
+bool copyString(SdReader &input, Print *output, char *capture, size_t size) {
+    if (input.read() != '"') {
+        return false;
+    }
+    if (output != NULL) {
+        output->write('"');
+    }
+    size_t length = 0;
+    bool escape = false;
+    for (int c; (c = input.read()) >= 0;) {
+        if (output != NULL) {
+            output->write((uint8_t)c);
+        }
+        if (!escape && c == '"') {
+            if (capture != NULL) {
+                capture[length] = '\0';
+            }
+            return true;
+        }
+        escape = !escape && c == '\\';
+        if (capture != NULL && length < size - 1) {
+            capture[length++] = c;
+        }
+    }
+    return false;
+}
+
+// copy ค่า JSON 1 ค่า (output = NULL คือข้ามไป) object/array นับแค่วงเล็บ ไม่ต้อง parse ข้างใน
+bool copyValue(SdReader &input, Print *output) {
+    int c = input.peek();
+    if (c == '"') {
+        return copyString(input, output, NULL, 0);
+    }
+    if (c == '{' || c == '[') {
+        int depth = 0;
+        do {
+            c = input.peek();
+            if (c == '"') {
+                if (!copyString(input, output, NULL, 0)) {
+                    return false;
+                }
+                continue;
+            }
+            if ((c = input.read()) < 0) {
+                return false;
+            }
+            if (output != NULL) {
+                output->write((uint8_t)c);
+            }
+            depth += (c == '{' || c == '[') ? 1 : (c == '}' || c == ']') ? -1 : 0;
+        } while (depth > 0);
+        return true;
+    }
+    // ตัวเลข, true, false, null
+    size_t length = 0;
+    while ((c = input.peek()) >= 0 && c != ',' && c != '}' && c != ']' && !isspace(c)) {
+        input.read();
+        if (output != NULL) {
+            output->write((uint8_t)c);
+        }
+        length++;
+    }
+    return length > 0;
+}
+
+void writeString(Print &output, const char *text) {
+    output.write('"');
+    for (const char *p = text; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            output.write('\\');
+            output.write((uint8_t)*p);
+        } else if ((uint8_t)*p < 0x20) {
+            output.printf("\\u%04x", *p);
+        } else {
+            output.write((uint8_t)*p);
+        }
+    }
+    output.write('"');
+}
+
+} // namespace
+
+SdWriter::SdWriter() : buffer(NULL), length(0), failed(false) {}
+
+SdWriter::~SdWriter() { close(); }
+
+bool SdWriter::open(fs::FS &fs, const char *path, const char *mode) {
+    close();
+    file = fs.open(path, mode);
+    if (!file) {
+        Serial.printf("(SD)=> Open %s for writing failed\n", path);
+        return false;
+    }
+    buffer = allocateBuffer();
+    if (buffer == NULL) {
+        file.close();
+        return false;
+    }
+    length = 0;
+    failed = false;
+    return true;
+}
+
+bool SdWriter::flushBuffer() {
+    if (length > 0 && file.write(buffer, length) != length) {
+        failed = true;
+    }
+    length = 0;
+    return !failed;
+}
+
+size_t SdWriter::write(uint8_t c) {
+    if (buffer == NULL) {
+        return 0;
+    }
+    if (length == SD_BUFFER_SIZE && !flushBuffer()) {
+        return 0;
+    }
+    buffer[length++] = c;
+    return 1;
+}
+
+size_t SdWriter::write(const uint8_t *data, size_t size) {
+    if (buffer == NULL) {
+        return 0;
+    }
+    size_t written = 0;
+    while (written < size) {
+        // ก้อนใหญ่ตอน buffer ว่าง: เขียนตรงทีละ SD_BUFFER_SIZE ไม่ต้อง copy
+        if (length == 0 && size - written >= SD_BUFFER_SIZE) {
+            size_t chunk = (size - written) / SD_BUFFER_SIZE * SD_BUFFER_SIZE;
+            if (file.write(data + written, chunk) != chunk) {
+                failed = true;
+                return written;
+            }
+            written += chunk;
+            continue;
+        }
+        size_t chunk = min(size - written, (size_t)(SD_BUFFER_SIZE - length));
+        memcpy(buffer + length, data + written, chunk);
+        length += chunk;
+        written += chunk;
+        if (length == SD_BUFFER_SIZE && !flushBuffer()) {
+            return written;
+        }
+    }
+    return written;
+}
+
+bool SdWriter::close() {
+    if (buffer == NULL) {
+        return !failed;
+    }
+    flushBuffer();
+    file.close();
+    heap_caps_free(buffer);
+    buffer = NULL;
+    return !failed;
+}
+
+SdReader::SdReader() : buffer(NULL), length(0), position(0) {}
+
+SdReader::~SdReader() { close(); }
+
+bool SdReader::open(fs::FS &fs, const char *path) {
+    close();
+    file = fs.open(path, FILE_READ);
+    if (!file || file.isDirectory()) {
+        file.close();
+        return false;
+    }
+    buffer = allocateBuffer();
+    if (buffer == NULL) {
+        file.close();
+        return false;
+    }
+    length = position = 0;
+    return true;
+}
+
+bool SdReader::fill() {
+    if (position < length) {
+        return true;
+    }
+    if (buffer == NULL) {
+        return false;
+    }
+    int n = file.read(buffer, SD_BUFFER_SIZE);
+    length = n > 0 ? n : 0;
+    position = 0;
+    return length > 0;
+}
+
+int SdReader::available() {
+    if (buffer == NULL) {
+        return 0;
+    }
+    return (length - position) + file.available();
+}
+
+int SdReader::read() { return fill() ? buffer[position++] : -1; }
+
+int SdReader::peek() { return fill() ? buffer[position] : -1; }
+
+size_t SdReader::read(uint8_t *data, size_t size) {
+    size_t done = 0;
+    while (done < size && fill()) {
+        size_t chunk = min(size - done, length - position);
+        memcpy(data + done, buffer + position, chunk);
+        position += chunk;
+        done += chunk;
+    }
+    return done;
+}
+
+void SdReader::close() {
+    if (buffer == NULL) {
+        return;
+    }
+    file.close();
+    heap_caps_free(buffer);
+    buffer = NULL;
+    length = position = 0;
+}
+
+SDCard::SDCard() : spi(FSPI), csPin(-1), frequency(SD_FREQUENCY), mounted(false), lastCheck(0) {}
+
+bool SDCard::begin(int8_t csPin, int8_t sckPin, int8_t misoPin, int8_t mosiPin, uint32_t frequency) {
+    this->csPin = csPin;
+    this->frequency = frequency;
+    spi.begin(sckPin, misoPin, mosiPin, csPin);
+    lastCheck = millis();
+    return mount();
+}
+
+bool SDCard::mount() {
+    if (!SD.begin(csPin, spi, frequency)) {
+        return false;
+    }
+    if (SD.cardType() == CARD_NONE) {
+        SD.end();
+        return false;
+    }
+    mounted = true;
+    Serial.printf("(SD)=> Mounted %llu MB\n", SD.cardSize() / (1024 * 1024));
+    return true;
+}
+
+void SDCard::unmount(const char *reason) {
+    SD.end();
+    mounted = false;
+    Serial.printf("(SD)=> Unmounted: %s\n", reason);
+}
+
+bool SDCard::check() {
+    if (csPin < 0 || millis() - lastCheck < SD_CHECK_INTERVAL) {
+        return mounted;
+    }
+    lastCheck = millis();
+    if (!mounted) {
+        return mount();
+    }
+    // ถอดการ์ด: FATFS ยังคิดว่า mount อยู่ อ่าน sector 0 ตรงๆ ถึงจะรู้
+    if (!SD.readRAW(sector, 0)) {
+        unmount("card removed");
+    }
+    return mounted;
+}
+
+bool SDCard::replace(const char *path, const char *temp) {
+    if (SD.exists(path) && !SD.remove(path)) {
+        return false;
+    }
+    return SD.rename(temp, path);
+}
+
+bool SDCard::writeJson(const char *path, const JsonDocument &doc) {
+    if (!mounted) {
+        return false;
+    }
+    String temp = tempPath(path);
+    SdWriter writer;
+    if (!writer.open(SD, temp.c_str())) {
+        return false;
+    }
+    size_t size = serializeJson(doc, writer);
+    if (!writer.close() || size == 0 || !replace(path, temp.c_str())) {
+        Serial.printf("(SD)=> Write %s failed\n", path);
+        SD.remove(temp);
+        return false;
+    }
+    return true;
+}
+
+bool SDCard::readJson(const char *path, JsonDocument &doc) {
+    if (!mounted) {
+        return false;
+    }
+    // ไฟล์หลักหาย (ไฟดับระหว่าง remove กับ rename) ใช้ .tmp ที่เขียนเสร็จแล้วแทน
+    SdReader reader;
+    if (!reader.open(SD, path) && !reader.open(SD, tempPath(path).c_str())) {
+        return false;
+    }
+    DeserializationError error = deserializeJson(doc, reader);
+    if (error) {
+        Serial.printf("(SD)=> Read %s failed: %s\n", path, error.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool SDCard::updateJson(const char *path, const char *key, const char *value) {
+    if (!mounted) {
+        return false;
+    }
+    // ไฟล์หลักหาย (ไฟดับระหว่าง remove กับ rename) ข้อมูลอยู่ใน .tmp ย้ายกลับก่อน ไม่อย่างนั้นเปิด writer จะทับทิ้ง
+    String temp = tempPath(path);
+    if (!SD.exists(path) && SD.exists(temp.c_str()) && !SD.rename(temp.c_str(), path)) {
+        Serial.printf("(SD)=> Recover %s failed\n", path);
+        return false;
+    }
+    SdWriter writer;
+    if (!writer.open(SD, temp.c_str())) {
+        return false;
+    }
+
+    SdReader reader;
+    bool ok = true;
+    bool found = false;
+    bool empty = true;
+    if (reader.open(SD, path)) {
+        copyWhitespace(reader, NULL);
+        ok = reader.read() == '{';
+        writer.write('{');
+        while (ok) {
+            copyWhitespace(reader, &writer);
+            int c = reader.peek();
+            if (c == '}') {
+                break;
+            }
+            if (c == ',') {
+                writer.write(reader.read());
+                continue;
+            }
+            char name[SD_KEY_MAX];
+            ok = copyString(reader, &writer, name, sizeof(name));
+            copyWhitespace(reader, &writer);
+            ok = ok && reader.read() == ':';
+            writer.write(':');
+            copyWhitespace(reader, &writer);
+            if (ok && !found && strcmp(name, key) == 0) {
+                ok = copyValue(reader, NULL);
+                writeString(writer, value);
+                found = true;
+            } else {
+                ok = ok && copyValue(reader, &writer);
+            }
+            empty = false;
+        }
+        ok = ok && reader.read() == '}';
+        reader.close();
+    } else {
+        writer.write('{');
+    }
+
+    if (!found) {
+        if (!empty) {
+            writer.write(',');
+        }
+        writeString(writer, key);
+        writer.write(':');
+        writeString(writer, value);
+    }
+    writer.write('}');
+    if (!writer.close() || !ok || !replace(path, temp.c_str())) {
+        Serial.printf("(SD)=> Update %s failed%s\n", path, ok ? "" : " (not a JSON object)");
+        SD.remove(temp);
+        return false;
+    }
+    return true;
+}
+
+bool SDCard::benchmark(const char *path, uint32_t kilobytes, SdBenchmark &result) {
+    memset(&result, 0, sizeof(result));
+    if (!mounted) {
+        return false;
+    }
+    result.bytes = kilobytes * 1024;
+
+    // แบบ buffer
+    uint32_t start = micros();
+    SdWriter writer;
+    if (!writer.open(SD, path)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < result.bytes; i++) {
+        writer.write((uint8_t)i);
+    }
+    bool ok = writer.close();
+    result.writeUs = micros() - start;
+
+    start = micros();
+    SdReader reader;
+    uint32_t count = 0;
+    if (reader.open(SD, path)) {
+        for (int c; (c = reader.read()) >= 0; count++) {
+            ok = ok && c == (uint8_t)count;
+        }
+        reader.close();
+    }
+    result.readUs = micros() - start;
+    ok = ok && count == result.bytes;
+
+    // ทีละ byte ผ่าน File ตรงๆ (แบบ SD_CARD.h เดิม)
+    start = micros();
+    File file = SD.open(path, FILE_WRITE);
+    for (uint32_t i = 0; file && i < result.bytes; i++) {
+        file.write((uint8_t)i);
+    }
+    file.close();
+    result.byteWriteUs = micros() - start;
+
+    start = micros();
+    file = SD.open(path, FILE_READ);
+    while (file && file.available()) {
+        file.read();
+    }
+    file.close();
+    result.byteReadUs = micros() - start;
+
+    SD.remove(path);
+    return ok;
+}
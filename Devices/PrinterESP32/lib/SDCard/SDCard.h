@@ -0,0 +1,98 @@
+#ifndef SD_CARD_H
+#define SD_CARD_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FS.h>
+#include <SD.h>
+#include <SPI.h>
+
+#define SD_BUFFER_SIZE 4096    // byte ต่อครั้งที่อ่าน/เขียนการ์ด (ทวีคูณของ sector 512, จองแบบ aligned)
+#define SD_CHECK_INTERVAL 1000 // ms ตรวจว่าการ์ดยังอยู่ / ลอง mount ใหม่หลังถอดการ์ด
+#define SD_FREQUENCY 20000000  // Hz ของ SPI
+#define SD_KEY_MAX 64          // ความยาว key สูงสุดที่ updateJson() เทียบได้
+
+// เขียนไฟล์ผ่าน buffer: ส่งลงการ์ดครั้งละ SD_BUFFER_SIZE (FATFS เขียนตรงทั้ง sector ไม่ต้องผ่าน cache ของตัวเอง)
+class SdWriter : public Print {
+  public:
+    SdWriter();
+    ~SdWriter();
+    bool open(fs::FS &fs, const char *path, const char *mode = FILE_WRITE);
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *data, size_t size) override;
+    bool close(); // false ถ้ามีการเขียนครั้งใดไม่สำเร็จ
+
+  private:
+    File file;
+    uint8_t *buffer;
+    size_t length;
+    bool failed;
+
+    bool flushBuffer();
+};
+
+// อ่านไฟล์ผ่าน buffer: read()/peek() ทีละ byte ไม่ต้องเรียก FS (ใช้กับ deserializeJson ได้โดยตรง)
+class SdReader : public Stream {
+  public:
+    SdReader();
+    ~SdReader();
+    bool open(fs::FS &fs, const char *path);
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t *data, size_t size);
+    size_t write(uint8_t c) override { return 0; }
+    size_t size() { return file ? file.size() : 0; }
+    void close();
+
+  private:
+    File file;
+    uint8_t *buffer;
+    size_t length;
+    size_t position;
+
+    bool fill();
+};
+
+// ผลวัดความเร็ว: แบบ buffer เทียบกับอ่าน/เขียนทีละ byte (แบบ SD_CARD.h เดิม)
+struct SdBenchmark {
+    uint32_t bytes;
+    uint32_t writeUs;
+    uint32_t readUs;
+    uint32_t byteWriteUs;
+    uint32_t byteReadUs;
+};
+
+// SD card ผ่าน SPI: mount ครั้งเดียวตอน begin() แล้วใช้ต่อ ไม่ mount ใหม่ทุกครั้งที่อ่าน/เขียน
+// check() (เรียกจาก loop) อ่าน sector 0 ตาม SD_CHECK_INTERVAL ถ้าอ่านไม่ได้ถือว่าถอดการ์ด unmount แล้วรอเสียบใหม่
+// ไฟล์ JSON อ่าน/เขียนแบบ stream ไม่โหลดทั้งไฟล์เป็น String, เขียนลงไฟล์ .tmp ก่อนแล้วค่อยแทนไฟล์เดิม
+class SDCard {
+  public:
+    SDCard();
+    bool begin(int8_t csPin, int8_t sckPin, int8_t misoPin, int8_t mosiPin, uint32_t frequency = SD_FREQUENCY);
+    bool check();
+    bool isMounted() const { return mounted; }
+    fs::FS &fs() { return SD; }
+
+    bool writeJson(const char *path, const JsonDocument &doc);
+    bool readJson(const char *path, JsonDocument &doc);
+    // แก้ค่า key เดียวใน object ชั้นนอกสุด: copy ไฟล์เดิมทีละ token ลงไฟล์ใหม่ แทนค่าเฉพาะ key นั้น (ไม่ parse ทั้งไฟล์)
+    bool updateJson(const char *path, const char *key, const char *value);
+
+    bool benchmark(const char *path, uint32_t kilobytes, SdBenchmark &result);
+
+  private:
+    SPIClass spi;
+    int8_t csPin;
+    uint32_t frequency;
+    volatile bool mounted;
+    uint32_t lastCheck;
+    uint8_t sector[512];
+
+    bool mount();
+    void unmount(const char *reason);
+    bool replace(const char *path, const char *temp);
+    static String tempPath(const char *path) { return String(path) + ".tmp"; }
+};
+
+#endif // SD_CARD_H
@@ -0,0 +1,144 @@
+#include "ScaleReader.h"
+
+ScaleFrame ScaleReader::slots[SCALE_FRAME_SLOTS];
+QueueHandle_t ScaleReader::freeQueue = NULL;
+QueueHandle_t ScaleReader::readyQueue = NULL;
+
+ScaleReader::ScaleReader()
+    : serial(NULL), port(0), framing(SCALE_FRAMING_DEFAULT), enabled(false), resetRequested(false), state(WAIT_START), current(NULL), lastByteTime(0),
+      frames(0), dropped(0) {}
+
+// สร้าง pool ครั้งเดียว: slot ทั้งหมดเริ่มอยู่ใน freeQueue
+bool ScaleReader::initPool() {
+    if (freeQueue != NULL) {
+        return true;
+    }
+    freeQueue = xQueueCreate(SCALE_FRAME_SLOTS, sizeof(ScaleFrame *));
+    readyQueue = xQueueCreate(SCALE_FRAME_SLOTS, sizeof(ScaleFrame *));
+    if (freeQueue == NULL || readyQueue == NULL) {
+        return false;
+    }
+    for (int i = 0; i < SCALE_FRAME_SLOTS; i++) {
+        ScaleFrame *frame = &slots[i];
+        xQueueSend(freeQueue, &frame, 0);
+    }
+    return true;
+}
+
+bool ScaleReader::begin(HardwareSerial &serial, uint8_t port, const ScaleFraming &framing) {
+    if (!initPool()) {
+        Serial.println("(ScaleReader)=> Create frame pool failed");
+        return false;
+    }
+    this->serial = &serial;
+    this->port = port;
+    this->framing = framing;
+    if (this->framing.maxLength == 0 || this->framing.maxLength > SCALE_FRAME_MAX) {
+        this->framing.maxLength = SCALE_FRAME_MAX;
+    }
+    enabled = true;
+    serial.onReceive([this]() { onReceive(); });
+    return true;
+}
+
+// ปิดไว้เมื่อ port นี้ต้องใช้ทำอย่างอื่น (เช่น Serial รับคำสั่ง) ข้อมูลจะค้างใน buffer ของ driver ให้คนอื่นอ่าน
+void ScaleReader::setEnabled(bool enabled) {
+    if (this->enabled != enabled) {
+        this->enabled = enabled;
+        resetRequested = true;
+    }
+}
+
+// เรียกจาก task ของ UART driver เมื่อมีข้อมูลเข้า
+void ScaleReader::onReceive() {
+    if (resetRequested) {
+        resetRequested = false;
+        resetFrame();
+    }
+    if (!enabled) {
+        return;
+    }
+
+    uint8_t buffer[64];
+    size_t n;
+    while ((n = serial->available()) > 0) {
+        n = serial->read(buffer, n < sizeof(buffer) ? n : sizeof(buffer));
+        for (size_t i = 0; i < n; i++) {
+            feed(buffer[i]);
+        }
+    }
+}
+
+void ScaleReader::feed(uint8_t c) {
+    uint32_t now = millis();
+    if (state != WAIT_START && now - lastByteTime > framing.timeoutMs) {
+        // byte ห่างกันเกินไป ถือว่า frame ก่อนหน้าขาด
+        resetFrame();
+    }
+    lastByteTime = now;
+
+    switch (state) {
+    case WAIT_START:
+        if (c == framing.terminator || c == '\r') {
+            return;
+        }
+        if (current == NULL && xQueueReceive(freeQueue, &current, 0) != pdTRUE) {
+            // ผู้ใช้ยังไม่คืน frame ทิ้งทั้งบรรทัดนี้
+            current = NULL;
+            dropped++;
+            state = DISCARD;
+            return;
+        }
+        current->port = port;
+        current->length = 0;
+        current->received = micros();
+        state = RECEIVING;
+        // fall through
+    case RECEIVING:
+        if (c == framing.terminator) {
+            finishFrame();
+        } else if (current->length >= framing.maxLength) {
+            Serial.printf("(ScaleReader)=> Port %d frame too long\n", port);
+            dropped++;
+            state = DISCARD;
+        } else if (c != '\r') {
+            current->data[current->length++] = c;
+        }
+        break;
+    case DISCARD:
+        if (c == framing.terminator) {
+            state = WAIT_START;
+        }
+        break;
+    }
+}
+
+void ScaleReader::finishFrame() {
+    current->data[current->length] = '\0';
+    if (xQueueSend(readyQueue, &current, 0) == pdTRUE) {
+        current = NULL;
+        frames++;
+    } else {
+        dropped++; // ใช้ slot เดิมต่อสำหรับ frame ถัดไป
+    }
+    state = WAIT_START;
+}
+
+void ScaleReader::resetFrame() {
+    if (current != NULL) {
+        current->length = 0;
+    }
+    state = WAIT_START;
+}
+
+bool ScaleReader::receive(ScaleFrame **frame, TickType_t wait) {
+    return readyQueue != NULL && xQueueReceive(readyQueue, frame, wait) == pdTRUE;
+}
+
+void ScaleReader::release(ScaleFrame *frame) {
+    if (frame != NULL) {
+        xQueueSend(freeQueue, &frame, 0);
+    }
+}
+
+UBaseType_t ScaleReader::pending() { return readyQueue != NULL ? uxQueueMessagesWaiting(readyQueue) : 0; }
@@ -0,0 +1,68 @@
+#ifndef SCALE_READER_H
+#define SCALE_READER_H
+
+#include <Arduino.h>
+
+#define SCALE_FRAME_MAX 48  // ความยาวข้อมูลสูงสุดต่อ 1 frame (ไม่รวม '\0')
+#define SCALE_FRAME_SLOTS 8 // จำนวน frame ใน pool (ใช้ร่วมกันทุก port)
+
+// ข้อมูลเครื่องชั่ง 1 บรรทัด
+struct ScaleFrame {
+    uint8_t port;      // หมายเลข port ที่ส่งมา (ตามที่กำหนดใน begin)
+    uint8_t length;    // ความยาวข้อมูล
+    uint32_t received; // micros() ตอนได้รับ byte แรกของ frame
+    char data[SCALE_FRAME_MAX + 1];
+};
+
+// รูปแบบการตัด frame
+struct ScaleFraming {
+    char terminator;    // ตัวจบ frame (ปกติ '\n')
+    uint16_t timeoutMs; // ช่วงห่างระหว่าง byte สูงสุด ถ้าเกินจะทิ้ง frame ที่ค้างอยู่
+    uint8_t maxLength;  // ยาวเกินนี้ทิ้งทั้ง frame (ไม่เกิน SCALE_FRAME_MAX)
+};
+
+#define SCALE_FRAMING_DEFAULT {'\n', 100, SCALE_FRAME_MAX}
+
+// อ่านข้อมูลเครื่องชั่งจาก UART แบบ event-driven
+// HardwareSerial::onReceive() ทำงานใน task ของ UART driver แต่ละ port (รอ event queue ของ driver)
+// แต่ละ port มี state machine ของตัวเอง เขียนลง frame จาก pool โดยตรง
+// frame ที่ครบแล้วส่ง pointer เข้า queue กลาง ผู้ใช้ต้องเรียก release() เมื่อใช้เสร็จ
+class ScaleReader {
+  public:
+    ScaleReader();
+    bool begin(HardwareSerial &serial, uint8_t port, const ScaleFraming &framing = SCALE_FRAMING_DEFAULT);
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled; }
+    uint32_t framesReceived() const { return frames; }
+    uint32_t framesDropped() const { return dropped; }
+
+    static bool receive(ScaleFrame **frame, TickType_t wait = 0);
+    static void release(ScaleFrame *frame);
+    static UBaseType_t pending();
+
+  private:
+    enum State { WAIT_START, RECEIVING, DISCARD };
+
+    HardwareSerial *serial;
+    uint8_t port;
+    ScaleFraming framing;
+    volatile bool enabled;
+    volatile bool resetRequested;
+    State state;
+    ScaleFrame *current;
+    uint32_t lastByteTime;
+    uint32_t frames;
+    uint32_t dropped;
+
+    static ScaleFrame slots[SCALE_FRAME_SLOTS];
+    static QueueHandle_t freeQueue;
+    static QueueHandle_t readyQueue;
+
+    static bool initPool();
+    void onReceive();
+    void feed(uint8_t c);
+    void finishFrame();
+    void resetFrame();
+};
+
+#endif // SCALE_READER_H
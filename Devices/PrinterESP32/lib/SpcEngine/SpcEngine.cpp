@@ -0,0 +1,115 @@
+#include "SpcEngine.h"
+
+namespace {
+
+// ค่าคงที่ของกราฟ X-bar/R ตามขนาด subgroup n = 2..10
+const float A2[] = {1.880f, 1.023f, 0.729f, 0.577f, 0.483f, 0.419f, 0.373f, 0.337f, 0.308f};
+const float D3[] = {0, 0, 0, 0, 0, 0.076f, 0.136f, 0.184f, 0.223f};
+const float D4[] = {3.267f, 2.574f, 2.282f, 2.114f, 2.004f, 1.924f, 1.864f, 1.816f, 1.777f};
+const float D2[] = {1.128f, 1.693f, 2.059f, 2.326f, 2.534f, 2.704f, 2.847f, 2.970f, 3.078f};
+
+static_assert(SPC_SUBGROUP_SIZE >= 2 && SPC_SUBGROUP_SIZE <= 10, "SPC_SUBGROUP_SIZE must be 2-10");
+const uint8_t K = SPC_SUBGROUP_SIZE - 2;
+
+} // namespace
+
+SpcEngine::SpcEngine() : offset(0) {
+    memset(&state, 0, sizeof(state));
+    reset();
+}
+
+void SpcEngine::reset() {
+    head = 0;
+    sum = sumSq = 0;
+    subgroupHead = 0;
+    xbarSum = rangeSum = 0;
+    groupCount = 0;
+    groupSum = 0;
+
+    float lower = state.lower, upper = state.upper;
+    memset(&state, 0, sizeof(state));
+    state.lower = lower;
+    state.upper = upper;
+    state.reset = true;
+    state.cp = state.cpk = state.pp = state.ppk = NAN;
+}
+
+void SpcEngine::setLimits(float lower, float upper) {
+    if (lower == state.lower && upper == state.upper) {
+        return;
+    }
+    state.lower = lower;
+    state.upper = upper;
+    offset = upper > lower ? (lower + upper) / 2 : 0;
+    reset();
+}
+
+const SpcSnapshot &SpcEngine::add(float value) {
+    bool wasReset = state.reset && state.count == 0;
+    state.reset = wasReset;
+    state.newSubgroup = false;
+    state.last = value;
+
+    // หน้าต่างน้ำหนัก
+    double d = value - offset;
+    if (state.count == SPC_WINDOW) {
+        double old = values[head] - offset;
+        sum -= old;
+        sumSq -= old * old;
+    } else {
+        state.count++;
+    }
+    values[head] = value;
+    head = (head + 1) % SPC_WINDOW;
+    sum += d;
+    sumSq += d * d;
+
+    double mean = sum / state.count;
+    state.mean = offset + mean;
+    double variance = state.count > 1 ? (sumSq - sum * mean) / (state.count - 1) : 0;
+    state.stdDev = variance > 0 ? sqrt(variance) : 0;
+
+    // subgroup ที่กำลังเก็บ
+    groupSum += d;
+    groupMin = groupCount == 0 ? value : min(groupMin, value);
+    groupMax = groupCount == 0 ? value : max(groupMax, value);
+    if (++groupCount == SPC_SUBGROUP_SIZE) {
+        float xbar = offset + groupSum / SPC_SUBGROUP_SIZE;
+        float range = groupMax - groupMin;
+        if (state.subgroups == SPC_SUBGROUPS) {
+            xbarSum -= xbars[subgroupHead] - offset;
+            rangeSum -= ranges[subgroupHead];
+        } else {
+            state.subgroups++;
+        }
+        xbars[subgroupHead] = xbar;
+        ranges[subgroupHead] = range;
+        subgroupHead = (subgroupHead + 1) % SPC_SUBGROUPS;
+        xbarSum += xbar - offset;
+        rangeSum += range;
+        groupCount = 0;
+        groupSum = 0;
+
+        state.newSubgroup = true;
+        state.xbar = xbar;
+        state.range = range;
+        state.center = offset + xbarSum / state.subgroups;
+        state.rangeMean = max(rangeSum / state.subgroups, 0.0);
+        state.ucl = state.center + A2[K] * state.rangeMean;
+        state.lcl = state.center - A2[K] * state.rangeMean;
+        state.rangeUcl = D4[K] * state.rangeMean;
+        state.outOfControl = state.subgroups > 1 && (xbar > state.ucl || xbar < state.lcl || range > state.rangeUcl ||
+                                                     range < D3[K] * state.rangeMean);
+    }
+
+    // ความสามารถของกระบวนการเทียบช่วงน้ำหนัก
+    float span = state.upper - state.lower;
+    float nearest = min(state.upper - state.mean, state.mean - state.lower);
+    float within = state.rangeMean / D2[K];
+    bool limits = span > 0;
+    state.cp = limits && within > 0 ? span / (6 * within) : NAN;
+    state.cpk = limits && within > 0 ? nearest / (3 * within) : NAN;
+    state.pp = limits && state.stdDev > 0 ? span / (6 * state.stdDev) : NAN;
+    state.ppk = limits && state.stdDev > 0 ? nearest / (3 * state.stdDev) : NAN;
+    return state;
+}
@@ -0,0 +1,69 @@
+#ifndef SPC_ENGINE_H
+#define SPC_ENGINE_H
+
+#include <Arduino.h>
+
+#define SPC_SUBGROUP_SIZE 5                            // n ของ X-bar/R (2-10)
+#define SPC_SUBGROUPS 25                               // subgroup ล่าสุดที่ใช้คำนวณเส้นควบคุม (= จุดบนกราฟ)
+#define SPC_WINDOW (SPC_SUBGROUP_SIZE * SPC_SUBGROUPS) // น้ำหนักล่าสุดที่ใช้คำนวณค่าเฉลี่ย/ส่วนเบี่ยงเบนมาตรฐาน
+
+// สถิติหลังชั่ง 1 ครั้ง (copy ส่งข้าม task ได้)
+struct SpcSnapshot {
+    bool reset;        // สินค้าใหม่ (ช่วงน้ำหนักเปลี่ยน) ล้างกราฟ
+    bool newSubgroup;  // ครบ subgroup: มีจุดใหม่ xbar/range
+    float lower;       // ช่วงน้ำหนักที่ใช้ (LSL/USL)
+    float upper;
+    float last;        // น้ำหนักล่าสุด
+    uint16_t count;    // จำนวนน้ำหนักในหน้าต่าง (สูงสุด SPC_WINDOW)
+    float mean;
+    float stdDev;      // ส่วนเบี่ยงเบนมาตรฐานของหน้าต่าง (s, n - 1)
+    uint16_t subgroups;
+    float xbar;        // ของ subgroup ล่าสุด
+    float range;
+    float center;      // X-double-bar
+    float rangeMean;   // R-bar
+    float ucl;         // เส้นควบคุม X-bar: center +/- A2 * R-bar
+    float lcl;
+    float rangeUcl;    // D4 * R-bar
+    float cp;          // sigma ภายใน subgroup = R-bar / d2 (NAN = ยังคำนวณไม่ได้)
+    float cpk;
+    float pp;          // sigma รวมของหน้าต่าง
+    float ppk;
+    bool outOfControl; // xbar ล่าสุดอยู่นอก lcl-ucl หรือ range เกิน rangeUcl
+};
+
+// SPC ของน้ำหนัก SPC_WINDOW ค่าล่าสุด: ค่าเฉลี่ย/ส่วนเบี่ยงเบนมาตรฐาน, X-bar/R, Cp/Cpk, Pp/Ppk
+// ทุกค่าเป็นผลรวมสะสม: เพิ่มค่าใหม่ลบค่าที่หลุดหน้าต่าง งานต่อการชั่ง 1 ครั้งคงที่ (ไม่วนหน้าต่าง)
+// ผลรวมเก็บเป็น double ของผลต่างจากกลางช่วงน้ำหนัก ไม่สะสมความคลาดเคลื่อนแบบ float เมื่อบวก/ลบซ้ำนานๆ
+// ไม่มีการ lock: เรียกจาก task เดียว (loop)
+class SpcEngine {
+  public:
+    SpcEngine();
+    void reset();
+    // ช่วงน้ำหนักเปลี่ยน = เปลี่ยนสินค้า เริ่มเก็บใหม่ (upper <= lower ไม่คำนวณ Cp/Cpk)
+    void setLimits(float lower, float upper);
+    const SpcSnapshot &add(float value);
+    const SpcSnapshot &snapshot() const { return state; }
+
+  private:
+    float values[SPC_WINDOW];
+    uint16_t head;
+    double sum;   // ผลรวมของ (value - offset)
+    double sumSq; // ผลรวมของ (value - offset)^2
+    float offset;
+
+    float xbars[SPC_SUBGROUPS];
+    float ranges[SPC_SUBGROUPS];
+    uint16_t subgroupHead;
+    double xbarSum;
+    double rangeSum;
+
+    uint8_t groupCount; // subgroup ที่กำลังเก็บ
+    double groupSum;
+    float groupMin;
+    float groupMax;
+
+    SpcSnapshot state;
+};
+
+#endif // SPC_ENGINE_H
@@ -0,0 +1,63 @@
+#include "StabilityDetector.h"
+
+StabilityDetector::StabilityDetector() : config({5, 0.05f, 0.5f}), head(0), count(0), armed(true), captured(0), stdDev(0) {}
+
+void StabilityDetector::begin(const StabilityConfig &config) {
+    this->config = config;
+    if (this->config.samples < 2) {
+        this->config.samples = 2;
+    } else if (this->config.samples > STABILITY_WINDOW_MAX) {
+        this->config.samples = STABILITY_WINDOW_MAX;
+    }
+    reset();
+}
+
+void StabilityDetector::reset() {
+    head = 0;
+    count = 0;
+    armed = true;
+    captured = 0;
+    stdDev = 0;
+}
+
+StabilityEvent StabilityDetector::add(float value) {
+    if (!armed) {
+        // รอยกของออก
+        if (fabsf(value) <= config.zeroBand) {
+            armed = true;
+            head = 0;
+            count = 0;
+            return STABILITY_REARMED;
+        }
+        return STABILITY_NONE;
+    }
+
+    window[head] = value;
+    head = (head + 1) % config.samples;
+    if (count < config.samples) {
+        count++;
+        if (count < config.samples) {
+            return STABILITY_NONE;
+        }
+    }
+
+    // หน้าต่างมีไม่เกิน 30 ค่า คำนวณใหม่ทุกครั้งแม่นกว่าเก็บผลรวมสะสม (float)
+    float sum = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        sum += window[i];
+    }
+    float mean = sum / count;
+    float sumSq = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        float d = window[i] - mean;
+        sumSq += d * d;
+    }
+    stdDev = sqrtf(sumSq / count);
+
+    if (mean > config.zeroBand && stdDev <= config.maxStdDev) {
+        captured = mean;
+        armed = false;
+        return STABILITY_CAPTURED;
+    }
+    return STABILITY_NONE;
+}
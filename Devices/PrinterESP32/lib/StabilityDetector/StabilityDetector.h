@@ -0,0 +1,44 @@
+#ifndef STABILITY_DETECTOR_H
+#define STABILITY_DETECTOR_H
+
+#include <Arduino.h>
+
+#define STABILITY_WINDOW_MAX 30 // จำนวน sample สูงสุดในหน้าต่าง
+
+struct StabilityConfig {
+    uint8_t samples; // จำนวน sample ล่าสุดที่ต้องนิ่ง
+    float maxStdDev; // ส่วนเบี่ยงเบนมาตรฐานสูงสุดที่ถือว่านิ่ง (หน่วยเดียวกับค่าที่ป้อน)
+    float zeroBand;  // |ค่า| ไม่เกินนี้ถือว่าถาดว่าง (re-arm) และค่าที่จะจับต้องมากกว่านี้
+};
+
+enum StabilityEvent {
+    STABILITY_NONE,
+    STABILITY_CAPTURED, // ของชิ้นใหม่นิ่งแล้ว อ่านค่าจาก capturedValue()
+    STABILITY_REARMED,  // ยกของออกแล้ว พร้อมรับชิ้นถัดไป
+};
+
+// ตรวจจับการวางของบนเครื่องชั่งที่ส่งค่าต่อเนื่อง
+// จับค่า 1 ครั้งต่อการวาง 1 ชิ้น เมื่อ sample ล่าสุด N ค่ามีส่วนเบี่ยงเบนมาตรฐานต่ำกว่าที่กำหนด
+// หลังจับค่าแล้วจะไม่จับอีกจนกว่าค่าจะกลับมาอยู่ในช่วงศูนย์
+class StabilityDetector {
+  public:
+    StabilityDetector();
+    void begin(const StabilityConfig &config);
+    void reset();
+    StabilityEvent add(float value);
+
+    bool isArmed() const { return armed; }
+    float capturedValue() const { return captured; }
+    float lastStdDev() const { return stdDev; }
+
+  private:
+    StabilityConfig config;
+    float window[STABILITY_WINDOW_MAX];
+    uint8_t head;
+    uint8_t count;
+    bool armed;
+    float captured;
+    float stdDev;
+};
+
+#endif // STABILITY_DETECTOR_H
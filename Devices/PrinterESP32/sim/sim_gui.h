@@ -0,0 +1,120 @@
+// แทน src/gui/gui.h ตอน build env:native: แสดงผลผ่าน SDL2 และไม่มี LVGL task
+// sim_main.cpp เป็นคนเรียก sim_gui_step() แทน gui_task
+#include <Arduino.h>
+#include <lv_conf.h>
+#include <lvgl.h>
+#include <sdl/sdl.h>
+
+#include <deque>
+
+#include "../src/ui/ui.h"
+
+static const uint16_t screenWidth = 800;
+static const uint16_t screenHeight = 480;
+
+static lv_disp_draw_buf_t draw_buf;
+static lv_color_t buf[2][screenWidth * 10];
+
+// แทน LGFX (main.cpp เรียกแค่ setBrightness)
+class SimPanel {
+  public:
+    void setBrightness(uint8_t brightness) {}
+};
+SimPanel gfx;
+
+struct UiMessage {
+    int type;
+    bool flag;
+    float value;
+    char text[48];
+    uint32_t posted;
+    uint32_t origin;
+};
+
+typedef void (*UiMessageHandler)(const UiMessage &msg);
+
+static UiMessageHandler guiHandler = NULL;
+static std::deque<UiMessage> guiQueue;
+
+// ผลของ sim_gui_step() หนึ่งครั้ง
+struct SimFrame {
+    uint32_t handlerUs; // เวลาใน lv_timer_handler()
+    uint32_t refreshMs; // เวลาวาด + flush จาก monitor_cb (0 = ไม่ได้วาด)
+    uint32_t px;        // จำนวน pixel ที่วาด
+    uint32_t latencyUs; // ข้อมูลเข้า -> วาดเสร็จ (0 = ไม่มี)
+};
+static SimFrame simFrame;
+static uint32_t simInputOrigin = 0;
+
+static void sim_disp_monitor(lv_disp_drv_t *disp, uint32_t time, uint32_t px) {
+    simFrame.refreshMs += time;
+    simFrame.px += px;
+    if (simInputOrigin != 0) {
+        simFrame.latencyUs = micros() - simInputOrigin;
+        simInputOrigin = 0;
+    }
+}
+
+void gui_start() {
+    lv_init();
+    sdl_init();
+    lv_disp_draw_buf_init(&draw_buf, buf[0], buf[1], screenWidth * 10);
+
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = screenWidth;
+    disp_drv.ver_res = screenHeight;
+    disp_drv.flush_cb = sdl_display_flush;
+    disp_drv.monitor_cb = sim_disp_monitor;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_drv_register(&disp_drv);
+
+    static lv_indev_drv_t indev_drv;
+    lv_indev_drv_init(&indev_drv);
+    indev_drv.type = LV_INDEV_TYPE_POINTER;
+    indev_drv.read_cb = sdl_mouse_read;
+    lv_indev_drv_register(&indev_drv);
+
+    ui_init();
+}
+
+bool gui_post(int type, bool flag = false, float value = 0, const char *text = NULL, uint32_t origin = 0) {
+    UiMessage msg;
+    msg.type = type;
+    msg.flag = flag;
+    msg.value = value;
+    strlcpy(msg.text, text ? text : "", sizeof(msg.text));
+    msg.posted = micros();
+    msg.origin = origin;
+    guiQueue.push_back(msg);
+    return true;
+}
+
+void gui_refresh_soon() {
+    lv_disp_t *disp = lv_disp_get_default();
+    if (disp != NULL && disp->refr_timer != NULL) {
+        lv_timer_ready(disp->refr_timer);
+    }
+}
+
+void gui_task_start(UiMessageHandler handler) { guiHandler = handler; }
+
+// ทำงานแทน gui_task หนึ่งรอบ: apply ข้อความที่ค้าง แล้ววาดหน้าจอ
+SimFrame sim_gui_step() {
+    memset(&simFrame, 0, sizeof(simFrame));
+    while (!guiQueue.empty()) {
+        UiMessage msg = guiQueue.front();
+        guiQueue.pop_front();
+        if (msg.origin != 0 && simInputOrigin == 0) {
+            simInputOrigin = msg.origin;
+        }
+        if (guiHandler) {
+            guiHandler(msg);
+        }
+    }
+
+    uint32_t start = micros();
+    lv_timer_handler();
+    simFrame.handlerUs = micros() - start;
+    return simFrame;
+}
@@ -0,0 +1,439 @@
+// Simulator ของหน้าจอ PrinterESP32 (pio run -e native)
+// รัน setup()/loop() ของ src/main.cpp บน host แล้วเล่น scenario พร้อมบันทึกเวลาวาดทุกเฟรม
+//
+//   .pio/build/native/program [scenario] [--csv frames.csv] [--budget ms]
+//
+// --budget: คืนค่า 1 ถ้า p95 ของเวลาวาดในขั้นใดเกินกำหนด (ใช้ใน CI ร่วมกับ SDL_VIDEODRIVER=dummy)
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <PCF8574.h>
+#include <SD.h>
+#include <WiFi.h>
+#include <Wire.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#include <lvgl.h>
+
+#include "../src/ui/ui.h"
+#include "AuditLog.h"
+#include "PrintSpooler.h"
+#include "SDCard.h"
+#include "SpcEngine.h"
+
+// ===== Arduino globals =====
+HardwareSerial Serial("Serial", true);
+HardwareSerial Serial1("Serial1", false);
+HardwareSerial Serial2("Serial2", false);
+EspClass ESP;
+TwoWire Wire;
+WiFiClass WiFi;
+LittleFSClass LittleFS;
+SDFS SD;
+
+static const auto simStart = std::chrono::steady_clock::now();
+
+uint32_t millis(void) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - simStart).count();
+}
+
+uint32_t micros(void) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - simStart).count();
+}
+
+void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+// ===== main.cpp =====
+struct SimFrame {
+    uint32_t handlerUs;
+    uint32_t refreshMs;
+    uint32_t px;
+    uint32_t latencyUs;
+};
+SimFrame sim_gui_step();
+
+void setup();
+void loop();
+
+extern SDCard sdCard;
+extern AuditLog auditLog;
+extern SpcEngine spc;
+extern lv_obj_t *spcPanel;
+extern bool runTaskComplete;
+extern bool syncWifi;
+extern bool syncTime;
+extern bool switchToDetailsPage;
+extern int handshakeStatus;
+extern String machineName;
+extern float SET_MIN_WEIGHT;
+extern float SET_MAX_WEIGHT;
+extern int SET_PCS;
+extern PrintSpooler spooler;
+extern bool SET_AUTO_CAPTURE;
+extern int SET_STABLE_SAMPLES;
+extern float SET_STABLE_STDDEV;
+extern float SET_ZERO_BAND;
+extern volatile bool stabilityChanged;
+extern unsigned long COUNT_GRAM_OK;
+extern unsigned long COUNT_GRAM_NG;
+extern unsigned long COUNT_PCS_OK;
+extern unsigned long COUNT_PCS_NG;
+
+// ===== Scenario =====
+// object ที่ scenario อ้างถึงได้ (ชื่อตาม SquareLine โดยไม่มี ui_, SpcPanel สร้างใน main.cpp)
+static const std::map<std::string, lv_obj_t **> SIM_OBJECTS = {
+    {"PnEmployeeID1", &ui_PnEmployeeID1}, {"PnEmployeeID2", &ui_PnEmployeeID2}, {"LoginInput", &ui_LoginInput},
+    {"LoginKeyboard", &ui_LoginKeyboard}, {"Login", &ui_Login},                 {"Logout", &ui_Logout},
+    {"Home", &ui_Home},                   {"Details", &ui_Details},             {"UpdateDetails", &ui_UpdateDetails},
+    {"Mode", &ui_Mode},                   {"SettingMode", &ui_SettingMode},     {"SetMinWeight", &ui_SetMinWeight},
+    {"SetMaxWeight", &ui_SetMaxWeight},   {"SetPcs", &ui_SetPcs},               {"Keyboard", &ui_Keyboard},
+    {"input", &ui_input},                 {"TabSettings", &ui_TabSettings},     {"PrintTest", &ui_PrintTest},
+    {"Panel3", &ui_Panel3},               {"SpcPanel", &spcPanel},
+};
+
+struct StepStats {
+    std::vector<uint32_t> refreshUs; // เวลาใน lv_timer_handler() เฉพาะเฟรมที่วาดจริง
+    uint32_t latencyMaxUs = 0;
+};
+
+static std::map<std::string, StepStats> stats;
+static std::vector<std::string> stepOrder;
+static std::string currentStep = "boot";
+static std::ofstream csv;
+
+static void runFor(uint32_t ms) {
+    uint32_t start = millis();
+    do {
+        loop();
+        spooler.service(0); // บนบอร์ดจริงเป็น task แยก
+        SimFrame frame = sim_gui_step();
+        if (frame.px > 0) {
+            StepStats &s = stats[currentStep];
+            s.refreshUs.push_back(frame.handlerUs);
+            s.latencyMaxUs = max(s.latencyMaxUs, frame.latencyUs);
+            if (csv.is_open()) {
+                csv << currentStep << "," << millis() << "," << frame.handlerUs << "," << frame.refreshMs << "," << frame.px << ","
+                    << frame.latencyUs << "\n";
+            }
+        }
+    } while (millis() - start < ms);
+}
+
+static lv_obj_t *findObject(const std::string &name) {
+    auto it = SIM_OBJECTS.find(name);
+    if (it == SIM_OBJECTS.end() || *it->second == NULL) {
+        fprintf(stderr, "(SIM)=> Unknown object: %s\n", name.c_str());
+        exit(2);
+    }
+    return *it->second;
+}
+
+static uint32_t elapsedUs(uint32_t start) { return micros() - start; }
+
+static void runSdCommand(const std::string &rest) {
+    std::istringstream args(rest);
+    std::string action;
+    uint32_t count = 0;
+    args >> action >> count;
+    if (action == "eject") {
+        ::rename("sim/sd", "sim/sd.ejected");
+    } else if (action == "insert") {
+        if (::rename("sim/sd.ejected", "sim/sd") != 0) {
+            ::mkdir("sim/sd", 0755);
+        }
+    } else if (action == "bench") {
+        SdBenchmark result;
+        if (!sdCard.benchmark("/bench.bin", max(count, 1u), result)) {
+            fprintf(stderr, "(SIM)=> sd bench failed\n");
+            exit(1);
+        }
+        printf("(SIM)=> sd bench %u KB: write %.2f MB/s (byte %.2f MB/s), read %.2f MB/s (byte %.2f MB/s)\n", result.bytes / 1024,
+               result.bytes / (float)max(result.writeUs, 1u), result.bytes / (float)max(result.byteWriteUs, 1u),
+               result.bytes / (float)max(result.readUs, 1u), result.bytes / (float)max(result.byteReadUs, 1u));
+    } else if (action == "json") {
+        JsonDocument doc;
+        for (uint32_t i = 0; i < count; i++) {
+            doc["key" + String(i)] = "value " + String(i);
+        }
+        uint32_t start = micros();
+        bool ok = sdCard.writeJson("/test.json", doc);
+        uint32_t writeUs = elapsedUs(start);
+        String middle = "key" + String(count / 2);
+        start = micros();
+        ok = ok && sdCard.updateJson("/test.json", middle.c_str(), "changed \"quoted\"");
+        ok = ok && sdCard.updateJson("/test.json", "added", "new");
+        uint32_t updateUs = elapsedUs(start) / 2;
+        doc.clear();
+        start = micros();
+        ok = ok && sdCard.readJson("/test.json", doc);
+        uint32_t readUs = elapsedUs(start);
+        ok = ok && doc.size() == count + 1 && doc[middle] == "changed \"quoted\"" && doc["added"] == "new";
+        for (uint32_t i = 0; ok && i < count; i++) {
+            ok = i == count / 2 || doc["key" + String(i)] == "value " + String(i);
+        }
+        SD.remove("/test.json");
+        if (!ok) {
+            fprintf(stderr, "(SIM)=> sd json %u keys: mismatch\n", count);
+            exit(1);
+        }
+        printf("(SIM)=> sd json %u keys: write %u us, update %u us, read %u us: pass\n", count, writeUs, updateUs, readUs);
+    } else {
+        fprintf(stderr, "(SIM)=> Unknown sd command: %s\n", rest.c_str());
+        exit(2);
+    }
+}
+
+static void runAuditCommand(const std::string &rest) {
+    std::istringstream args(rest);
+    std::string action;
+    uint32_t count = 0, perDay = 0;
+    args >> action >> count >> perDay;
+    if (action == "fill") {
+        uint32_t today = AuditLog::timeOf(AuditLog::dayOf(time(NULL) + 7 * 3600));
+        uint32_t start = micros();
+        for (uint32_t day = count; day > 0; day--) {
+            for (uint32_t i = 0; i < perDay; i++) {
+                AuditRecord record = {};
+                record.time = today - day * 86400 + 8 * 3600 + i * (10 * 3600) / max(perDay, 1u);
+                record.value = 10 + i % 1000 / 100.0;
+                record.low = 10;
+                record.high = 20;
+                record.pass = record.value <= 18;
+                record.operator1 = 1001;
+                if (!auditLog.append(record)) {
+                    fprintf(stderr, "(SIM)=> audit fill: append failed\n");
+                    exit(1);
+                }
+            }
+        }
+        printf("(SIM)=> audit fill %u days x %u records: %u ms\n", count, perDay, (micros() - start) / 1000);
+    } else if (action == "bench") {
+        AuditBenchmark result;
+        if (!auditLog.benchmark(max(count, 1u), result)) {
+            fprintf(stderr, "(SIM)=> audit bench failed\n");
+            exit(1);
+        }
+        printf("(SIM)=> audit bench %u days, %u records, list %u us | %u lookups: avg %u us, max %u us\n", result.days, result.records,
+               result.listUs, result.lookups, result.averageUs, result.maxUs);
+    } else {
+        fprintf(stderr, "(SIM)=> Unknown audit command: %s\n", rest.c_str());
+        exit(2);
+    }
+}
+
+// คำสั่งใน scenario (บรรทัดละคำสั่ง, # = comment)
+//   step <name>              เริ่มเก็บสถิติในชื่อใหม่
+//   wait <ms>                รัน loop() + วาดหน้าจอ
+//   boot [machine]           จำลองว่า WiFi/NTP/handshake เสร็จแล้ว
+//   click <object>           ส่ง LV_EVENT_CLICKED
+//   toggle <object>          สลับ LV_STATE_CHECKED แล้วส่ง LV_EVENT_CLICKED (switch, checkbox)
+//   type <textarea> <text>   ใส่ข้อความใน textarea
+//   ready <keyboard>         ส่ง LV_EVENT_READY (กด OK บน keyboard)
+//   tab <index>              เปลี่ยนแท็บในหน้าตั้งค่า (ส่ง LV_EVENT_VALUE_CHANGED เหมือนกดแท็บ)
+//   limits <min> <max>       ตั้งช่วงน้ำหนัก
+//   pcs <count>              ตั้งจำนวนชิ้น
+//   scale <text>             ป้อนข้อมูลเครื่องชั่งเข้า Serial2 (ต่อท้าย \n ให้)
+//   auto off | <n> <sd> <z>  ปิด/เปิดชั่งอัตโนมัติ (จำนวนค่า, ส่วนเบี่ยงเบนมาตรฐาน, ช่วงศูนย์)
+//   replay <file> <hz>       ป้อนข้อมูลเครื่องชั่งที่บันทึกไว้ทีละบรรทัดตามอัตราที่กำหนด
+//   expect <gram|pcs> <ok> <ng>  ตรวจตัวนับ ถ้าไม่ตรงจบด้วย exit code 1
+//   expect sd <mounted|unmounted>  ตรวจสถานะ SD card
+//   sd bench <KB>            วัดความเร็ว SD แบบ buffer เทียบกับทีละ byte
+//   sd json <keys>           เขียน JSON <keys> key, แก้ 1 key, เพิ่ม 1 key แล้วอ่านกลับมาตรวจ (ไม่ตรงจบด้วย exit code 1)
+//   sd eject | sd insert     ถอด/เสียบการ์ด (ย้ายโฟลเดอร์ sim/sd) แล้ว wait ให้ loop() ตรวจเจอ
+//   audit fill <days> <n>    เขียน audit log ย้อนหลัง <days> วันจนถึงเมื่อวาน วันละ <n> record (08:00-18:00)
+//   audit bench <lookups>    สุ่มค้นเวลาใน audit log แล้วอ่าน 1 หน้า พิมพ์เวลาเฉลี่ย/สูงสุด
+//   expect audit <n>         ตรวจจำนวน record ที่เขียนลง audit log ตั้งแต่เปิดเครื่อง
+//   expect spc <n> <groups>  ตรวจจำนวนน้ำหนักในหน้าต่าง SPC และจำนวน subgroup (พิมพ์ค่าสถิติด้วย)
+static void runCommand(const std::string &line) {
+    std::istringstream in(line);
+    std::string cmd;
+    in >> cmd;
+    std::string rest;
+    std::getline(in >> std::ws, rest);
+
+    if (cmd == "step") {
+        currentStep = rest;
+        if (stats.find(currentStep) == stats.end()) {
+            stepOrder.push_back(currentStep);
+        }
+        stats[currentStep];
+    } else if (cmd == "wait") {
+        runFor(atoi(rest.c_str()));
+    } else if (cmd == "boot") {
+        machineName = rest.empty() ? "SIMULATOR" : rest.c_str();
+        handshakeStatus = 200;
+        syncWifi = true;
+        syncTime = true;
+        switchToDetailsPage = true;
+        runFor(100);
+        runTaskComplete = true;
+    } else if (cmd == "click") {
+        lv_event_send(findObject(rest), LV_EVENT_CLICKED, NULL);
+    } else if (cmd == "toggle") {
+        lv_obj_t *obj = findObject(rest);
+        if (lv_obj_has_state(obj, LV_STATE_CHECKED)) {
+            lv_obj_clear_state(obj, LV_STATE_CHECKED);
+        } else {
+            lv_obj_add_state(obj, LV_STATE_CHECKED);
+        }
+        lv_event_send(obj, LV_EVENT_CLICKED, NULL);
+    } else if (cmd == "type") {
+        std::istringstream args(rest);
+        std::string name, text;
+        args >> name;
+        std::getline(args >> std::ws, text);
+        lv_textarea_set_text(findObject(name), text.c_str());
+    } else if (cmd == "ready") {
+        lv_event_send(findObject(rest), LV_EVENT_READY, NULL);
+    } else if (cmd == "tab") {
+        lv_tabview_set_act(ui_TabSettings, atoi(rest.c_str()), LV_ANIM_OFF);
+        lv_event_send(ui_TabSettings, LV_EVENT_VALUE_CHANGED, NULL);
+    } else if (cmd == "limits") {
+        sscanf(rest.c_str(), "%f %f", &SET_MIN_WEIGHT, &SET_MAX_WEIGHT);
+    } else if (cmd == "pcs") {
+        SET_PCS = atoi(rest.c_str());
+    } else if (cmd == "scale") {
+        Serial2.inject((rest + "\n").c_str());
+    } else if (cmd == "auto") {
+        SET_AUTO_CAPTURE = rest != "off";
+        if (SET_AUTO_CAPTURE) {
+            sscanf(rest.c_str(), "%d %f %f", &SET_STABLE_SAMPLES, &SET_STABLE_STDDEV, &SET_ZERO_BAND);
+        }
+        stabilityChanged = true;
+    } else if (cmd == "replay") {
+        std::istringstream args(rest);
+        std::string path;
+        int hz = 10;
+        args >> path >> hz;
+        std::ifstream stream(path);
+        if (!stream) {
+            fprintf(stderr, "(SIM)=> Cannot open stream: %s\n", path.c_str());
+            exit(2);
+        }
+        std::string sample;
+        while (std::getline(stream, sample)) {
+            if (sample.empty() || sample[0] == '#') {
+                continue;
+            }
+            Serial2.inject((sample + "\n").c_str());
+            runFor(1000 / max(hz, 1));
+        }
+    } else if (cmd == "sd") {
+        runSdCommand(rest);
+    } else if (cmd == "audit") {
+        runAuditCommand(rest);
+    } else if (cmd == "expect" && rest.compare(0, 6, "audit ") == 0) {
+        unsigned long expected = strtoul(rest.c_str() + 6, NULL, 10);
+        unsigned long appended = auditLog.stats().appended;
+        if (appended != expected) {
+            fprintf(stderr, "(SIM)=> expect audit %lu, got %lu\n", expected, appended);
+            exit(1);
+        }
+        printf("(SIM)=> expect audit %lu: pass\n", expected);
+    } else if (cmd == "expect" && rest.compare(0, 4, "spc ") == 0) {
+        unsigned count = 0, subgroups = 0;
+        sscanf(rest.c_str() + 4, "%u %u", &count, &subgroups);
+        const SpcSnapshot &snapshot = spc.snapshot();
+        printf("(SIM)=> spc mean %.2f sd %.3f | x-bar %.2f r %.2f ucl %.2f lcl %.2f | cp %.2f cpk %.2f pp %.2f ppk %.2f\n", snapshot.mean,
+               snapshot.stdDev, snapshot.center, snapshot.rangeMean, snapshot.ucl, snapshot.lcl, snapshot.cp, snapshot.cpk, snapshot.pp,
+               snapshot.ppk);
+        if (snapshot.count != count || snapshot.subgroups != subgroups) {
+            fprintf(stderr, "(SIM)=> expect spc %u %u, got %u %u\n", count, subgroups, snapshot.count, snapshot.subgroups);
+            exit(1);
+        }
+        printf("(SIM)=> expect spc %u %u: pass\n", count, subgroups);
+    } else if (cmd == "expect" && rest.compare(0, 3, "sd ") == 0) {
+        bool mounted = rest == "sd mounted";
+        if (sdCard.isMounted() != mounted) {
+            fprintf(stderr, "(SIM)=> expect %s, got %s\n", rest.c_str(), sdCard.isMounted() ? "mounted" : "unmounted");
+            exit(1);
+        }
+        printf("(SIM)=> expect %s: pass\n", rest.c_str());
+    } else if (cmd == "expect") {
+        std::istringstream args(rest);
+        std::string counter;
+        unsigned long ok = 0, ng = 0;
+        args >> counter >> ok >> ng;
+        unsigned long actualOk = counter == "pcs" ? COUNT_PCS_OK : COUNT_GRAM_OK;
+        unsigned long actualNg = counter == "pcs" ? COUNT_PCS_NG : COUNT_GRAM_NG;
+        if (actualOk != ok || actualNg != ng) {
+            fprintf(stderr, "(SIM)=> expect %s ok=%lu ng=%lu, got ok=%lu ng=%lu\n", counter.c_str(), ok, ng, actualOk, actualNg);
+            exit(1);
+        }
+        printf("(SIM)=> expect %s ok=%lu ng=%lu: pass\n", counter.c_str(), ok, ng);
+    } else {
+        fprintf(stderr, "(SIM)=> Unknown command: %s\n", line.c_str());
+        exit(2);
+    }
+}
+
+static uint32_t percentile(std::vector<uint32_t> values, int pct) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[(values.size() - 1) * pct / 100];
+}
+
+int main(int argc, char **argv) {
+    const char *scenarioPath = "sim/scenarios/default.txt";
+    const char *csvPath = NULL;
+    float budgetMs = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc) {
+            budgetMs = atof(argv[++i]);
+        } else {
+            scenarioPath = argv[i];
+        }
+    }
+
+    std::ifstream scenario(scenarioPath);
+    if (!scenario) {
+        fprintf(stderr, "(SIM)=> Cannot open scenario: %s\n", scenarioPath);
+        return 2;
+    }
+    if (csvPath) {
+        csv.open(csvPath);
+        csv << "step,t_ms,handler_us,refresh_ms,px,input_latency_us\n";
+    }
+
+    // เริ่มแบบเสียบการ์ดไว้ (ถอดด้วยคำสั่ง sd eject)
+    ::mkdir("sim/sd", 0755);
+    stepOrder.push_back(currentStep);
+    setup();
+    runFor(200);
+
+    std::string line;
+    while (std::getline(scenario, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        runCommand(line);
+    }
+
+    printf("\n%-20s %8s %10s %10s %10s %12s\n", "step", "frames", "avg ms", "p95 ms", "max ms", "input max ms");
+    int result = 0;
+    for (const std::string &name : stepOrder) {
+        const StepStats &s = stats[name];
+        uint64_t total = 0;
+        for (uint32_t us : s.refreshUs) {
+            total += us;
+        }
+        float p95 = percentile(s.refreshUs, 95) / 1000.0;
+        printf("%-20s %8zu %10.2f %10.2f %10.2f %12.2f%s\n", name.c_str(), s.refreshUs.size(),
+               s.refreshUs.empty() ? 0 : total / 1000.0 / s.refreshUs.size(), p95, percentile(s.refreshUs, 100) / 1000.0,
+               s.latencyMaxUs / 1000.0, budgetMs > 0 && p95 > budgetMs ? "  <-- over budget" : "");
+        if (budgetMs > 0 && p95 > budgetMs) {
+            result = 1;
+        }
+    }
+    printf("Printer bytes written: %zu\n", Serial1.bytesWritten());
+    return result;
+}
@@ -0,0 +1,372 @@
+// Arduino + FreeRTOS สำหรับ build บนเครื่อง host (env:native) เท่าที่ main.cpp ใช้
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <stdint.h>
+
+// ใช้จากไฟล์ C ของ LVGL ด้วย (LV_TICK_CUSTOM_INCLUDE)
+#ifdef __cplusplus
+extern "C" {
+#endif
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef __cplusplus
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#define IRAM_ATTR
+#define F(s) (s)
+#define HEX 16
+#define DEC 10
+
+using std::isnan; // Arduino.h บนบอร์ดได้จาก math.h
+using std::max;
+using std::min;
+
+inline bool isDigit(int c) { return isdigit(c); }
+template <typename T, typename L, typename H> inline T constrain(T x, L low, H high) { return x < low ? low : (x > high ? high : x); }
+
+// glibc รุ่นเก่าไม่มี strlcpy
+inline size_t sim_strlcpy(char *dst, const char *src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#define strlcpy sim_strlcpy
+
+// ===== String =====
+class String {
+  public:
+    String() {}
+    String(const char *s) : s(s ? s : "") {}
+    String(const std::string &s) : s(s) {}
+    String(char c) : s(1, c) {}
+    String(int v) : s(std::to_string(v)) {}
+    String(unsigned int v) : s(std::to_string(v)) {}
+    String(long v) : s(std::to_string(v)) {}
+    String(unsigned long v) : s(std::to_string(v)) {}
+    String(float v, unsigned int decimals = 2) { format(v, decimals); }
+    String(double v, unsigned int decimals = 2) { format(v, decimals); }
+
+    const char *c_str() const { return s.c_str(); }
+    unsigned int length() const { return s.length(); }
+    bool isEmpty() const { return s.empty(); }
+    char operator[](unsigned int i) const { return i < s.length() ? s[i] : 0; }
+    char &operator[](unsigned int i) { return s[i]; }
+
+    bool concat(const char *v) {
+        s += v;
+        return true;
+    }
+    bool concat(char c) {
+        s += c;
+        return true;
+    }
+    bool reserve(unsigned int size) {
+        s.reserve(size);
+        return true;
+    }
+    String &operator+=(const String &v) {
+        s += v.s;
+        return *this;
+    }
+    String &operator+=(const char *v) {
+        s += v;
+        return *this;
+    }
+    String &operator+=(char c) {
+        s += c;
+        return *this;
+    }
+    friend String operator+(const String &a, const String &b) { return String(a.s + b.s); }
+    friend String operator+(const String &a, const char *b) { return String(a.s + b); }
+    friend String operator+(const char *a, const String &b) { return String(a + b.s); }
+    bool operator==(const String &v) const { return s == v.s; }
+    bool operator==(const char *v) const { return s == v; }
+    bool operator!=(const String &v) const { return s != v.s; }
+    bool operator!=(const char *v) const { return s != v; }
+
+    void replace(const String &from, const String &to) {
+        if (from.s.empty()) {
+            return;
+        }
+        size_t pos = 0;
+        while ((pos = s.find(from.s, pos)) != std::string::npos) {
+            s.replace(pos, from.s.length(), to.s);
+            pos += to.s.length();
+        }
+    }
+    void trim() {
+        size_t begin = s.find_first_not_of(" \t\r\n");
+        size_t end = s.find_last_not_of(" \t\r\n");
+        s = begin == std::string::npos ? "" : s.substr(begin, end - begin + 1);
+    }
+    void toUpperCase() {
+        for (char &c : s) {
+            c = toupper(c);
+        }
+    }
+    void toLowerCase() {
+        for (char &c : s) {
+            c = tolower(c);
+        }
+    }
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return atof(s.c_str()); }
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t pos = s.find(c, from);
+        return pos == std::string::npos ? -1 : pos;
+    }
+    int indexOf(const String &v, unsigned int from = 0) const {
+        size_t pos = s.find(v.s, from);
+        return pos == std::string::npos ? -1 : pos;
+    }
+    String substring(unsigned int from, unsigned int to = 0xFFFFFFFF) const {
+        if (from >= s.length()) {
+            return String();
+        }
+        return String(s.substr(from, (to > s.length() ? s.length() : to) - from));
+    }
+    bool startsWith(const String &v) const { return s.compare(0, v.s.length(), v.s) == 0; }
+
+  private:
+    std::string s;
+
+    void format(double v, unsigned int decimals) {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+        s = buf;
+    }
+};
+
+// ===== Serial =====
+#define SERIAL_8N1 0x800001c
+#define HW_FLOWCTRL_CTS 0x2
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *data, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            write(data[i]);
+        }
+        return len;
+    }
+    size_t print(const String &s) { return write((const uint8_t *)s.c_str(), s.length()); }
+    size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return print(String(v)); }
+    size_t print(unsigned int v) { return print(String(v)); }
+    size_t print(long v) { return print(String(v)); }
+    size_t print(unsigned long v) { return print(String(v)); }
+    size_t print(double v, int decimals = 2) { return print(String(v, decimals)); }
+    template <typename T> size_t println(const T &v) { return print(v) + print("\n"); }
+    size_t println() { return print("\n"); }
+    size_t printf(const char *format, ...) {
+        char buf[512];
+        va_list args;
+        va_start(args, format);
+        int len = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        return write((const uint8_t *)buf, len < (int)sizeof(buf) ? len : sizeof(buf) - 1);
+    }
+};
+
+class Stream : public Print {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    long parseInt() {
+        String digits;
+        while (available() && (isdigit(peek()) || peek() == '-')) {
+            digits += (char)read();
+        }
+        return digits.toInt();
+    }
+    size_t readBytes(char *buffer, size_t length) {
+        size_t n = 0;
+        for (int c; n < length && (c = read()) >= 0; n++) {
+            buffer[n] = c;
+        }
+        return n;
+    }
+    void setTimeout(unsigned long timeout) {}
+};
+
+// Serial ของ host: เขียนออก stdout, อ่านจาก buffer ที่ scenario ป้อนให้
+class HardwareSerial : public Stream {
+  public:
+    HardwareSerial(const char *name, bool echo) : name(name), echo(echo), written(0) {}
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1) {}
+    void end() {}
+    void updateBaudRate(unsigned long baud) {}
+    bool setPins(int8_t rxPin, int8_t txPin, int8_t ctsPin = -1, int8_t rtsPin = -1) { return true; }
+    bool setHwFlowCtrlMode(uint8_t mode, uint8_t threshold = 64) { return true; }
+    size_t write(uint8_t c) override {
+        written++;
+        if (echo) {
+            fputc(c, stdout);
+        }
+        return 1;
+    }
+    using Print::write;
+    int available() override { return rx.size(); }
+    int read() override {
+        if (rx.empty()) {
+            return -1;
+        }
+        int c = rx.front();
+        rx.pop_front();
+        return c;
+    }
+    size_t read(uint8_t *buffer, size_t size) {
+        size_t n = 0;
+        while (n < size && !rx.empty()) {
+            buffer[n++] = rx.front();
+            rx.pop_front();
+        }
+        return n;
+    }
+    int peek() override { return rx.empty() ? -1 : rx.front(); }
+    int availableForWrite() { return 128; }
+    void onReceive(std::function<void(void)> callback, bool onlyOnTimeout = false) { receiveCallback = callback; }
+    void flush() {}
+
+    // ใช้ใน scenario
+    void inject(const char *data) {
+        for (; *data; data++) {
+            rx.push_back(*data);
+        }
+        if (receiveCallback) {
+            receiveCallback(); // บนบอร์ดจริงเรียกจาก task ของ UART driver
+        }
+    }
+    size_t bytesWritten() const { return written; }
+
+  private:
+    const char *name;
+    bool echo;
+    size_t written;
+    std::deque<uint8_t> rx;
+    std::function<void(void)> receiveCallback;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+
+// ===== ESP =====
+class EspClass {
+  public:
+    uint64_t getEfuseMac() { return 0x0000A1B2C3D4E5F6ULL; }
+    void restart() {
+        printf("(SIM)=> ESP.restart()\n");
+        exit(0);
+    }
+    uint32_t getFreeHeap() { return 200 * 1024; }
+};
+extern EspClass ESP;
+
+// ===== FreeRTOS (ไม่มี scheduler: task ไม่ถูกรัน, queue เป็น buffer ธรรมดา) =====
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFF
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) (ms)
+
+struct SimQueue {
+    size_t itemSize;
+    size_t length;
+    std::deque<std::vector<uint8_t>> items;
+};
+typedef SimQueue *QueueHandle_t;
+typedef SimQueue *SemaphoreHandle_t;
+
+inline QueueHandle_t xQueueCreate(size_t length, size_t itemSize) { return new SimQueue{itemSize, length, {}}; }
+inline BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait) {
+    if (q->items.size() >= q->length) {
+        return pdFALSE;
+    }
+    q->items.emplace_back((const uint8_t *)item, (const uint8_t *)item + q->itemSize);
+    return pdTRUE;
+}
+inline BaseType_t xQueueSendToFront(QueueHandle_t q, const void *item, TickType_t wait) {
+    if (q->items.size() >= q->length) {
+        return pdFALSE;
+    }
+    q->items.emplace_front((const uint8_t *)item, (const uint8_t *)item + q->itemSize);
+    return pdTRUE;
+}
+inline BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait) {
+    if (q->items.empty()) {
+        return pdFALSE;
+    }
+    memcpy(item, q->items.front().data(), q->itemSize);
+    q->items.pop_front();
+    return pdTRUE;
+}
+inline BaseType_t xQueueOverwrite(QueueHandle_t q, const void *item) {
+    q->items.clear();
+    return xQueueSend(q, item, 0);
+}
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) { return q->items.size(); }
+inline UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q) { return q->length - q->items.size(); }
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return xQueueCreate(1, 0); }
+inline SemaphoreHandle_t xSemaphoreCreateBinary() { return xQueueCreate(1, 0); }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t wait) { return pdTRUE; }
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t s) { return pdTRUE; }
+inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() { return xQueueCreate(1, 0); }
+inline BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t s, TickType_t wait) { return pdTRUE; }
+inline BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t s) { return pdTRUE; }
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *param, UBaseType_t priority,
+                                          TaskHandle_t *handle, BaseType_t core) {
+    printf("(SIM)=> Skip task: %s\n", name);
+    if (handle) {
+        *handle = NULL;
+    }
+    return pdPASS;
+}
+inline BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *param, UBaseType_t priority, TaskHandle_t *handle) {
+    return xTaskCreatePinnedToCore(fn, name, stack, param, priority, handle, 0);
+}
+inline void vTaskDelay(TickType_t ticks) { delay(ticks); }
+inline void vTaskDelete(TaskHandle_t handle) {}
+inline TickType_t xTaskGetTickCount() { return millis(); }
+inline void xTaskNotifyGive(TaskHandle_t handle) {}
+inline uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait) { return 0; }
+
+#include "esp_heap_caps.h"
+
+#endif // __cplusplus
+
+#endif // SIM_ARDUINO_H
@@ -0,0 +1,115 @@
+#ifndef SIM_FS_H
+#define SIM_FS_H
+
+#include "Arduino.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+// ไฟล์/โฟลเดอร์บน host ใต้ root ของ FS (copy แล้วใช้ handle เดียวกัน เหมือน File จริงที่ใช้ shared_ptr)
+class File : public Stream {
+  public:
+    File(FILE *handle = NULL, const String &path = "") : handle(handle), dir(NULL), path(path) {}
+    File(DIR *dir, const String &path) : handle(NULL), dir(dir), path(path) {}
+    explicit operator bool() const { return handle != NULL || dir != NULL; }
+    int available() override { return handle != NULL && peek() >= 0 ? 1 : 0; }
+    int read() override { return handle != NULL ? fgetc(handle) : -1; }
+    size_t read(uint8_t *buffer, size_t size) { return handle != NULL ? fread(buffer, 1, size, handle) : 0; }
+    int peek() override {
+        if (handle == NULL) {
+            return -1;
+        }
+        int c = fgetc(handle);
+        if (c >= 0) {
+            ungetc(c, handle);
+        }
+        return c;
+    }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *data, size_t size) override { return handle != NULL ? fwrite(data, 1, size, handle) : 0; }
+    void flush() {
+        if (handle != NULL) {
+            fflush(handle);
+        }
+    }
+    bool seek(uint32_t position) { return handle != NULL && fseek(handle, position, SEEK_SET) == 0; }
+    size_t position() { return handle != NULL ? ftell(handle) : 0; }
+    size_t size() {
+        if (handle == NULL) {
+            return 0;
+        }
+        fflush(handle);
+        struct stat info;
+        return fstat(fileno(handle), &info) == 0 ? info.st_size : 0;
+    }
+    const char *name() const {
+        const char *slash = strrchr(path.c_str(), '/');
+        return slash != NULL ? slash + 1 : path.c_str();
+    }
+    bool isDirectory() const { return dir != NULL; }
+    File openNextFile() {
+        for (struct dirent *entry; dir != NULL && (entry = readdir(dir)) != NULL;) {
+            if (entry->d_name[0] != '.') {
+                String child = path + "/" + entry->d_name;
+                return File(fopen(child.c_str(), "rb"), child);
+            }
+        }
+        return File();
+    }
+    void close() {
+        if (handle != NULL) {
+            fclose(handle);
+            handle = NULL;
+        }
+        if (dir != NULL) {
+            closedir(dir);
+            dir = NULL;
+        }
+    }
+
+  private:
+    FILE *handle;
+    DIR *dir;
+    String path; // path บน host
+};
+
+// path ของ Arduino ("/logo.pbm") อยู่ใต้โฟลเดอร์ root บน host
+class FS {
+  public:
+    FS(const char *root) : root(root) {}
+    File open(const char *path, const char *mode = "r") {
+        String hostPath = root + path;
+        struct stat info;
+        if (mode[0] == 'r' && stat(hostPath.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+            return File(opendir(hostPath.c_str()), hostPath);
+        }
+        return File(fopen(hostPath.c_str(), mode[0] == 'w' ? "wb" : mode[0] == 'a' ? "ab" : "rb"), hostPath);
+    }
+    File open(const String &path, const char *mode = "r") { return open(path.c_str(), mode); }
+    bool exists(const char *path) {
+        struct stat info;
+        return stat((root + path).c_str(), &info) == 0;
+    }
+    bool exists(const String &path) { return exists(path.c_str()); }
+    bool remove(const char *path) { return ::remove((root + path).c_str()) == 0; }
+    bool remove(const String &path) { return remove(path.c_str()); }
+    bool mkdir(const char *path) { return ::mkdir((root + path).c_str(), 0755) == 0; }
+    bool mkdir(const String &path) { return mkdir(path.c_str()); }
+    bool rename(const char *from, const char *to) { return ::rename((root + from).c_str(), (root + to).c_str()) == 0; }
+
+  protected:
+    String root;
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+
+#endif // SIM_FS_H
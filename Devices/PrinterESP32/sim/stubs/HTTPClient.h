@@ -0,0 +1,27 @@
+#ifndef SIM_HTTPCLIENT_H
+#define SIM_HTTPCLIENT_H
+
+#include "WiFi.h"
+
+#define HTTP_CODE_OK 200
+#define HTTP_CODE_CREATED 201
+#define HTTP_CODE_NOT_FOUND 404
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+
+// ไม่มี network: ทุก request ตอบ connection refused
+class HTTPClient {
+  public:
+    bool begin(const String &url) { return true; }
+    bool begin(WiFiClient &client, const String &url) { return true; }
+    void addHeader(const String &name, const String &value) {}
+    void setReuse(bool reuse) {}
+    void setTimeout(uint16_t timeout) {}
+    int GET() { return HTTPC_ERROR_CONNECTION_REFUSED; }
+    int POST(const String &payload) { return HTTPC_ERROR_CONNECTION_REFUSED; }
+    String getString() { return ""; }
+    static String errorToString(int error) { return "simulator: no network"; }
+    void end() {}
+};
+
+#endif // SIM_HTTPCLIENT_H
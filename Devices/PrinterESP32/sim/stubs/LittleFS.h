@@ -0,0 +1,19 @@
+#ifndef SIM_LITTLEFS_H
+#define SIM_LITTLEFS_H
+
+#include "FS.h"
+
+// ไฟล์ของ LittleFS อยู่ในโฟลเดอร์ sim/fs บน host แทน flash (เช่น sim/fs/logo.pbm)
+class LittleFSClass : public fs::FS {
+  public:
+    LittleFSClass() : FS("sim/fs") {}
+    bool begin(bool formatOnFail = false) {
+        ::mkdir(root.c_str(), 0755);
+        return true;
+    }
+    size_t totalBytes() { return 0x1E0000; } // ขนาด partition spiffs ใน boards/partitionsV2.csv
+};
+
+extern LittleFSClass LittleFS;
+
+#endif // SIM_LITTLEFS_H
@@ -0,0 +1,22 @@
+#ifndef SIM_NTPCLIENT_H
+#define SIM_NTPCLIENT_H
+
+#include "WiFiUdp.h"
+#include <ctime>
+
+class NTPClient {
+  public:
+    NTPClient(WiFiUDP &udp) {}
+    void begin() {}
+    bool update() { return true; }
+    bool forceUpdate() { return true; }
+    unsigned long getEpochTime() { return time(NULL) + offset; }
+    void setPoolServerName(const char *server) {}
+    void setTimeOffset(int offset) { this->offset = offset; }
+    void setUpdateInterval(unsigned long interval) {}
+
+  private:
+    int offset = 0;
+};
+
+#endif // SIM_NTPCLIENT_H
@@ -0,0 +1,28 @@
+#ifndef SIM_PCF8574_H
+#define SIM_PCF8574_H
+
+#include "Arduino.h"
+
+#define P0 0
+#define P1 1
+#define P2 2
+#define P3 3
+#define P4 4
+#define P5 5
+#define P6 6
+#define P7 7
+#define OUTPUT 0x03
+#define INPUT 0x01
+#define LOW 0x0
+#define HIGH 0x1
+
+class PCF8574 {
+  public:
+    PCF8574(uint8_t address) {}
+    bool begin() { return true; }
+    void pinMode(uint8_t pin, uint8_t mode) {}
+    bool digitalWrite(uint8_t pin, uint8_t value) { return true; }
+    uint8_t digitalRead(uint8_t pin) { return HIGH; }
+};
+
+#endif // SIM_PCF8574_H
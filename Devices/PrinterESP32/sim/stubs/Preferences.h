@@ -0,0 +1,74 @@
+#ifndef SIM_PREFERENCES_H
+#define SIM_PREFERENCES_H
+
+#include "Arduino.h"
+#include <map>
+
+// เก็บค่าใน RAM (หายเมื่อปิด simulator)
+class Preferences {
+  public:
+    bool begin(const char *name, bool readOnly = false) {
+        ns = name;
+        return true;
+    }
+    void end() {}
+    bool clear() {
+        store()[ns].clear();
+        return true;
+    }
+    bool remove(const char *key) { return store()[ns].erase(key) > 0; }
+    bool isKey(const char *key) { return store()[ns].count(key) > 0; }
+
+    size_t putBool(const char *key, bool value) { return put(key, &value, sizeof(value)); }
+    size_t putInt(const char *key, int32_t value) { return put(key, &value, sizeof(value)); }
+    size_t putUInt(const char *key, uint32_t value) { return put(key, &value, sizeof(value)); }
+    size_t putULong(const char *key, uint32_t value) { return put(key, &value, sizeof(value)); }
+    size_t putFloat(const char *key, float value) { return put(key, &value, sizeof(value)); }
+    size_t putString(const char *key, const String &value) { return put(key, value.c_str(), value.length() + 1); }
+    size_t putBytes(const char *key, const void *value, size_t len) { return put(key, value, len); }
+
+    bool getBool(const char *key, bool def = false) { return get(key, def); }
+    int32_t getInt(const char *key, int32_t def = 0) { return get(key, def); }
+    uint32_t getUInt(const char *key, uint32_t def = 0) { return get(key, def); }
+    uint32_t getULong(const char *key, uint32_t def = 0) { return get(key, def); }
+    float getFloat(const char *key, float def = 0) { return get(key, def); }
+    String getString(const char *key, const String &def = String()) {
+        auto it = store()[ns].find(key);
+        return it == store()[ns].end() ? def : String((const char *)it->second.data());
+    }
+    size_t getBytesLength(const char *key) {
+        auto it = store()[ns].find(key);
+        return it == store()[ns].end() ? 0 : it->second.size();
+    }
+    size_t getBytes(const char *key, void *buf, size_t maxLen) {
+        auto it = store()[ns].find(key);
+        if (it == store()[ns].end() || it->second.size() > maxLen) {
+            return 0;
+        }
+        memcpy(buf, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+
+  private:
+    std::string ns;
+
+    static std::map<std::string, std::map<std::string, std::vector<uint8_t>>> &store() {
+        static std::map<std::string, std::map<std::string, std::vector<uint8_t>>> data;
+        return data;
+    }
+    size_t put(const char *key, const void *value, size_t len) {
+        store()[ns][key] = std::vector<uint8_t>((const uint8_t *)value, (const uint8_t *)value + len);
+        return len;
+    }
+    template <typename T> T get(const char *key, T def) {
+        auto it = store()[ns].find(key);
+        if (it == store()[ns].end() || it->second.size() != sizeof(T)) {
+            return def;
+        }
+        T value;
+        memcpy(&value, it->second.data(), sizeof(T));
+        return value;
+    }
+};
+
+#endif // SIM_PREFERENCES_H
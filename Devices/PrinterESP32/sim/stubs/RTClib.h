@@ -0,0 +1,38 @@
+#ifndef SIM_RTCLIB_H
+#define SIM_RTCLIB_H
+
+#include "Arduino.h"
+#include <ctime>
+
+class DateTime {
+  public:
+    DateTime(time_t t = 0) : t(t) { gmtime_r(&this->t, &tm); }
+    uint16_t year() const { return tm.tm_year + 1900; }
+    uint8_t month() const { return tm.tm_mon + 1; }
+    uint8_t day() const { return tm.tm_mday; }
+    uint8_t hour() const { return tm.tm_hour; }
+    uint8_t minute() const { return tm.tm_min; }
+    uint8_t second() const { return tm.tm_sec; }
+    uint32_t unixtime() const { return t; }
+
+    // รองรับเฉพาะรูปแบบ "YYYY-MM-DD hh:mm:ss" ที่ main.cpp ใช้
+    char *toString(char *buffer) const {
+        snprintf(buffer, 20, "%04d-%02d-%02d %02d:%02d:%02d", year(), month(), day(), hour(), minute(), second());
+        return buffer;
+    }
+
+  private:
+    time_t t;
+    struct tm tm;
+};
+
+// เวลาท้องถิ่นของ host (UTC+7)
+class RTC_DS3231 {
+  public:
+    bool begin() { return true; }
+    DateTime now() { return DateTime(time(NULL) + 7 * 3600); }
+    void adjust(const DateTime &dt) {}
+    bool lostPower() { return false; }
+};
+
+#endif // SIM_RTCLIB_H
@@ -0,0 +1,36 @@
+#ifndef SIM_SD_H
+#define SIM_SD_H
+
+#include "FS.h"
+#include "SPI.h"
+
+typedef enum { CARD_NONE, CARD_MMC, CARD_SD, CARD_SDHC, CARD_UNKNOWN } sdcard_type_t;
+
+// ไฟล์ของ SD card อยู่ในโฟลเดอร์ sim/sd บน host: ไม่มีโฟลเดอร์ = ไม่ได้เสียบการ์ด (คำสั่ง "sd eject" ของ scenario ย้ายโฟลเดอร์ออก)
+class SDFS : public fs::FS {
+  public:
+    SDFS() : FS("sim/sd"), mounted(false) {}
+    bool begin(uint8_t ssPin, SPIClass &spi, uint32_t frequency = 4000000) {
+        mounted = present();
+        return mounted;
+    }
+    void end() { mounted = false; }
+    sdcard_type_t cardType() { return mounted ? CARD_SDHC : CARD_NONE; }
+    uint64_t cardSize() { return mounted ? 8ULL * 1024 * 1024 * 1024 : 0; }
+    bool readRAW(uint8_t *buffer, uint32_t sector) {
+        memset(buffer, 0, 512);
+        return mounted && present();
+    }
+
+  private:
+    bool mounted;
+
+    bool present() {
+        struct stat info;
+        return stat(root.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+    }
+};
+
+extern SDFS SD;
+
+#endif // SIM_SD_H
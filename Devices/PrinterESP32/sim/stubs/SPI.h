@@ -0,0 +1,17 @@
+#ifndef SIM_SPI_H
+#define SIM_SPI_H
+
+#include "Arduino.h"
+
+#define FSPI 0
+#define HSPI 1
+
+// SD card บน host ไม่ผ่าน SPI จริง เก็บไว้ให้ code ที่ตั้งขาเรียกได้
+class SPIClass {
+  public:
+    SPIClass(uint8_t bus = HSPI) {}
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {}
+    void end() {}
+};
+
+#endif // SIM_SPI_H
@@ -0,0 +1 @@
+// ไม่ใช้ใน simulator
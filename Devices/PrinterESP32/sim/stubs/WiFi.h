@@ -0,0 +1,32 @@
+#ifndef SIM_WIFI_H
+#define SIM_WIFI_H
+
+#include "Arduino.h"
+
+typedef enum { WL_IDLE_STATUS = 0, WL_CONNECTED = 3, WL_DISCONNECTED = 6 } wl_status_t;
+
+class IPAddress {
+  public:
+    String toString() const { return "127.0.0.1"; }
+    operator String() const { return toString(); }
+};
+
+class WiFiClass {
+  public:
+    void begin(const char *ssid, const char *password) { this->ssid = ssid; }
+    wl_status_t status() { return WL_CONNECTED; }
+    IPAddress localIP() { return IPAddress(); }
+    String SSID() { return ssid; }
+
+  private:
+    String ssid;
+};
+extern WiFiClass WiFi;
+
+class WiFiClient {
+  public:
+    bool connected() { return false; }
+    void stop() {}
+};
+
+#endif // SIM_WIFI_H
@@ -0,0 +1,8 @@
+#ifndef SIM_WIFIUDP_H
+#define SIM_WIFIUDP_H
+
+#include "Arduino.h"
+
+class WiFiUDP {};
+
+#endif // SIM_WIFIUDP_H
@@ -0,0 +1,12 @@
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+#include "Arduino.h"
+
+class TwoWire {
+  public:
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) { return true; }
+};
+extern TwoWire Wire;
+
+#endif // SIM_WIRE_H
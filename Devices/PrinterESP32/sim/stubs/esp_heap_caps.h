@@ -0,0 +1,20 @@
+#ifndef SIM_ESP_HEAP_CAPS_H
+#define SIM_ESP_HEAP_CAPS_H
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+
+static inline void *heap_caps_malloc(size_t size, unsigned int caps) { return malloc(size); }
+static inline void *heap_caps_calloc(size_t n, size_t size, unsigned int caps) { return calloc(n, size); }
+static inline void *heap_caps_aligned_alloc(size_t alignment, size_t size, unsigned int caps) { return aligned_alloc(alignment, size); }
+static inline void heap_caps_free(void *ptr) { free(ptr); }
+static inline size_t heap_caps_get_free_size(unsigned int caps) { return 200 * 1024; }
+static inline size_t heap_caps_get_minimum_free_size(unsigned int caps) { return 200 * 1024; }
+static inline size_t heap_caps_get_largest_free_block(unsigned int caps) { return 100 * 1024; }
+
+#endif // SIM_ESP_HEAP_CAPS_H
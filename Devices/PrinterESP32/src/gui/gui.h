@@ -15,25 +15,81 @@
 
 #if defined(LGFX_LCD4_3)
   #include "../gfx/LGFX_ESP32S3_RGB_MakerfabsParallelTFTwithTouch4_3.h"
+  #define GUI_VSYNC_PIN 41
 
 #elif defined(LGFX_LCD7_0)
   #include "../gfx/LGFX_ESP32S3_RGB_MakerfabsParallelTFTwithTouch7_0.h"
+  #define GUI_VSYNC_PIN 40
 
 #endif
 
+// GUI_FULL_FRAME: วาดทั้งเฟรมลง buffer 2 ชุดใน PSRAM (full_refresh) แล้วคัดลอกลง framebuffer ของ panel หลัง vsync
+// ไม่ได้กำหนด: วาดทีละแถบ 10 บรรทัดใน internal RAM (แบบเดิม)
+#define GUI_VSYNC_TIMEOUT 50      // ms
+
 static const char* TAG = "gui";
 
 static const uint16_t screenWidth  = 800;
 static const uint16_t screenHeight = 480;
 
 static lv_disp_draw_buf_t draw_buf;
+#if !defined(GUI_FULL_FRAME)
 static lv_color_t buf[2][ screenWidth * 10 ];
+#endif
 
 LGFX gfx;
 
+// สถิติการ flush (micros) ล้างทุกครั้งที่พิมพ์สถิติ
+struct GuiFlushStats {
+  uint32_t refreshes;             // จำนวนรอบ refresh ที่วาดจริง (จาก monitor_cb)
+  uint32_t refreshTime;           // เวลารวมของรอบ refresh (ms, render + flush)
+  uint32_t flushes;
+  uint32_t flushTotal;
+  uint32_t flushMax;
+  uint32_t vsyncWait;             // เวลารวมที่รอ vsync
+  uint32_t vsyncTimeouts;
+  uint32_t inputs;                // ข้อมูลเข้า -> วาดเสร็จ
+  uint32_t inputTotal;
+  uint32_t inputMax;
+};
+static GuiFlushStats guiFlushStats;
+static uint32_t guiInputOrigin = 0; // ข้อมูลเข้าที่ยังรอวาดลงจอ
+
+#if defined(GUI_FULL_FRAME)
+static SemaphoreHandle_t vsyncSemaphore = NULL;
+
+static void IRAM_ATTR gui_vsync_isr()
+{
+  BaseType_t woken = pdFALSE;
+  xSemaphoreGiveFromISR(vsyncSemaphore, &woken);
+  if (woken) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+// ฟังสัญญาณ vsync จากขาที่ RGB peripheral ขับอยู่ (เปิด input buffer ของขาโดยไม่เปลี่ยน output)
+static void gui_vsync_begin()
+{
+  vsyncSemaphore = xSemaphoreCreateBinary();
+  PIN_INPUT_ENABLE(GPIO_PIN_MUX_REG[GUI_VSYNC_PIN]);
+  attachInterrupt(GUI_VSYNC_PIN, gui_vsync_isr, FALLING);
+}
+#endif
+
 /* Display flushing */
 void my_disp_flush( lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p )
 {
+    uint32_t start = micros();
+
+#if defined(GUI_FULL_FRAME)
+    // เริ่มคัดลอกหลัง vsync: การคัดลอกเร็วกว่าการ scan ของ panel จึงไม่ตัดผ่านเส้น scan (ไม่ฉีก)
+    xSemaphoreTake(vsyncSemaphore, 0);
+    if (xSemaphoreTake(vsyncSemaphore, pdMS_TO_TICKS(GUI_VSYNC_TIMEOUT)) != pdTRUE) {
+        guiFlushStats.vsyncTimeouts++;
+    }
+    guiFlushStats.vsyncWait += micros() - start;
+#endif
+
     if (gfx.getStartCount() == 0)
     {   // Processing if not yet started
         gfx.startWrite();
@@ -43,10 +99,31 @@ void my_disp_flush( lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *colo
                     , area->x2 - area->x1 + 1
                     , area->y2 - area->y1 + 1
                     , ( lgfx::rgb565_t* )&color_p->full);
+
+    uint32_t elapsed = micros() - start;
+    guiFlushStats.flushes++;
+    guiFlushStats.flushTotal += elapsed;
+    guiFlushStats.flushMax = max(guiFlushStats.flushMax, elapsed);
+
     lv_disp_flush_ready( disp );
 }
 
 
+void my_disp_monitor( lv_disp_drv_t *disp, uint32_t time, uint32_t px )
+{
+    guiFlushStats.refreshes++;
+    guiFlushStats.refreshTime += time;
+
+    // รอบ refresh นี้วาดผลจากข้อมูลเข้าเสร็จแล้ว (flush ลง framebuffer ของ panel แล้ว)
+    if (guiInputOrigin != 0) {
+        uint32_t latency = micros() - guiInputOrigin;
+        guiFlushStats.inputs++;
+        guiFlushStats.inputTotal += latency;
+        guiFlushStats.inputMax = max(guiFlushStats.inputMax, latency);
+        guiInputOrigin = 0;
+    }
+}
+
 /*Read the touchpad*/
 void my_touchpad_read( lv_indev_drv_t * indev_driver, lv_indev_data_t * data )
 {
@@ -81,7 +158,6 @@ void gui_start() {
 
 
   lv_init();
-  lv_disp_draw_buf_init( &draw_buf, buf[0], buf[1], screenWidth * 10 );
 
   /*Initialize the display*/
   static lv_disp_drv_t disp_drv;
@@ -89,6 +165,23 @@ void gui_start() {
   disp_drv.hor_res = screenWidth;
   disp_drv.ver_res = screenHeight;
   disp_drv.flush_cb = my_disp_flush;
+  disp_drv.monitor_cb = my_disp_monitor;
+
+#if defined(GUI_FULL_FRAME)
+  size_t frameSize = screenWidth * screenHeight;
+  lv_color_t *frame1 = (lv_color_t *)heap_caps_malloc(frameSize * sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
+  lv_color_t *frame2 = (lv_color_t *)heap_caps_malloc(frameSize * sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
+  if (frame1 == NULL || frame2 == NULL) {
+    ESP_LOGE(TAG, "Allocate full-frame buffers in PSRAM failed");
+    abort();
+  }
+  lv_disp_draw_buf_init( &draw_buf, frame1, frame2, frameSize );
+  disp_drv.full_refresh = 1;
+  gui_vsync_begin();
+#else
+  lv_disp_draw_buf_init( &draw_buf, buf[0], buf[1], screenWidth * 10 );
+#endif
+
   disp_drv.draw_buf = &draw_buf;
   lv_disp_drv_register( &disp_drv );
 
@@ -102,4 +195,152 @@ void gui_start() {
   ui_init();
 }
 
+// ===== LVGL task =====
+// gui_task เป็น task เดียวที่เรียก lv_* หลังจาก gui_task_start()
+// task อื่นส่งข้อความผ่าน gui_post() แล้ว handler จะถูกเรียกใน gui_task
+#define GUI_TASK_CORE 1
+#define GUI_TASK_PRIORITY 2       // สูงกว่า loop() เพื่อไม่ให้งานพิมพ์บล็อกหน้าจอ
+#define GUI_TASK_STACK 8192
+#define GUI_TASK_PERIOD 5         // ms
+#define GUI_QUEUE_SIZE 16
+#define GUI_STATS_INTERVAL 10000  // ms
+#define GUI_LATENCY_TARGET 30     // ms
+
+struct UiMessage {
+  int type;
+  bool flag;
+  float value;
+  char text[48];
+  uint32_t posted;                // micros() ตอนส่ง (ใช้วัด latency)
+  uint32_t origin;                // micros() ตอนข้อมูลจากเครื่องชั่งเข้ามา (0 = ไม่วัด)
+};
+
+typedef void (*UiMessageHandler)(const UiMessage &msg);
+
+static QueueHandle_t guiQueue = NULL;
+static UiMessageHandler guiHandler = NULL;
+
+// สถิติเวลา (micros) ล้างทุก GUI_STATS_INTERVAL
+struct GuiStats {
+  uint32_t frames;
+  uint32_t frameTotal;            // เวลารวมใน lv_timer_handler()
+  uint32_t frameMax;
+  uint32_t gapMax;                // ช่วงห่างสูงสุดระหว่าง lv_timer_handler() สองครั้ง
+  uint32_t messages;
+  uint32_t latencyMax;            // ส่งข้อความ -> apply
+  uint32_t overTarget;            // จำนวนครั้งที่ gap หรือ latency เกิน GUI_LATENCY_TARGET
+  uint32_t dropped;               // ข้อความที่ทิ้งเพราะ queue เต็ม
+};
+static GuiStats guiStats;
+
+bool gui_post(int type, bool flag = false, float value = 0, const char *text = NULL, uint32_t origin = 0)
+{
+  if (guiQueue == NULL) {
+    return false;
+  }
+
+  UiMessage msg;
+  msg.type = type;
+  msg.flag = flag;
+  msg.value = value;
+  strlcpy(msg.text, text ? text : "", sizeof(msg.text));
+  msg.posted = micros();
+  msg.origin = origin;
+
+  if (xQueueSend(guiQueue, &msg, 0) != pdTRUE) {
+    guiStats.dropped++;
+    return false;
+  }
+  return true;
+}
+
+static void gui_print_stats(uint32_t elapsedMs)
+{
+  Serial.printf("(GUI)=> frames: %u, frame avg/max: %.1f/%.1f ms, gap max: %.1f ms, msgs: %u, latency max: %.1f ms, over %d ms: %u, dropped: %u\n",
+                guiStats.frames, guiStats.frames ? guiStats.frameTotal / 1000.0 / guiStats.frames : 0, guiStats.frameMax / 1000.0,
+                guiStats.gapMax / 1000.0, guiStats.messages, guiStats.latencyMax / 1000.0, GUI_LATENCY_TARGET, guiStats.overTarget,
+                guiStats.dropped);
+
+  // fps = รอบ refresh ต่อวินาที, cpu = สัดส่วนเวลาใน lv_timer_handler() (รวมเวลารอ vsync)
+  Serial.printf("(GUI)=> mode: %s, fps: %.1f, refresh avg: %.1f ms, cpu: %.1f%%, flush avg/max: %.1f/%.1f ms, vsync wait: %.1f ms, vsync timeouts: %u\n",
+#if defined(GUI_FULL_FRAME)
+                "full-frame",
+#else
+                "partial",
+#endif
+                guiFlushStats.refreshes * 1000.0 / elapsedMs,
+                guiFlushStats.refreshes ? (float)guiFlushStats.refreshTime / guiFlushStats.refreshes : 0, guiStats.frameTotal / 10.0 / elapsedMs,
+                guiFlushStats.flushes ? guiFlushStats.flushTotal / 1000.0 / guiFlushStats.flushes : 0, guiFlushStats.flushMax / 1000.0,
+                guiFlushStats.vsyncWait / 1000.0, guiFlushStats.vsyncTimeouts);
+
+  if (guiFlushStats.inputs > 0) {
+    Serial.printf("(GUI)=> input->pixels: %u, avg/max: %.1f/%.1f ms\n", guiFlushStats.inputs,
+                  guiFlushStats.inputTotal / 1000.0 / guiFlushStats.inputs, guiFlushStats.inputMax / 1000.0);
+  }
+
+  memset(&guiStats, 0, sizeof(guiStats));
+  memset(&guiFlushStats, 0, sizeof(guiFlushStats));
+}
+
+static void gui_task(void *parameter)
+{
+  uint32_t lastFrame = micros();
+  unsigned long lastStats = millis();
+
+  for (;;) {
+    // รอข้อความไม่เกิน GUI_TASK_PERIOD แล้วค่อยวาดหน้าจอ
+    UiMessage msg;
+    if (xQueueReceive(guiQueue, &msg, pdMS_TO_TICKS(GUI_TASK_PERIOD)) == pdTRUE) {
+      do {
+        uint32_t latency = micros() - msg.posted;
+        guiStats.messages++;
+        guiStats.latencyMax = max(guiStats.latencyMax, latency);
+        if (latency > GUI_LATENCY_TARGET * 1000) {
+          guiStats.overTarget++;
+        }
+        if (msg.origin != 0 && guiInputOrigin == 0) {
+          guiInputOrigin = msg.origin;
+        }
+        guiHandler(msg);
+      } while (xQueueReceive(guiQueue, &msg, 0) == pdTRUE);
+    }
+
+    uint32_t start = micros();
+    uint32_t gap = start - lastFrame;
+    lv_timer_handler();
+    uint32_t end = micros();
+    lastFrame = end;
+
+    guiStats.frames++;
+    guiStats.frameTotal += end - start;
+    guiStats.frameMax = max(guiStats.frameMax, end - start);
+    guiStats.gapMax = max(guiStats.gapMax, gap);
+    if (gap > GUI_LATENCY_TARGET * 1000) {
+      guiStats.overTarget++;
+    }
+
+    if (millis() - lastStats >= GUI_STATS_INTERVAL) {
+      gui_print_stats(millis() - lastStats);
+      lastStats = millis();
+    }
+  }
+}
+
+// ขอให้วาดหน้าจอในรอบถัดไปทันทีโดยไม่ต้องรอ LV_DISP_DEF_REFR_PERIOD (เรียกใน LVGL task เท่านั้น)
+void gui_refresh_soon()
+{
+  lv_disp_t *disp = lv_disp_get_default();
+  if (disp != NULL && disp->refr_timer != NULL) {
+    lv_timer_ready(disp->refr_timer);
+  }
+}
+
+// เริ่ม LVGL task (เรียกหลังตั้งค่า UI ใน setup() เสร็จ)
+void gui_task_start(UiMessageHandler handler)
+{
+  guiHandler = handler;
+  guiQueue = xQueueCreate(GUI_QUEUE_SIZE, sizeof(UiMessage));
+  xTaskCreatePinnedToCore(gui_task, "LVGL Task", GUI_TASK_STACK, NULL, GUI_TASK_PRIORITY, NULL, GUI_TASK_CORE);
+}
+
 
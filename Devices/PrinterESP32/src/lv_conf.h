@@ -46,18 +46,21 @@
  *=========================*/
 
 /*1: use custom malloc/free, 0: use the built-in `lv_mem_alloc()` and `lv_mem_free()`*/
-#define LV_MEM_CUSTOM 1
+/*LVGL ใช้ TLSF pool ของตัวเองใน PSRAM แยกจาก heap หลัก (HTTPClient, ArduinoJson, WiFi)*/
+#define LV_MEM_CUSTOM 0
 #if LV_MEM_CUSTOM == 0
     /*Size of the memory available for `lv_mem_alloc()` in bytes (>= 2kB)*/
     // #define LV_MEM_SIZE (48U * 1024U)          /*[bytes]*/
-    #define LV_MEM_SIZE (200U * 1024U)          /*[bytes]*/
+    #ifndef LV_MEM_SIZE
+    #define LV_MEM_SIZE (1024U * 1024U)          /*[bytes] ปรับได้ด้วย -DLV_MEM_SIZE=...*/
+    #endif
 
     /*Set an address for the memory pool instead of allocating it as a normal array. Can be in external SRAM too.*/
     #define LV_MEM_ADR 0     /*0: unused*/
     /*Instead of an address give a memory allocator that will be called to get a memory pool for LVGL. E.g. my_malloc*/
     #if LV_MEM_ADR == 0
-        #undef LV_MEM_POOL_INCLUDE
-        #undef LV_MEM_POOL_ALLOC
+        #define LV_MEM_POOL_INCLUDE <esp_heap_caps.h>
+        #define LV_MEM_POOL_ALLOC(size) heap_caps_malloc(size, MALLOC_CAP_SPIRAM)
     #endif
 
 #else       /*LV_MEM_CUSTOM*/
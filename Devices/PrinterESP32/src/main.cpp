@@ -1,17 +1,35 @@
 #define LGFX_LCD4_3
 // #define LGFX_LCD7_0
 // #define TOUCH_DEBUG
+// #define GUI_FULL_FRAME
 
+#ifdef SIMULATOR
+#include "sim_gui.h"
+#else
 #include "./gui/gui.h"
+#endif
 #include <Arduino.h>
 #include <Wire.h>
 #include <lv_conf.h>
 #include <lvgl.h>
 #include <queue>
 
+#include "AuditLog.h"
+#include "BalanceProtocol.h"
+#include "BatchUploader.h"
+#include "Outbox.h"
+#include "EscRaster.h"
+#include "PrintSpooler.h"
 #include "Printer.h"
+#include "ReceiptTemplate.h"
+#include "RecordPool.h"
+#include "SDCard.h"
+#include "ScaleReader.h"
+#include "SpcEngine.h"
+#include "StabilityDetector.h"
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
+#include <LittleFS.h>
 #include <NTPClient.h>
 #include <PCF8574.h>
 #include <RTClib.h>
@@ -24,8 +42,27 @@
 #include "./setting.h"
 
 Preferences preferences; // สร้างออบเจกต์
+SemaphoreHandle_t preferencesMutex = NULL;
+
+// preferences ใช้ร่วมกันระหว่าง LVGL task (หน้าตั้งค่า) และ loop (ตัวนับ) เปิด/ปิดผ่าน 2 ฟังก์ชันนี้เท่านั้น
+// (recursive: factoryReset ถูกเรียกระหว่าง loadConfiguration เปิดอยู่)
+void preferencesBegin(bool readOnly) {
+    xSemaphoreTakeRecursive(preferencesMutex, portMAX_DELAY);
+    preferences.begin(NAME_SPACE, readOnly);
+}
+
+void preferencesEnd() {
+    preferences.end();
+    xSemaphoreGiveRecursive(preferencesMutex);
+}
 bool devMode = false;
 
+// เครื่องชั่ง: SCALE_SERIAL (ตัวจริง), Serial (ทดสอบเมื่อเปิด devMode)
+enum ScalePort { SCALE_PORT_CONSOLE, SCALE_PORT_BALANCE };
+ScaleReader consoleScale;
+ScaleReader balanceScale;
+uint32_t serialInputTime = 0; // micros() ตอนได้รับ frame ล่าสุด (วัดเวลาจากข้อมูลเข้าถึงหน้าจอ)
+
 bool runTaskComplete = false;
 bool syncWifi = false;
 bool syncTime = false;
@@ -37,14 +74,33 @@ TaskHandle_t processQueueTaskHandle = NULL; // ตัวแปรเก็บ ha
 
 char chipid[23];
 
-String EmployeeID1 = "";
+String EmployeeID1 = ""; // ใช้ใน LVGL task เท่านั้น loop ใช้สำเนาใน operators
 String EmployeeID2 = "";
+
+// ผู้ปฏิบัติงานที่ login อยู่: LVGL task ส่งสำเนาให้ loop ผ่าน operatorQueue ตอน login/logout
+struct OperatorInfo {
+    bool loggedIn;
+    char id1[16];
+    char id2[16];
+};
+OperatorInfo operators = {}; // ใช้จาก loop เท่านั้น
+QueueHandle_t operatorQueue = NULL;
 int SET_MODE = 0;
 float SET_MIN_WEIGHT = 0.00;
 float SET_MAX_WEIGHT = 0.00;
 bool SET_PRINT_LOGO = false;
 bool SET_PRINT_PCS = false;
 int SET_PCS = 0;
+int SET_BALANCE_PROTOCOL = BALANCE_GENERIC;
+bool SET_AUTO_CAPTURE = false;
+int SET_STABLE_SAMPLES = DEFAULT_STABLE_SAMPLES;
+float SET_STABLE_STDDEV = DEFAULT_STABLE_STDDEV;
+float SET_ZERO_BAND = DEFAULT_ZERO_BAND;
+uint32_t SET_SCALE_BAUD = DEFAULT_SCALE_BAUD;
+uint32_t SET_PRINTER_BAUD = DEFAULT_PRINTER_BAUD;
+
+StabilityDetector stability;
+volatile bool stabilityChanged = true; // ตั้งค่าใหม่จากหน้าจอ ให้ loop เริ่ม detector ใหม่
 
 // Count
 unsigned long COUNT_GRAM_OK = 0;
@@ -57,18 +113,19 @@ bool isAlert = false;
 bool alertState = false;
 int alertRounds = 0;
 long alertTime = 0;
+unsigned long beepStart = 0; // millis() ตอนเริ่มเสียงสั้น (0 = เงียบ) ใช้จาก loop เท่านั้น
 
-QueueHandle_t dataQueue;
-
-// โครงสร้างเพื่อเก็บข้อมูลที่ต้องการส่ง
-struct DataToSend {
-    int mode;
-    JsonDocument jsonData; // กำหนดขนาดที่ชัดเจน
-    DataToSend() {}
-};
+// เสียงสั้น 1 ครั้ง ไม่ delay: loop ปิดเองหลัง BEEP_MS
+void beep() {
+    pcf8574.digitalWrite(P0, LOW);
+    beepStart = max(millis(), 1UL);
+}
 
-// ประกาศ Queue เป็น global
-QueueHandle_t xSendDataQueue = NULL;
+// ผลชั่งที่รอส่ง server: record จาก pool (PSRAM) ส่ง pointer ผ่าน dataQueue ให้ processQueueTask เขียนลง outbox แล้วคืน pool
+RecordPool recordPool;
+QueueHandle_t dataQueue;
+Outbox outbox;          // ใช้ใน processQueueTask เท่านั้น (หลัง begin ใน setup)
+BatchUploader uploader; // ใช้ใน processQueueTask เท่านั้น
 
 // ข้อมูล Wi-Fi
 int handshakeStatus = INITIAL;
@@ -87,11 +144,32 @@ NTPClient timeClient(ntpUDP);
 RTC_DS3231 rtc;
 
 Printer printer;
+PrintSpooler spooler;
+EscRaster raster; // โลโก้/QR/barcode ที่ render แล้ว (ใช้จาก loop เท่านั้น)
+SDCard sdCard;    // mount ครั้งเดียวใน setup, loop เรียก check() ตรวจการถอด/เสียบการ์ด (ใช้จาก loop เท่านั้น)
+AuditLog auditLog; // ประวัติผลชั่งทุกครั้งบน SD (ใช้จาก loop เท่านั้น, begin/end ตามการเสียบ/ถอดการ์ด)
+
+// ใบเสร็จ: compile ตอนเปิดเครื่อง/แก้ไข ตอนพิมพ์แค่เติมค่า field
+ReceiptTemplate receipts[RECEIPT_COUNT];
+String receiptSources[RECEIPT_COUNT];
+const char *const RECEIPT_FIELDS[RECEIPT_FIELD_COUNT] = {"date", "time", "weight", "min",    "max",     "pcs",
+                                                         "target", "op1", "op2",   "result", "machine", "serial", "record"};
+const char *const RECEIPT_FLAGS[RECEIPT_FLAG_COUNT] = {"logo"};
+const char *const RECEIPT_KEYS[RECEIPT_COUNT] = {MEM_RECEIPT_GRAM, MEM_RECEIPT_PCS, MEM_RECEIPT_TEST};
+const char *const RECEIPT_DEFAULTS[RECEIPT_COUNT] = {DEFAULT_RECEIPT_GRAM, DEFAULT_RECEIPT_PCS, DEFAULT_RECEIPT_TEST};
+
+// template ที่แก้ไขจากหน้าจอ ส่งให้ loop สลับแทนของเดิม (loop เป็นที่เดียวที่พิมพ์ใบเสร็จ)
+struct ReceiptUpdate {
+    int type;
+    ReceiptTemplate compiled;
+};
+QueueHandle_t receiptUpdateQueue = NULL;
 
 struct DateTimeInfo {
     String datetime;
     String date;
     String time;
+    uint32_t unixtime;
 };
 
 // ฟังก์ชันสำหรับการอ่านค่าเวลา
@@ -113,6 +191,7 @@ DateTimeInfo getDateTime() {
     dtInfo.datetime = datetime_buffer;
     dtInfo.date = String(date);
     dtInfo.time = String(time);
+    dtInfo.unixtime = now.unixtime();
 
     return dtInfo;
 }
@@ -142,9 +221,9 @@ void selectMode(lv_event_t *e) {
         lv_event_code_t event_code = lv_event_get_code(e);
         lv_obj_t *target = lv_event_get_target(e);
         SET_MODE = lv_obj_has_state(target, LV_STATE_CHECKED);
-        preferences.begin(NAME_SPACE, false);
+        preferencesBegin(false);
         preferences.putInt(MEM_SET_MODE, SET_MODE);
-        preferences.end();
+        preferencesEnd();
 
         setCurrentPage();
     }
@@ -175,7 +254,7 @@ void wifiConnectTask(void *parameter) {
 
     Serial.print("ESP32 IP Address: ");
     Serial.println(WiFi.localIP());
-    Serial.printf("\nWiFi connect to ssid: %s\n", WiFi.SSID());
+    Serial.printf("\nWiFi connect to ssid: %s\n", WiFi.SSID().c_str());
     syncWifi = true;
     vTaskDelay(1000 / portTICK_PERIOD_MS);
     xTaskNotifyGive(syncTimeTaskHandle);
@@ -241,8 +320,8 @@ void syncTimeTask(void *parameter) {
     }
 
     DateTimeInfo dt = getDateTime();
-    Serial.printf("Date: %s\n", dt.date);
-    Serial.printf("Time: %s\n", dt.time);
+    Serial.printf("Date: %s\n", dt.date.c_str());
+    Serial.printf("Time: %s\n", dt.time.c_str());
 
     syncTime = true; // ตั้งค่าว่า tasks ทั้งหมดเสร็จสิ้น
     xTaskNotifyGive(handShakeTaskHandle);
@@ -263,7 +342,6 @@ void updateUiMachine(lv_timer_t *timer) {
         lv_obj_set_style_text_font(ui_MachineName, &ui_font_NotoSans60, 0);
         lv_label_set_text(ui_MachineName, "Handshaking...");
         lv_obj_set_style_text_color(ui_MachineName, lv_color_hex(COLOR_GRAY), 0);
-        lv_refr_now(NULL); // อัพเดทหน้าจอทั้งหมดทันที
         break;
 
     case ERROR:
@@ -304,7 +382,6 @@ void updateUiMachine(lv_timer_t *timer) {
     }
 
     if (handshake_success) {
-        vTaskDelay(500 / portTICK_PERIOD_MS);
         lv_obj_clear_state(ui_UpdateDetails, LV_STATE_DISABLED);
         if (updateMachineNameTimer != NULL) {
             Serial.println("Delete updateMachineNameTimer...");
@@ -312,7 +389,7 @@ void updateUiMachine(lv_timer_t *timer) {
             updateMachineNameTimer = NULL;
         }
 
-        lv_refr_now(NULL); // อัพเดทหน้าจอทั้งหมดทันที
+        gui_refresh_soon();
     }
 }
 
@@ -407,28 +484,26 @@ void updateDetails(lv_event_t *e) {
 
 // อัพเดท Counter
 void updateCount(int _mode) {
-    preferences.begin(NAME_SPACE, false);
+    preferencesBegin(false);
 
     if (_mode == MODE_GRAM) {
-        lv_label_set_text_fmt(ui_OkGramCount, "%05u", COUNT_GRAM_OK);
-        lv_label_set_text_fmt(ui_NgGramCount, "%05u", COUNT_GRAM_NG);
         preferences.putULong(MEM_COUNT_GRAM_OK, COUNT_GRAM_OK);
         preferences.putULong(MEM_COUNT_GRAM_NG, COUNT_GRAM_NG);
         Serial.printf("(COUNT_GRAM)=> OK: %u, NG: %u\n", COUNT_GRAM_OK, COUNT_GRAM_NG);
     } else if (_mode == MODE_PCS) {
-        lv_label_set_text_fmt(ui_OkPcsCount, "%05u", COUNT_PCS_OK);
-        lv_label_set_text_fmt(ui_NgPcsCount, "%05u", COUNT_PCS_NG);
         preferences.putULong(MEM_COUNT_PCS_OK, COUNT_PCS_OK);
         preferences.putULong(MEM_COUNT_PCS_NG, COUNT_PCS_NG);
         Serial.printf("(COUNT_PCS)=> OK: %u, NG: %u\n", COUNT_PCS_OK, COUNT_PCS_NG);
     }
-    preferences.end();
+    preferencesEnd();
+
+    gui_post(UI_COUNT, false, _mode);
 }
 
 // รีเซ็ต Counter
 void resetCount(lv_event_t *e) {
     lv_obj_t *target = lv_event_get_target(e);
-    int _mode = (int)lv_event_get_user_data(e);
+    int _mode = (int)(intptr_t)lv_event_get_user_data(e);
 
     if (_mode == MODE_GRAM) {
         COUNT_GRAM_OK = 0;
@@ -441,263 +516,671 @@ void resetCount(lv_event_t *e) {
     updateCount(_mode);
 }
 
-// ฟังก์ชันสำหรับการส่งข้อมูลไปยัง Server
-bool sendDataToServer(JsonDocument *jsonData) {
-    String jsonString;
-    serializeJson(*jsonData, jsonString);
-    Serial.println("(Packing data)=> " + jsonString);
-
-    HTTPClient http;
-
-    int _data_mode = (*jsonData)["mode"].as<int>();
-    if (_data_mode == MODE_GRAM) {
-        http.begin(apiServer + "/devices/modeGram");
-    } else if (_data_mode == MODE_PCS) {
-        http.begin(apiServer + "/devices/modePcs");
+// แปลง record เป็น JSON ตอนส่ง (field เดียวกับที่ server รับ)
+// seq: ลำดับใน outbox คู่กับ serial_number (chipid) ไม่ซ้ำกัน server ใช้ตัด record ที่ส่งซ้ำหลัง ack หาย (NULL = ไม่ผ่าน outbox)
+void recordToJson(const WeighRecord &record, const uint32_t *seq, JsonObject doc) {
+    doc["timestamp"] = record.timestamp;
+    doc["serial_number"] = chipid;
+    if (seq != NULL) {
+        doc["seq"] = *seq;
+    }
+    doc["operator1"] = record.operator1;
+    doc["operator2"] = record.operator2;
+    if (record.mode == MODE_GRAM) {
+        doc["min_weight"] = record.minWeight;
+        doc["max_weight"] = record.maxWeight;
+        doc["weight"] = record.weight;
     } else {
-        http.end(); // ปิดการเชื่อมต่อ HTTP
-        Serial.println("Invalid mode");
-        return false;
+        doc["primary_pcs"] = record.target;
+        doc["pcs"] = record.pcs;
     }
+    doc["result"] = record.pass ? "PASS" : "FAIL";
+    doc["mode"] = record.mode;
+}
 
-    http.addHeader("Content-Type", "application/json");
-    http.addHeader("Authorization", String("Bearer ") + authorizationToken);
+// ส่งทีละ record ไป endpoint เดิม (server รุ่นที่ยังไม่มี /devices/batch)
+int sendDataToServer(const WeighRecord &record, const uint32_t *seq) {
+    JsonDocument doc;
+    recordToJson(record, seq, doc.to<JsonObject>());
+    String jsonString;
+    serializeJson(doc, jsonString);
+    Serial.println("(Packing data)=> " + jsonString);
 
-    int httpResponseCode = http.POST(jsonString);
-    bool success = false;
+    const char *path = record.mode == MODE_GRAM ? "/devices/modeGram" : "/devices/modePcs";
+    int httpResponseCode = uploader.post(path, jsonString, 1);
+    Serial.printf("(Response)=> %d: %s\n", httpResponseCode, uploader.response().c_str());
+    return httpResponseCode;
+}
 
-    if (httpResponseCode > 0) {
-        String response = http.getString();
-        Serial.printf("(Response)=> %d: %s\n", httpResponseCode, response.c_str());
+// ส่งหลาย record ใน request เดียว {"records": [...]} คืนค่า HTTP code ของ request สุดท้าย
+// seqs: seq ใน outbox ของแต่ละ record (NULL = ไม่ผ่าน outbox)
+// done: จำนวน record แรกที่ server ตอบแล้ว (รับหรือปฏิเสธ) ack ได้, record ตั้งแต่ done ไปต้องส่งใหม่
+int sendBatchToServer(const WeighRecord *batch, const uint32_t *seqs, uint8_t count, uint8_t &done) {
+    done = 0;
+    static bool batchSupported = true;
+    if (batchSupported) {
+        JsonDocument doc;
+        JsonArray records = doc["records"].to<JsonArray>();
+        for (uint8_t i = 0; i < count; i++) {
+            recordToJson(batch[i], seqs != NULL ? &seqs[i] : NULL, records.add<JsonObject>());
+        }
+        String jsonString;
+        serializeJson(doc, jsonString);
+        Serial.printf("(Packing data)=> %u records, %u bytes\n", count, jsonString.length());
+
+        int code = uploader.post("/devices/batch", jsonString, count);
+        Serial.printf("(Response)=> %d: %s\n", code, uploader.response().c_str());
+        if (code != HTTP_CODE_NOT_FOUND) {
+            if (code >= 200 && code < 500) {
+                done = count;
+            }
+            return code;
+        }
+        Serial.println("(Upload)=> Server has no batch endpoint, sending one record per request");
+        batchSupported = false;
+    }
 
-        if (httpResponseCode == HTTP_CODE_OK || httpResponseCode == HTTP_CODE_CREATED) {
-            success = true;
+    // ใช้ connection เดียวกันทุก record: server ปฏิเสธ (4xx) ทิ้งแค่ record นั้นแล้วส่งต่อ
+    // ส่งไม่ออก/server error หยุดที่ record นั้น record ก่อนหน้าที่ server รับแล้วไม่ต้องส่งซ้ำ
+    for (; done < count; done++) {
+        int code = sendDataToServer(batch[done], seqs != NULL ? &seqs[done] : NULL);
+        if (code < 0 || code >= 500) {
+            return code;
+        }
+        if (code != HTTP_CODE_OK && code != HTTP_CODE_CREATED) {
+            Serial.printf("(Upload)=> Record %s rejected (%d), dropped\n", batch[done].timestamp, code);
         }
-    } else {
-        Serial.printf("(HTTP Error)=> %d: %s\n", httpResponseCode, http.errorToString(httpResponseCode).c_str());
     }
+    return HTTP_CODE_OK;
+}
 
-    http.end();
-    return success;
+// ยืม record จาก pool และเติมค่าที่ใช้ร่วมกันทั้ง 2 mode (NULL = pool เต็ม ไม่ส่งครั้งนี้)
+WeighRecord *newRecord(uint8_t mode, const DateTimeInfo &dt, bool pass) {
+    WeighRecord *record = recordPool.acquire();
+    if (record == NULL) {
+        Serial.printf("(RecordPool)=> Pool full (%u records), data not queued\n", MAX_QUEUE_SIZE);
+        return NULL;
+    }
+    strlcpy(record->timestamp, dt.datetime.c_str(), sizeof(record->timestamp));
+    record->operator1 = atoi(operators.id1);
+    record->operator2 = atoi(operators.id2);
+    record->mode = mode;
+    record->pass = pass;
+    record->created = millis();
+    return record;
 }
 
-// ฟังก์ชันสำหรับการเพิ่มข้อมูลลงใน Queue
-void addDataToQueue(DataToSend dataToSend) {
-    Serial.print("Queue data to be sent: ");
-    Serial.print(uxQueueMessagesWaiting(dataQueue));
-    Serial.print(" ");
+// บันทึกผลชั่งลง SD ทุกครั้ง ไม่ขึ้นกับ pool/WiFi (ไม่มีการ์ดนับเป็น dropped ใน tab หน่วยความจำ)
+void auditWeighing(uint8_t mode, const DateTimeInfo &dt, bool pass, float value, float low, float high, const char *ticket) {
+    AuditRecord record = {};
+    record.time = dt.unixtime;
+    record.value = value;
+    record.low = low;
+    record.high = high;
+    record.operator1 = atoi(operators.id1);
+    record.operator2 = atoi(operators.id2);
+    record.mode = mode;
+    record.pass = pass;
+    record.printed = ticket != NULL && strcmp(ticket, "skipped") != 0;
+    if (!auditLog.append(record) && sdCard.isMounted()) {
+        Serial.println("(Audit)=> Write failed");
+    }
+}
 
-    if (uxQueueSpacesAvailable(dataQueue) == 0) {
-        Serial.println("Queue is full, cannot add new data");
+// ฟังก์ชันสำหรับการเพิ่มข้อมูลลงใน Queue (queue ยาวเท่า pool จึงไม่มีทางเต็มก่อน pool)
+void addDataToQueue(WeighRecord *record) {
+    if (xQueueSend(dataQueue, &record, 0) != pdTRUE) {
+        Serial.println("Failed to add data to queue");
+        recordPool.release(record);
         return;
     }
+    RecordPoolStats stats = recordPool.stats();
+    Serial.printf("(RecordPool)=> Queued, %u/%u in use (max %u)\n", stats.inUse, stats.capacity, stats.highWater);
+}
 
-    DataToSend *pItem = new DataToSend(dataToSend); // Make a copy of data in heap because the queue needs a pointer
-    if (xQueueSend(dataQueue, &pItem, portMAX_DELAY) != pdTRUE) {
-        Serial.println("Failed to add data to queue");
-        delete pItem;
-    } else {
-        Serial.println("Data added to queue successfully");
-        Serial.print("Number of items in queue: ");
-        Serial.println(uxQueueMessagesWaiting(dataQueue));
+// outbox ใช้ไม่ได้ (LittleFS mount/format ไม่ได้): ส่งจาก dataQueue ตรงๆ ไม่ผ่าน flash
+// record ที่ยังส่งไม่ออกค้างใน pool แล้วลองใหม่หลัง UPLOAD_RETRY_DELAY (รีเซ็ตแล้วหาย, pool เต็มผลชั่งใหม่ถูกทิ้ง)
+void processQueueDirect() {
+    static WeighRecord batch[UPLOAD_BATCH_SIZE];
+    WeighRecord *items[UPLOAD_BATCH_SIZE];
+    uint8_t count = 0;
+    while (1) {
+        TickType_t wait = count > 0 ? pdMS_TO_TICKS(UPLOAD_RETRY_DELAY) : portMAX_DELAY;
+        WeighRecord *item;
+        if (count == UPLOAD_BATCH_SIZE) {
+            vTaskDelay(wait);
+        } else if (xQueueReceive(dataQueue, &item, wait) == pdTRUE) {
+            do {
+                items[count++] = item;
+            } while (count < UPLOAD_BATCH_SIZE && xQueueReceive(dataQueue, &item, pdMS_TO_TICKS(UPLOAD_BATCH_WAIT)) == pdTRUE);
+        }
+        if (count == 0 || WiFi.status() != WL_CONNECTED) {
+            uploader.close();
+            continue;
+        }
+
+        for (uint8_t i = 0; i < count; i++) {
+            batch[i] = *items[i];
+        }
+        uploader.setServer(apiServer, authorizationToken);
+        uint8_t done;
+        int code = sendBatchToServer(batch, NULL, count, done);
+        for (uint8_t i = 0; i < done; i++) {
+            recordPool.release(items[i]);
+        }
+        count -= done;
+        memmove(items, items + done, count * sizeof(items[0]));
+        Serial.printf("(Upload)=> %d, %u records sent without outbox, %u waiting in pool\n", code, done, count);
     }
 }
 
+// ผลชั่งที่ค้างรอลง outbox ต้อง append ได้ครบใน buffer เดียว (append ไม่ commit เองกลางชุด ชุดที่ commit ไม่ผ่านจึง append ใหม่ได้ทั้งชุด)
+static_assert(UPLOAD_BATCH_SIZE * (sizeof(WeighRecord) + OUTBOX_FRAME_OVERHEAD) <= OUTBOX_COMMIT_SIZE, "upload batch must fit one outbox commit");
+
 // ฟังก์ชันสำหรับการเตรียมและส่งข้อมูล
+// 1) ย้ายผลชั่งจาก dataQueue ลง outbox ทุกรอบ (WiFi หลุดก็ยังเก็บ) รวมที่ชั่งตามมาภายใน UPLOAD_BATCH_WAIT แล้ว commit ครั้งเดียว
+//    คืน record ให้ pool เมื่อ commit สำเร็จเท่านั้น outbox เต็ม/เขียนไม่ได้ record ค้างใน pool (เต็มแล้วผลชั่งใหม่ถูกทิ้งเหมือน processQueueDirect)
+//    และขึ้นสถานะบนหน้าหลัก ลอง commit ใหม่ทุก UPLOAD_RETRY_DELAY หรือทันทีหลัง ack
+// 2) อ่าน record ที่ server ยังไม่ยืนยันจาก outbox ไม่เกิน UPLOAD_BATCH_SIZE ส่งใน request เดียว
+//    ack เฉพาะ record ที่ server ตอบแล้ว (รับหรือปฏิเสธ 4xx), ส่งไม่ออก/server error ลองใหม่จาก record นั้นหลัง UPLOAD_RETRY_DELAY
 void processQueueTask(void *parameter) {
     // รอการแจ้งเตือนจาก wifiConnectTask ก่อนจะเริ่มทำงาน
     ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
     Serial.println("Processing data in queue...");
+    if (!outbox.ready()) {
+        processQueueDirect();
+    }
 
+    static WeighRecord batch[UPLOAD_BATCH_SIZE];
+    static uint32_t seqs[UPLOAD_BATCH_SIZE];
+    WeighRecord *items[UPLOAD_BATCH_SIZE];
+    uint8_t held = 0; // ผลชั่งที่ยังลง outbox ไม่ได้ (ค้างใน pool)
+    bool stored = true;
+    uint32_t replayed = outbox.stats().pending; // record จากก่อนรีเซ็ต (created ใช้วัดเวลาไม่ได้)
+    TickType_t wait = 0;
+    uint8_t unacked = 0; // record ที่ server ตอบแล้วแต่บันทึก ack ไม่ได้
+    bool wifiDown = false;
     while (1) {
-        // Check WiFi status
-        while (WiFi.status() != WL_CONNECTED) {
-            Serial.println("WiFi disconnected, reconnecting...");
-            vTaskDelay(pdMS_TO_TICKS(1000)); // Delay when queue is blocked
+        WeighRecord *item;
+        if (held > 0) {
+            vTaskDelay(wait);
+        } else if (xQueueReceive(dataQueue, &item, wait) == pdTRUE) {
+            do {
+                items[held++] = item;
+            } while (held < UPLOAD_BATCH_SIZE && xQueueReceive(dataQueue, &item, pdMS_TO_TICKS(UPLOAD_BATCH_WAIT)) == pdTRUE);
+        }
+        if (held > 0) {
+            for (uint8_t i = 0; i < held; i++) {
+                outbox.append(items[i], sizeof(WeighRecord));
+            }
+            bool ok = outbox.commit();
+            if (ok) {
+                for (uint8_t i = 0; i < held; i++) {
+                    recordPool.release(items[i]);
+                }
+                held = 0;
+            }
+            if (ok != stored) {
+                stored = ok;
+                gui_post(UI_STORAGE_STATE, ok, 0, ok ? "" : outbox.full() ? "Outbox full" : "Storage error");
+            }
         }
 
-        DataToSend *item;
-        if (xQueueReceive(dataQueue, &item, portMAX_DELAY) == pdTRUE) {
-            Serial.println("\nProcessing data from the queue...");
-
-            bool sendSuccess = sendDataToServer(&item->jsonData);
+        // ยังส่งไม่ได้/ส่งไม่ผ่าน: รอผลชั่งใหม่ได้ไม่เกิน UPLOAD_RETRY_DELAY แล้วลองส่งอีกครั้ง
+        wait = pdMS_TO_TICKS(UPLOAD_RETRY_DELAY);
+        // ack ค้างต้องบันทึกได้ก่อน ไม่อย่างนั้น read() คืนชุดเดิมแล้วส่งซ้ำ
+        if (unacked > 0) {
+            if (!outbox.ack(unacked)) {
+                continue;
+            }
+            unacked = 0;
+        }
+        if (WiFi.status() != WL_CONNECTED) {
+            if (!wifiDown) {
+                Serial.println("WiFi disconnected, records kept in outbox");
+                wifiDown = true;
+            }
+            uploader.close();
+            continue;
+        }
+        wifiDown = false;
 
-            if (!sendSuccess) {
-                Serial.printf("Failed to send data to server");
-                vTaskDelay(pdMS_TO_TICKS(500)); // Delay when queue is blocked
-            } else {
-                Serial.println("Data sent successfully");
+        uint8_t count = outbox.read(batch, sizeof(WeighRecord), UPLOAD_BATCH_SIZE, seqs);
+        if (count == 0) {
+            if (held == 0) {
+                wait = portMAX_DELAY;
             }
+            continue;
+        }
+
+        uploader.setServer(apiServer, authorizationToken);
+        uint32_t start = millis();
+        uint8_t done;
+        int code = sendBatchToServer(batch, seqs, count, done);
+        uint32_t elapsed = millis() - start;
+
+        if (!outbox.ack(done)) {
+            Serial.printf("(Upload)=> Ack failed, not resending %u records until it is saved\n", done);
+            unacked = done;
+        }
+        if (code < 0 || code >= 500) {
+            Serial.printf("(Upload)=> Failed (%d) after %u records, %lu records kept in outbox\n", code, done, (unsigned long)outbox.stats().pending);
+            replayed -= min(replayed, (uint32_t)done);
+            continue;
+        }
+        if (unacked == 0) {
+            wait = 0;
+        }
+        if (code != HTTP_CODE_OK && code != HTTP_CODE_CREATED) {
+            Serial.printf("(Upload)=> Rejected (%d), %u records dropped\n", code, count);
+            replayed -= min(replayed, (uint32_t)count);
+            continue;
+        }
 
-            delete item;
+        // latency = ตั้งแต่ชั่งจน server ตอบ (รวมเวลารอในคิว/outbox)
+        uint32_t now = millis();
+        uint32_t oldest = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            if (replayed > 0) {
+                replayed--;
+                continue;
+            }
+            oldest = max(oldest, now - batch[i].created);
         }
 
-        Serial.println("Waiting for new data in the queue...");
-        vTaskDelay(pdMS_TO_TICKS(300));
+        const UploadStats &stats = uploader.stats();
+        Serial.printf("(Upload)=> %u records in %lu ms (%lu ms/record), oldest waited %lu ms | total %lu records, %lu requests, %lu connects, "
+                      "%.1f records/s, %lu left\n",
+                      count, (unsigned long)elapsed, (unsigned long)(elapsed / count), (unsigned long)oldest, (unsigned long)stats.records,
+                      (unsigned long)stats.requests, (unsigned long)stats.connects, stats.postMs ? stats.records * 1000.0 / stats.postMs : 0.0,
+                      (unsigned long)outbox.stats().pending);
     }
 }
 
-// สั่งปริ้นน้ำหนัก
-void printWeight(String weight) {
-    weight.replace("+", "");
-    weight.replace("-", "");
-    weight.replace("g", "");
-    weight.trim();
+// ค่า field ของใบเสร็จ (ตัวเลขจัดรูปแบบลง buffer ในตัว ไม่จอง memory)
+struct ReceiptData {
+    char weight[16];
+    char minWeight[16];
+    char maxWeight[16];
+    char pcs[12];
+    char target[12];
+    char record[96];
+    const char *values[RECEIPT_FIELD_COUNT];
+};
 
-    for (int i = 0; i < weight.length(); i++) {
-        if (!isDigit(weight[i]) && weight[i] != '.') {
-            return;
+void fillReceiptData(ReceiptData &data, const DateTimeInfo &dt, const char *result) {
+    data.weight[0] = '\0';
+    data.pcs[0] = '\0';
+    snprintf(data.minWeight, sizeof(data.minWeight), "%.2f", SET_MIN_WEIGHT);
+    snprintf(data.maxWeight, sizeof(data.maxWeight), "%.2f", SET_MAX_WEIGHT);
+    snprintf(data.target, sizeof(data.target), "%d", SET_PCS);
+
+    data.values[FIELD_DATE] = dt.date.c_str();
+    data.values[FIELD_TIME] = dt.time.c_str();
+    data.values[FIELD_WEIGHT] = data.weight;
+    data.values[FIELD_MIN] = data.minWeight;
+    data.values[FIELD_MAX] = data.maxWeight;
+    data.values[FIELD_PCS] = data.pcs;
+    data.values[FIELD_TARGET] = data.target;
+    data.values[FIELD_OP1] = operators.id1;
+    data.values[FIELD_OP2] = operators.id2[0] != '\0' ? operators.id2 : "-";
+    data.values[FIELD_RESULT] = result;
+    data.values[FIELD_MACHINE] = machineName.c_str();
+    data.values[FIELD_SERIAL] = chipid;
+    data.values[FIELD_RECORD] = data.record;
+}
+
+// ใบเสร็จเขียนลง buffer ของ spooler ทั้งใบแล้วส่ง submit() ทันที (task ของ spooler ส่งออกเครื่องพิมพ์เอง)
+// ถ้าคิวเต็มจะข้ามการพิมพ์ใบนี้ แต่ยังบันทึกผลและส่งข้อมูลตามปกติ
+// คืนค่าสถานะใบนี้สำหรับข้อมูลที่ส่ง server: queued, held (เครื่องพิมพ์หยุดรอ พิมพ์เมื่อพร้อม) หรือ skipped
+const char *printReceipt(int type, ReceiptData &data) {
+    // record ต่อจาก field อื่นที่ผู้เรียกเติมแล้ว (ลำดับเดียวกับข้อมูลที่ส่ง server)
+    snprintf(data.record, sizeof(data.record), "%s %s,%s,%s,%s%s,%s", data.values[FIELD_DATE], data.values[FIELD_TIME], chipid, operators.id1,
+             data.weight, data.pcs, data.values[FIELD_RESULT]);
+
+    PrintJob *job = spooler.acquire();
+    if (job == NULL) {
+        Serial.println("(Spooler)=> Queue full, receipt skipped");
+        return "skipped";
+    }
+    uint32_t start = micros();
+    RasterStats before = raster.stats();
+    receipts[type].render(*job, data.values, SET_PRINT_LOGO ? 1UL << FLAG_LOGO : 0, &raster);
+    uint32_t elapsed = micros() - start;
+
+    const RasterStats &after = raster.stats();
+    Serial.printf("(Receipt)=> %u bytes (raster %lu), built in %lu us (raster: %lu rendered in %lu us, %lu cached)\n", job->size(),
+                  (unsigned long)(after.bytesSent - before.bytesSent), (unsigned long)elapsed, (unsigned long)(after.misses - before.misses),
+                  (unsigned long)(after.renderUs - before.renderUs), (unsigned long)(after.hits - before.hits));
+    if (!spooler.submit(job)) {
+        return "skipped";
+    }
+    return spooler.getState() == SPOOLER_PAUSED ? "held" : "queued";
+}
+
+// สถานะเครื่องพิมพ์ตอนชั่ง (เฉพาะเมื่อมีการพิมพ์) เก็บใน record แต่ยังไม่ส่ง server จนกว่า mode_gram/mode_pcs จะมี column รับ
+void addPrinterStatus(WeighRecord &record, const char *ticket) {
+    if (ticket == NULL) {
+        return;
+    }
+    strlcpy(record.ticket, ticket, sizeof(record.ticket));
+    strlcpy(record.printerStatus, spooler.statusEnabled() ? PrintSpooler::statusText(spooler.printerStatus()) : "unknown",
+            sizeof(record.printerStatus));
+}
+
+// โลโก้จาก LittleFS (ไม่มีไฟล์ = ใช้โลโก้ในเครื่องพิมพ์ตามเดิม)
+void loadLogo() {
+    if (!LittleFS.begin(false)) {
+        Serial.println("(Raster)=> LittleFS not mounted, using printer logo");
+        return;
+    }
+    File file = LittleFS.open(LOGO_PATH, "r");
+    if (!file) {
+        Serial.printf("(Raster)=> %s not found, using printer logo\n", LOGO_PATH);
+        return;
+    }
+    raster.loadLogo(file, LOGO_MAX_BYTES);
+    file.close();
+}
+
+void printerStateChanged(SpoolerState state, uint8_t pending, const char *error) {
+    char text[48];
+    switch (state) {
+    case SPOOLER_QUEUED:
+        snprintf(text, sizeof(text), "Printer: %d queued", pending);
+        break;
+    case SPOOLER_PRINTING:
+        snprintf(text, sizeof(text), "Printer: printing (%d)", pending);
+        break;
+    case SPOOLER_ERROR:
+        snprintf(text, sizeof(text), "Printer: %s", error != NULL ? error : "error");
+        break;
+    case SPOOLER_PAUSED:
+        snprintf(text, sizeof(text), "Printer: %s (%d waiting)", error != NULL ? error : "paused", pending);
+        break;
+    default:
+        snprintf(text, sizeof(text), "Printer: ready");
+        break;
+    }
+    if (state != SPOOLER_PAUSED && (spooler.printerStatus() & PRINTER_PAPER_NEAR_END)) {
+        strncat(text, " - paper low", sizeof(text) - strlen(text) - 1);
+    }
+    gui_post(UI_PRINTER_STATE, false, state, text);
+}
+
+// ===== SPC หน้าชั่งกรัม =====
+// loop คำนวณหลังชั่งทุกครั้ง (SpcEngine) แล้วส่ง snapshot ผ่าน spcQueue + gui_post(UI_SPC) ให้ LVGL task วาด
+// กดช่องน้ำหนักเพื่อสลับไปดูกราฟ X-bar/R กับ Cp/Cpk กดที่กราฟเพื่อกลับ
+SpcEngine spc; // ใช้จาก loop เท่านั้น ช่วงน้ำหนักเปลี่ยน = สินค้าใหม่ เริ่มเก็บใหม่
+QueueHandle_t spcQueue = NULL;
+lv_obj_t *spcPanel = NULL;
+lv_obj_t *spcXbarChart = NULL;
+lv_obj_t *spcRangeChart = NULL;
+lv_obj_t *spcLabel = NULL;
+lv_chart_series_t *spcXbar = NULL;
+lv_chart_series_t *spcUcl = NULL;
+lv_chart_series_t *spcLcl = NULL;
+lv_chart_series_t *spcLsl = NULL;
+lv_chart_series_t *spcUsl = NULL;
+lv_chart_series_t *spcRange = NULL;
+lv_chart_series_t *spcRangeUcl = NULL;
+float spcScale = 100;       // ค่าบนกราฟเป็น lv_coord_t (16 bit): 0.01 g ถ้าช่วงน้ำหนักไม่เกิน 300 g
+lv_coord_t spcRangeTop = 0; // แกน y ของกราฟ R
+
+// ทำงานใน loop
+void updateSpc(float value) {
+    spc.setLimits(SET_MIN_WEIGHT, SET_MAX_WEIGHT);
+    const SpcSnapshot &snapshot = spc.add(value);
+    if (xQueueSend(spcQueue, &snapshot, 0) == pdTRUE) {
+        gui_post(UI_SPC);
+    } else {
+        Serial.println("(SPC)=> Queue full, chart skipped");
+    }
+}
+
+// ค่าที่เกินช่วงของ lv_coord_t ตัดไว้ที่ขอบ (LV_CHART_POINT_NONE = ไม่มีจุด)
+lv_coord_t spcPoint(float value) { return constrain(lroundf(value * spcScale), -32000L, 32000L); }
+
+// เส้นแนวนอน (วาดใหม่ทั้งกราฟ) เฉพาะเมื่อค่าที่แสดงเปลี่ยน
+void setSpcLine(lv_obj_t *chart, lv_chart_series_t *series, lv_coord_t value) {
+    if (series->y_points[0] != value) {
+        lv_chart_set_all_value(chart, series, value);
+    }
+}
+
+// สินค้าใหม่: ล้างกราฟ ตั้งแกน y ให้เห็นช่วงน้ำหนักพร้อมขอบข้างละ 25%
+void resetSpcCharts(const SpcSnapshot &snapshot) {
+    bool limits = snapshot.upper > snapshot.lower;
+    float margin = limits ? (snapshot.upper - snapshot.lower) / 4 : max(fabsf(snapshot.last) / 10, 1.0f);
+    float low = (limits ? snapshot.lower : snapshot.last) - margin;
+    float high = (limits ? snapshot.upper : snapshot.last) + margin;
+    float largest = max(fabsf(low), fabsf(high));
+    spcScale = largest < 300 ? 100 : largest < 3000 ? 10 : 1;
+    lv_chart_set_range(spcXbarChart, LV_CHART_AXIS_PRIMARY_Y, spcPoint(low), spcPoint(high));
+    spcRangeTop = max(spcPoint(margin * 2), (lv_coord_t)1);
+    lv_chart_set_range(spcRangeChart, LV_CHART_AXIS_PRIMARY_Y, 0, spcRangeTop);
+
+    lv_chart_series_t *series[] = {spcXbar, spcUcl, spcLcl, spcLsl, spcUsl};
+    for (lv_chart_series_t *s : series) {
+        lv_chart_set_all_value(spcXbarChart, s, LV_CHART_POINT_NONE);
+        lv_chart_set_x_start_point(spcXbarChart, s, 0);
+    }
+    lv_chart_set_all_value(spcRangeChart, spcRange, LV_CHART_POINT_NONE);
+    lv_chart_set_x_start_point(spcRangeChart, spcRange, 0);
+    lv_chart_set_all_value(spcRangeChart, spcRangeUcl, LV_CHART_POINT_NONE);
+    if (limits) {
+        lv_chart_set_all_value(spcXbarChart, spcLsl, spcPoint(snapshot.lower));
+        lv_chart_set_all_value(spcXbarChart, spcUsl, spcPoint(snapshot.upper));
+    }
+}
+
+void formatSpcIndex(char *text, size_t size, float value) {
+    if (isnan(value)) {
+        snprintf(text, size, "-");
+    } else {
+        snprintf(text, size, "%.2f", value);
+    }
+}
+
+// ทำงานใน LVGL task (จาก applyUiMessage) ชั่ง 1 ครั้งแก้แค่ข้อความ ครบ subgroup เพิ่มจุดละ 1 จุดต่อกราฟ
+void showSpc() {
+    SpcSnapshot snapshot;
+    while (xQueueReceive(spcQueue, &snapshot, 0) == pdTRUE) {
+        if (snapshot.reset) {
+            resetSpcCharts(snapshot);
+        }
+        if (snapshot.newSubgroup) {
+            lv_chart_set_next_value(spcXbarChart, spcXbar, spcPoint(snapshot.xbar));
+            lv_chart_set_next_value(spcRangeChart, spcRange, spcPoint(snapshot.range));
+            setSpcLine(spcXbarChart, spcUcl, spcPoint(snapshot.ucl));
+            setSpcLine(spcXbarChart, spcLcl, spcPoint(snapshot.lcl));
+            lv_coord_t top = max(spcPoint(snapshot.range), spcPoint(snapshot.rangeUcl));
+            if (top > spcRangeTop) {
+                spcRangeTop = top + top / 2;
+                lv_chart_set_range(spcRangeChart, LV_CHART_AXIS_PRIMARY_Y, 0, spcRangeTop);
+            }
+            setSpcLine(spcRangeChart, spcRangeUcl, spcPoint(snapshot.rangeUcl));
+        }
+
+        char cp[8], cpk[8], pp[8], ppk[8];
+        formatSpcIndex(cp, sizeof(cp), snapshot.cp);
+        formatSpcIndex(cpk, sizeof(cpk), snapshot.cpk);
+        formatSpcIndex(pp, sizeof(pp), snapshot.pp);
+        formatSpcIndex(ppk, sizeof(ppk), snapshot.ppk);
+        lv_label_set_text_fmt(spcLabel,
+                              "n %u  subgroups %u\nMean %.2f  SD %.3f\nX-bar %.2f  R %.2f\nUCL %.2f  LCL %.2f\nCp %s  Cpk %s\nPp %s  Ppk %s%s",
+                              snapshot.count, snapshot.subgroups, snapshot.mean, snapshot.stdDev, snapshot.center, snapshot.rangeMean,
+                              snapshot.ucl, snapshot.lcl, cp, cpk, pp, ppk, snapshot.outOfControl ? "\n#E50202 Out of control#" : "");
+
+        // สีตาม Cpk (ยังไม่ครบ subgroup แรก = เทา)
+        uint32_t color = COLOR_GRAY;
+        if (snapshot.cpk < SPC_CPK_MINIMUM) {
+            color = COLOR_RED;
+        } else if (snapshot.cpk < SPC_CPK_CAPABLE) {
+            color = COLOR_ORANGE;
+        } else if (snapshot.cpk >= SPC_CPK_CAPABLE) {
+            color = COLOR_GREEN;
         }
+        lv_obj_set_style_text_color(spcLabel, lv_color_hex(color), LV_PART_MAIN);
+    }
+}
+
+void toggleSpcPanel(lv_event_t *e) {
+    if (lv_obj_has_flag(spcPanel, LV_OBJ_FLAG_HIDDEN)) {
+        lv_obj_add_flag(ui_Panel3, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_clear_flag(spcPanel, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_add_flag(spcPanel, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_clear_flag(ui_Panel3, LV_OBJ_FLAG_HIDDEN);
     }
+}
+
+lv_obj_t *createSpcChart(lv_coord_t y, lv_coord_t height) {
+    lv_obj_t *chart = lv_chart_create(spcPanel);
+    lv_obj_set_size(chart, 500, height);
+    lv_obj_align(chart, LV_ALIGN_TOP_LEFT, 0, y);
+    lv_obj_set_style_pad_all(chart, 4, LV_PART_MAIN);
+    lv_obj_set_style_size(chart, 4, LV_PART_INDICATOR);
+    lv_chart_set_type(chart, LV_CHART_TYPE_LINE);
+    lv_chart_set_point_count(chart, SPC_SUBGROUPS);
+    lv_chart_set_update_mode(chart, LV_CHART_UPDATE_MODE_CIRCULAR); // จุดใหม่ทับจุดเก่าสุด วาดใหม่เฉพาะรอบจุดนั้น
+    lv_chart_set_div_line_count(chart, 0, 0);
+    lv_obj_clear_flag(chart, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_flag(chart, LV_OBJ_FLAG_EVENT_BUBBLE);
+    return chart;
+}
+
+// ที่เดียวกับช่องน้ำหนัก (ui_Panel3) ซ่อนไว้จนกว่าจะกด
+void createSpcPanel() {
+    spcQueue = xQueueCreate(SPC_QUEUE_SIZE, sizeof(SpcSnapshot));
+
+    spcPanel = lv_obj_create(ui_GramPanel);
+    lv_obj_set_size(spcPanel, 760, 196);
+    lv_obj_set_align(spcPanel, LV_ALIGN_CENTER);
+    lv_obj_set_y(spcPanel, -80);
+    lv_obj_set_style_radius(spcPanel, 10, LV_PART_MAIN);
+    lv_obj_set_style_pad_all(spcPanel, 8, LV_PART_MAIN);
+    lv_obj_clear_flag(spcPanel, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_flag(spcPanel, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_add_event_cb(spcPanel, toggleSpcPanel, LV_EVENT_CLICKED, NULL);
+
+    spcXbarChart = createSpcChart(0, 112);
+    spcLsl = lv_chart_add_series(spcXbarChart, lv_color_hex(COLOR_RED), LV_CHART_AXIS_PRIMARY_Y);
+    spcUsl = lv_chart_add_series(spcXbarChart, lv_color_hex(COLOR_RED), LV_CHART_AXIS_PRIMARY_Y);
+    spcLcl = lv_chart_add_series(spcXbarChart, lv_color_hex(COLOR_ORANGE), LV_CHART_AXIS_PRIMARY_Y);
+    spcUcl = lv_chart_add_series(spcXbarChart, lv_color_hex(COLOR_ORANGE), LV_CHART_AXIS_PRIMARY_Y);
+    spcXbar = lv_chart_add_series(spcXbarChart, lv_color_hex(COLOR_BLUE), LV_CHART_AXIS_PRIMARY_Y);
+
+    spcRangeChart = createSpcChart(118, 62);
+    spcRangeUcl = lv_chart_add_series(spcRangeChart, lv_color_hex(COLOR_ORANGE), LV_CHART_AXIS_PRIMARY_Y);
+    spcRange = lv_chart_add_series(spcRangeChart, lv_color_hex(COLOR_BLUE), LV_CHART_AXIS_PRIMARY_Y);
+
+    spcLabel = lv_label_create(spcPanel);
+    lv_obj_set_style_text_font(spcLabel, &lv_font_montserrat_16, LV_PART_MAIN);
+    lv_obj_set_style_text_color(spcLabel, lv_color_hex(COLOR_GRAY), LV_PART_MAIN);
+    lv_label_set_recolor(spcLabel, true);
+    lv_obj_align(spcLabel, LV_ALIGN_TOP_LEFT, 512, 0);
+    lv_obj_add_flag(spcLabel, LV_OBJ_FLAG_EVENT_BUBBLE);
+    lv_label_set_text(spcLabel, "No weighing yet");
+
+    // กดที่ใดในช่องน้ำหนักก็สลับได้ (ลูกของ ui_Panel3 ส่ง event ต่อให้ parent)
+    lv_obj_add_flag(ui_Panel3, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(ui_Panel3, toggleSpcPanel, LV_EVENT_CLICKED, NULL);
+    for (uint32_t i = 0; i < lv_obj_get_child_cnt(ui_Panel3); i++) {
+        lv_obj_add_flag(lv_obj_get_child(ui_Panel3, i), LV_OBJ_FLAG_EVENT_BUBBLE);
+    }
+}
 
-    float readFloat = weight.toFloat();
+// สั่งปริ้นน้ำหนัก (กรัม, ค่านิ่งแล้ว)
+void printWeight(float readFloat) {
     String _result = "FAIL";
+    const char *ticket = NULL;
     if (readFloat > 0) {
         DateTimeInfo dt = getDateTime();
-        lv_label_set_text_fmt(ui_CurrentWeight, "%.2f", readFloat);
         if (readFloat < SET_MIN_WEIGHT || readFloat > SET_MAX_WEIGHT) {
-            lv_obj_set_style_bg_color(ui_LedGramResult, lv_color_hex(COLOR_RED), LV_PART_MAIN);
-            lv_obj_set_style_text_color(ui_CurrentWeight, lv_color_hex(COLOR_RED), LV_PART_MAIN);
-            lv_label_set_text(ui_GramResult, "ไม่ผ่าน");
+            gui_post(UI_GRAM_RESULT, false, readFloat, NULL, serialInputTime);
             isAlert = true;
-            lv_refr_now(NULL); // อัพเดทหน้าจอทั้งหมดทันที
             COUNT_GRAM_NG++;
             _result = "FAIL";
         } else {
-            lv_obj_set_style_bg_color(ui_LedGramResult, lv_color_hex(COLOR_GREEN), LV_PART_MAIN);
-            lv_obj_set_style_text_color(ui_CurrentWeight, lv_color_hex(COLOR_GREEN), LV_PART_MAIN);
-            lv_label_set_text(ui_GramResult, "ผ่าน");
-            lv_refr_now(NULL); // อัพเดทหน้าจอทั้งหมดทันที
+            gui_post(UI_GRAM_RESULT, true, readFloat, NULL, serialInputTime);
             COUNT_GRAM_OK++;
             _result = "PASS";
 
-            pcf8574.digitalWrite(P0, LOW);
-            delay(200);
-            pcf8574.digitalWrite(P0, HIGH);
-
-            printer.reset();
-            if (lv_obj_has_state(ui_PrintLogo, LV_STATE_CHECKED)) {
-                printer.setAlign(ALIGN_CENTER);
-                printer.printLogo(); // พิมพ์โลโก้
-            }
+            beep();
 
-            printer.setAlign(ALIGN_LEFT);
-            String currentDate = dt.date;
-            String currentTime = dt.time;
-            printer.println("Date: " + currentDate);
-            printer.println("Time: " + currentTime);
-
-            printer.println("Weight Range: " + String(SET_MIN_WEIGHT, 2) + " - " + String(SET_MAX_WEIGHT, 2) + " g.");
-            printer.println("Weight:            " + String(readFloat, 2) + " g.");
-            printer.println("Operator id 1: " + EmployeeID1);
-            printer.println("Operator id 2: " + (EmployeeID2.length() > 0 ? EmployeeID2 : "-"));
-
-            printer.feed(1);
-            printer.setFontSize(LARGE);
-            printer.setBold(BOLD_ON);
-            printer.setAlign(ALIGN_CENTER);
-            printer.highlight(HIGHLIGHT_VERTICAL_HORIZONTALLY_EXPANDED);
-            printer.println("PASS");
-            printer.cut();
+            ReceiptData receipt;
+            fillReceiptData(receipt, dt, "PASS");
+            snprintf(receipt.weight, sizeof(receipt.weight), "%.2f", readFloat);
+            ticket = printReceipt(RECEIPT_GRAM, receipt);
         }
 
         updateCount(MODE_GRAM);
-
-        DataToSend item;
-        item.jsonData["timestamp"] = dt.datetime;
-        item.jsonData["serial_number"] = String(chipid);
-        item.jsonData["operator1"] = EmployeeID1.toInt();
-        item.jsonData["operator2"] = EmployeeID2.toInt();
-        item.jsonData["min_weight"] = SET_MIN_WEIGHT;
-        item.jsonData["max_weight"] = SET_MAX_WEIGHT;
-        item.jsonData["weight"] = readFloat;
-        item.jsonData["result"] = _result;
-
-        item.jsonData["mode"] = MODE_GRAM;
-
-        addDataToQueue(item);
-    }
-}
-
-// สั่งปริ้นจำนวน
-void printPcs(String pcs) {
-    pcs.replace("+", "");
-    pcs.replace("-", "");
-    pcs.replace("pcs", "");
-    pcs.trim();
-
-    for (int i = 0; i < pcs.length(); i++) {
-        if (!isDigit(pcs[i]) && pcs[i]) {
-            return;
+        auditWeighing(MODE_GRAM, dt, _result == "PASS", readFloat, SET_MIN_WEIGHT, SET_MAX_WEIGHT, ticket);
+        updateSpc(readFloat);
+
+        WeighRecord *record = newRecord(MODE_GRAM, dt, _result == "PASS");
+        if (record != NULL) {
+            record->minWeight = SET_MIN_WEIGHT;
+            record->maxWeight = SET_MAX_WEIGHT;
+            record->weight = readFloat;
+            addPrinterStatus(*record, ticket);
+            addDataToQueue(record);
         }
     }
+}
 
-    int readInt = pcs.toInt();
+// สั่งปริ้นจำนวน (ค่านิ่งแล้ว)
+void printPcs(int readInt) {
     String _result = "FAIL";
+    const char *ticket = NULL;
 
     if (readInt > 0) {
         DateTimeInfo dt = getDateTime();
-        lv_label_set_text_fmt(ui_CurrentPcs, "%d", readInt);
         if (readInt != SET_PCS) {
-            lv_obj_set_style_bg_color(ui_LedPcsResult, lv_color_hex(COLOR_RED), LV_PART_MAIN);
-            lv_obj_set_style_text_color(ui_CurrentPcs, lv_color_hex(COLOR_RED), LV_PART_MAIN);
-            lv_label_set_text(ui_PcsResult, "ไม่ผ่าน");
+            gui_post(UI_PCS_RESULT, false, readInt, NULL, serialInputTime);
             isAlert = true;
-            lv_refr_now(NULL); // อัพเดทหน้าจอทั้งหมดทันที
 
             COUNT_PCS_NG++;
             _result = "FAIL";
         } else {
-            lv_obj_set_style_bg_color(ui_LedPcsResult, lv_color_hex(COLOR_GREEN), LV_PART_MAIN);
-            lv_obj_set_style_text_color(ui_CurrentPcs, lv_color_hex(COLOR_GREEN), LV_PART_MAIN);
-            lv_label_set_text(ui_PcsResult, "ผ่าน");
-            lv_refr_now(NULL); // อัพเดทหน้าจอทั้งหมดทันที
+            gui_post(UI_PCS_RESULT, true, readInt, NULL, serialInputTime);
 
             COUNT_PCS_OK++;
             _result = "PASS";
 
-            pcf8574.digitalWrite(P0, LOW);
-            delay(200);
-            pcf8574.digitalWrite(P0, HIGH);
+            beep();
 
             if (SET_PRINT_PCS) {
-                printer.reset();
-
-                printer.setAlign(ALIGN_LEFT);
-                String currentDate = dt.date;
-                String currentTime = dt.time;
-                printer.println("Date:" + currentDate + " Time:" + currentTime);
-                printer.println("Oper: " + EmployeeID1 + ", Count: " + String(readInt) + " PCS");
-                printer.cut();
+                ReceiptData receipt;
+                fillReceiptData(receipt, dt, "PASS");
+                snprintf(receipt.pcs, sizeof(receipt.pcs), "%d", readInt);
+                ticket = printReceipt(RECEIPT_PCS, receipt);
             }
         }
 
         updateCount(MODE_PCS);
-
-        DataToSend item;
-        item.jsonData["timestamp"] = dt.datetime;
-        item.jsonData["serial_number"] = String(chipid);
-        item.jsonData["operator1"] = EmployeeID1.toInt();
-        item.jsonData["operator2"] = EmployeeID2.toInt();
-        item.jsonData["primary_pcs"] = SET_PCS;
-        item.jsonData["pcs"] = readInt;
-        item.jsonData["result"] = _result;
-
-        item.jsonData["mode"] = MODE_PCS;
-
-        addDataToQueue(item);
+        auditWeighing(MODE_PCS, dt, _result == "PASS", readInt, SET_PCS, SET_PCS, ticket);
+
+        WeighRecord *record = newRecord(MODE_PCS, dt, _result == "PASS");
+        if (record != NULL) {
+            record->target = SET_PCS;
+            record->pcs = readInt;
+            addPrinterStatus(*record, ticket);
+            addDataToQueue(record);
+        }
     }
 }
 
 // รีเซ็ตการตั้งค่า
 void factoryReset() {
     Serial.println("Factory reset....");
-    preferences.begin(NAME_SPACE, false);
+    preferencesBegin(false);
     preferences.clear(); // ลบข้อมูลทั้งหมดใน namespace "myApp"
-    preferences.end();
+    preferencesEnd();
 
     delay(500);
-    preferences.begin(NAME_SPACE, false);
+    preferencesBegin(false);
     preferences.putBool(MEM_SET_PRINT_LOGO, false);
     preferences.putInt(MEM_SET_MODE, 0);
     preferences.putBool(MEM_SET_PRINT_LOGO, false);
@@ -705,6 +1188,13 @@ void factoryReset() {
     preferences.putFloat(MEM_SET_MIN_WEIGHT, 0);
     preferences.putFloat(MEM_SET_MAX_WEIGHT, 0);
     preferences.putInt(MEM_SET_PCS, 0);
+    preferences.putInt(MEM_SET_BALANCE_PROTOCOL, BALANCE_GENERIC);
+    preferences.putBool(MEM_SET_AUTO_CAPTURE, false);
+    preferences.putInt(MEM_SET_STABLE_SAMPLES, DEFAULT_STABLE_SAMPLES);
+    preferences.putFloat(MEM_SET_STABLE_STDDEV, DEFAULT_STABLE_STDDEV);
+    preferences.putFloat(MEM_SET_ZERO_BAND, DEFAULT_ZERO_BAND);
+    preferences.putUInt(MEM_SCALE_BAUD, DEFAULT_SCALE_BAUD);
+    preferences.putUInt(MEM_PRINTER_BAUD, DEFAULT_PRINTER_BAUD);
 
     preferences.putULong(MEM_COUNT_GRAM_OK, 0);
     preferences.putULong(MEM_COUNT_GRAM_NG, 0);
@@ -715,7 +1205,7 @@ void factoryReset() {
     preferences.putString(MEM_WIFI_PASSWORD, DEFAULT_WIFI_PASSWORD);
     preferences.putString(MEM_SERVER_URL, DEFAULT_SERVER_URL);
     preferences.putString(MEM_NTP_SERVER, DEFAULT_NTP_SERVER);
-    preferences.end();
+    preferencesEnd();
     delay(500);
 }
 
@@ -727,7 +1217,7 @@ void confirmFactoryReset(lv_event_t *e) {
 // โหลดข้อมูลการตั้งค่า
 void loadConfiguration() {
     // เปิด Namespace "polipharm" ในโหมดอ่าน-เขียน
-    preferences.begin(NAME_SPACE, true);
+    preferencesBegin(true);
     IS_FIRST_RUN = preferences.getBool(MEM_FIRST_RUN, false);
     if (IS_FIRST_RUN) {
         factoryReset();
@@ -739,6 +1229,16 @@ void loadConfiguration() {
     bool GET_PRINT_LOGO = preferences.getBool(MEM_SET_PRINT_LOGO, false);
     bool GET_PRINT_PCS = preferences.getBool(MEM_SET_PRINT_PCS, false);
     unsigned int GET_PCS = preferences.getInt(MEM_SET_PCS, 0);
+    int GET_BALANCE_PROTOCOL = preferences.getInt(MEM_SET_BALANCE_PROTOCOL, BALANCE_GENERIC);
+    SET_AUTO_CAPTURE = preferences.getBool(MEM_SET_AUTO_CAPTURE, false);
+    SET_STABLE_SAMPLES = constrain(preferences.getInt(MEM_SET_STABLE_SAMPLES, DEFAULT_STABLE_SAMPLES), 2, STABILITY_WINDOW_MAX);
+    SET_STABLE_STDDEV = preferences.getFloat(MEM_SET_STABLE_STDDEV, DEFAULT_STABLE_STDDEV);
+    SET_ZERO_BAND = preferences.getFloat(MEM_SET_ZERO_BAND, DEFAULT_ZERO_BAND);
+    SET_SCALE_BAUD = preferences.getUInt(MEM_SCALE_BAUD, DEFAULT_SCALE_BAUD);
+    SET_PRINTER_BAUD = preferences.getUInt(MEM_PRINTER_BAUD, DEFAULT_PRINTER_BAUD);
+    for (int i = 0; i < RECEIPT_COUNT; i++) {
+        receiptSources[i] = preferences.getString(RECEIPT_KEYS[i], RECEIPT_DEFAULTS[i]);
+    }
 
     COUNT_GRAM_OK = preferences.getULong(MEM_COUNT_GRAM_OK, 0);
     COUNT_GRAM_NG = preferences.getULong(MEM_COUNT_GRAM_NG, 0);
@@ -751,6 +1251,7 @@ void loadConfiguration() {
     SET_PRINT_LOGO = GET_PRINT_LOGO;
     SET_PRINT_PCS = GET_PRINT_PCS;
     SET_PCS = GET_PCS < 0 ? 0 : GET_PCS;
+    SET_BALANCE_PROTOCOL = GET_BALANCE_PROTOCOL < 0 || GET_BALANCE_PROTOCOL >= BALANCE_PROTOCOL_COUNT ? BALANCE_GENERIC : GET_BALANCE_PROTOCOL;
 
     Serial.println("Read EEPROM settings:");
     Serial.printf("IS_FIRST_RUN: %d\n", IS_FIRST_RUN);
@@ -760,6 +1261,18 @@ void loadConfiguration() {
     Serial.printf("SET_PRINT_LOGO: %d\n", SET_PRINT_LOGO);
     Serial.printf("SET_PRINT_PCS: %d\n", SET_PRINT_PCS);
     Serial.printf("SET_PCS: %d\n", SET_PCS);
+    Serial.printf("SET_BALANCE_PROTOCOL: %s\n", BalanceProtocol::get(SET_BALANCE_PROTOCOL).name());
+    Serial.printf("SET_AUTO_CAPTURE: %d (samples: %d, std dev: %.3f, zero: %.2f)\n", SET_AUTO_CAPTURE, SET_STABLE_SAMPLES, SET_STABLE_STDDEV,
+                  SET_ZERO_BAND);
+    Serial.printf("SCALE_BAUD: %u, PRINTER_BAUD: %u\n", SET_SCALE_BAUD, SET_PRINTER_BAUD);
+    for (int i = 0; i < RECEIPT_COUNT; i++) {
+        if (!receipts[i].compile(receiptSources[i].c_str(), RECEIPT_FIELDS, RECEIPT_FIELD_COUNT, RECEIPT_FLAGS, RECEIPT_FLAG_COUNT)) {
+            // template ที่เก็บไว้เสีย ใช้ค่าเริ่มต้นแทน (ไม่ลบของเดิม ให้แก้ไขต่อได้)
+            Serial.printf("RECEIPT %s: %s, use default\n", RECEIPT_KEYS[i], receipts[i].error());
+            receipts[i].compile(RECEIPT_DEFAULTS[i], RECEIPT_FIELDS, RECEIPT_FIELD_COUNT, RECEIPT_FLAGS, RECEIPT_FLAG_COUNT);
+        }
+        Serial.printf("RECEIPT %s: %u bytes\n", RECEIPT_KEYS[i], receipts[i].size());
+    }
     Serial.printf("COUNT_GRAM_OK: %u\n", COUNT_GRAM_OK);
     Serial.printf("COUNT_GRAM_NG: %u\n", COUNT_GRAM_NG);
     Serial.printf("COUNT_PCS_OK: %u\n", COUNT_PCS_OK);
@@ -771,7 +1284,7 @@ void loadConfiguration() {
     passwordString = preferences.getString(MEM_WIFI_PASSWORD, DEFAULT_WIFI_PASSWORD);
     apiServer = preferences.getString(MEM_SERVER_URL, DEFAULT_SERVER_URL);
     ntpUDPServerString = preferences.getString(MEM_NTP_SERVER, DEFAULT_NTP_SERVER);
-    preferences.end();
+    preferencesEnd();
 
     Serial.println("SSID: " + ssidString);
     Serial.println("PASS: " + passwordString);
@@ -833,42 +1346,10 @@ void loadConfiguration() {
     lv_obj_center(qr);
 }
 
-// อ่านข้อมูลจาก Serial
-String readSerial(HardwareSerial &serial) {
-    String readString;
-    static char receivedData[50]; // Increased buffer size
-    static int dataIndex = 0;
-
-    while (serial.available() > 0) {
-        char incomingByte = serial.read();
-
-        if (incomingByte != '\n') {
-            if (dataIndex < sizeof(receivedData) - 1) {
-                receivedData[dataIndex++] = incomingByte;
-            } else {
-                Serial.println("Buffer overflow!");
-                dataIndex = 0;
-                memset(receivedData, 0, sizeof(receivedData));
-                continue;
-            }
-
-            delay(10);
-        }
-    }
-
-    receivedData[dataIndex] = '\0';
-    readString = receivedData;
-    dataIndex = 0;
-    memset(receivedData, 0, sizeof(receivedData));
-
-    Serial.printf("\n(Received data) => %s\n", readString);
-    return readString;
-}
-
 static lv_obj_t *CURRENT_LABEL = NULL;
 static void settings(lv_event_t *e) {
     _ui_flag_modify(ui_PNKEYBOARD, LV_OBJ_FLAG_HIDDEN, _UI_MODIFY_FLAG_REMOVE);
-    lv_keyboard_mode_t mode = (int)lv_event_get_user_data(e);
+    lv_keyboard_mode_t mode = (int)(intptr_t)lv_event_get_user_data(e);
     lv_keyboard_set_mode(ui_Keyboard, mode);
 
     lv_obj_t *target = lv_event_get_target(e);
@@ -881,28 +1362,28 @@ static void settings(lv_event_t *e) {
 }
 
 void setPrinLogo(lv_event_t *e) {
-    preferences.begin(NAME_SPACE, false);
+    preferencesBegin(false);
     SET_PRINT_LOGO = lv_obj_has_state(ui_PrintLogo, LV_STATE_CHECKED);
     Serial.printf("SET_PRINT_LOGO: %s\n", SET_PRINT_LOGO ? "ON" : "OFF");
     Serial.printf("================================\n");
     preferences.putBool(MEM_SET_PRINT_LOGO, SET_PRINT_LOGO);
-    preferences.end();
+    preferencesEnd();
 }
 
 void setPrinPcs(lv_event_t *e) {
-    preferences.begin(NAME_SPACE, false);
+    preferencesBegin(false);
     SET_PRINT_PCS = lv_obj_has_state(ui_PrintPcs, LV_STATE_CHECKED);
     Serial.printf("SET_PRINT_PCS: %s\n", SET_PRINT_PCS ? "ON" : "OFF");
     Serial.printf("================================\n");
     preferences.putBool(MEM_SET_PRINT_PCS, SET_PRINT_PCS);
-    preferences.end();
+    preferencesEnd();
 }
 
 void saveSettings(lv_event_t *e) {
     _ui_flag_modify(ui_PNKEYBOARD, LV_OBJ_FLAG_HIDDEN, _UI_MODIFY_FLAG_ADD);
     const char *value = lv_textarea_get_text(ui_input);
     if (CURRENT_LABEL != NULL) {
-        preferences.begin(NAME_SPACE, false);
+        preferencesBegin(false);
 
         if (SET_MODE == MODE_GRAM) {
             lv_label_set_text_fmt(CURRENT_LABEL, "%.2f", String(value).toFloat());
@@ -922,7 +1403,7 @@ void saveSettings(lv_event_t *e) {
             lv_label_set_text_fmt(CURRENT_LABEL, "%s", value);
         }
 
-        preferences.end();
+        preferencesEnd();
 
         lv_textarea_set_text(ui_input, "");
         Serial.printf("================================\n");
@@ -930,14 +1411,14 @@ void saveSettings(lv_event_t *e) {
 }
 
 void saveWiFiSetting(lv_event_t *e) {
-    preferences.begin(NAME_SPACE, false);
+    preferencesBegin(false);
 
     preferences.putString(MEM_WIFI_SSID, lv_label_get_text(ui_WiFiSSID));
     preferences.putString(MEM_WIFI_PASSWORD, lv_label_get_text(ui_WiFiPassWord));
     preferences.putString(MEM_SERVER_URL, lv_label_get_text(ui_WiFiServerIP));
     preferences.putString(MEM_NTP_SERVER, lv_label_get_text(ui_WiFiNtpServer));
 
-    preferences.end();
+    preferencesEnd();
 
     Serial.printf("================================\n");
     ESP.restart();
@@ -964,7 +1445,7 @@ void loginKeyboard(lv_event_t *e) {
     lv_obj_t *label = lv_obj_get_child(target, 0);
     CURRENT_LOGIN_LABEL = label;
 
-    int labelID = (int)lv_event_get_user_data(e);
+    int labelID = (int)(intptr_t)lv_event_get_user_data(e);
     LOGIN_LABEL_ID = labelID;
 }
 
@@ -984,13 +1465,21 @@ void setEmployeeID(lv_event_t *e) {
     }
 }
 
-bool isLogin = false;
+// ทำงานใน LVGL task
+void postOperators(bool loggedIn) {
+    OperatorInfo info = {};
+    info.loggedIn = loggedIn;
+    strlcpy(info.id1, EmployeeID1.c_str(), sizeof(info.id1));
+    strlcpy(info.id2, EmployeeID2.c_str(), sizeof(info.id2));
+    xQueueOverwrite(operatorQueue, &info);
+}
+
 void login(lv_event_t *e) {
     if (EmployeeID1 != "") {
         _ui_screen_change(&ui_MainPage, LV_SCR_LOAD_ANIM_NONE, 0, 0, &ui_MainPage_screen_init);
         lv_label_set_text(ui_EmployeeID1, EmployeeID1.c_str());
         lv_label_set_text(ui_EmployeeID2, (EmployeeID2.length() > 0 ? EmployeeID2 : "-").c_str());
-        isLogin = true;
+        postOperators(true);
 
         SET_MODE = lv_obj_has_state(ui_Mode, LV_STATE_CHECKED);
         setCurrentPage();
@@ -1007,7 +1496,7 @@ void logout(lv_event_t *e) {
     lv_label_set_text(ui_EmployeeID2, "");
     EmployeeID2 = "";
 
-    isLogin = false;
+    postOperators(false);
 
     // รีเซ็ตหน้าหลัก
     lv_label_set_text(ui_CurrentWeight, "000.00");
@@ -1021,80 +1510,112 @@ void logout(lv_event_t *e) {
     lv_obj_set_style_bg_color(ui_LedPcsResult, lv_color_hex(0x0C5107), LV_PART_MAIN);
 }
 
-void balanceTest(String weight) {
-    weight.replace("+", "");
-    weight.replace("-", "");
-    weight.replace("g", "");
-    weight.replace("pcs", "");
-    weight.trim();
+// ทดสอบเครื่องชั่ง: แสดงค่าที่อ่านได้ทุกค่า ค่าที่ยังไม่นิ่งต่อท้ายด้วย "~"
+void balanceTest(const BalanceReading &reading) {
+    if (reading.overload) {
+        gui_post(UI_BALANCE_TEST, false, 0, "OVERLOAD");
+        isAlert = true;
+        return;
+    }
+
+    char text[32];
+    snprintf(text, sizeof(text), "%.2f %s%s", reading.value, BalanceProtocol::unitName(reading.unit), reading.stable ? "" : " ~");
+    gui_post(UI_BALANCE_TEST, true, 0, text);
+    if (reading.stable) {
+        beep();
+    }
+}
 
-    for (int i = 0; i < weight.length(); i++) {
-        if (!isDigit(weight[i]) && weight[i] != '.') {
-            lv_obj_set_style_text_color(ui_TestBalanceValue, lv_color_hex(COLOR_RED), LV_PART_MAIN);
-            lv_label_set_text(ui_TestBalanceValue, "ERROR");
+// แปลงข้อมูลเครื่องชั่งตาม protocol ที่ตั้งไว้ แล้วส่งต่อตามโหมด (ตัดสินและพิมพ์เฉพาะค่าที่นิ่งแล้ว)
+void handleScaleFrame(const ScaleFrame &frame) {
+    BalanceReading reading;
+    if (!BalanceProtocol::get(SET_BALANCE_PROTOCOL).parse(frame.data, frame.length, reading)) {
+        Serial.printf("(Balance)=> Unknown data for %s\n", BalanceProtocol::get(SET_BALANCE_PROTOCOL).name());
+        if (SET_MODE == MODE_SETTING) {
+            gui_post(UI_BALANCE_TEST, false, 0, "ERROR");
             isAlert = true;
+        }
+        return;
+    }
+
+    if (SET_MODE == MODE_SETTING) {
+        balanceTest(reading);
+        return;
+    }
+    if (reading.overload) {
+        return;
+    }
+
+    static int lastMode = -1;
+    if (stabilityChanged || lastMode != SET_MODE) {
+        stabilityChanged = false;
+        lastMode = SET_MODE;
+        stability.begin({(uint8_t)SET_STABLE_SAMPLES, SET_STABLE_STDDEV, SET_ZERO_BAND});
+    }
+
+    bool gram = SET_MODE == MODE_GRAM && reading.unit != UNIT_PCS && reading.unit != UNIT_OTHER;
+    bool pcs = SET_MODE == MODE_PCS && (reading.unit == UNIT_PCS || reading.unit == UNIT_NONE);
+    if (!gram && !pcs) {
+        return;
+    }
+    float value = gram ? BalanceProtocol::toGram(reading) : reading.value;
+
+    if (SET_AUTO_CAPTURE) {
+        // เครื่องชั่งส่งค่าต่อเนื่อง: จับค่าเองเมื่อของชิ้นใหม่นิ่ง 1 ครั้งต่อการวาง
+        StabilityEvent event = stability.add(value);
+        if (event == STABILITY_REARMED) {
+            Serial.println("(Balance)=> Pan empty, ready for next item");
+        }
+        if (event != STABILITY_CAPTURED) {
             return;
         }
+        value = stability.capturedValue();
+        Serial.printf("(Balance)=> Captured %.3f (std dev %.3f)\n", value, stability.lastStdDev());
+    } else if (!reading.stable) {
+        return;
     }
 
-    lv_obj_set_style_text_color(ui_TestBalanceValue, lv_color_hex(COLOR_GREEN), LV_PART_MAIN);
-    lv_label_set_text(ui_TestBalanceValue, weight.c_str());
-    pcf8574.digitalWrite(P0, LOW);
-    delay(200);
-    pcf8574.digitalWrite(P0, HIGH);
+    if (gram) {
+        printWeight(value);
+    } else {
+        printPcs(lroundf(value));
+    }
 }
 
-void printTest() {
-    pcf8574.digitalWrite(P0, LOW);
-    delay(200);
-    pcf8574.digitalWrite(P0, HIGH);
+// งานพิมพ์ทดสอบที่รอ loop() ทำ (event ของ LVGL ห้ามบล็อกด้วยการพิมพ์) ส่งข้อความเป็นสำเนาผ่าน printTestQueue
+struct PrintTestRequest {
+    char text[16]; // ขนาดเท่า ReceiptData::weight
+};
+QueueHandle_t printTestQueue = NULL;
 
-    printer.setFontSize(LARGE);
-    printer.setBold(BOLD_ON);
-    printer.setAlign(ALIGN_CENTER);
-    printer.highlight(HIGHLIGHT_VERTICAL_HORIZONTALLY_EXPANDED);
-    printer.println("PRINT TEST");
-    printer.feed(2);
+void printTest(const PrintTestRequest &request) {
+    beep();
 
-    DateTimeInfo dt = getDateTime();
-    printer.setFontSize(NOMAL);
-    printer.setBold(BOLD_OFF);
-    printer.setAlign(ALIGN_LEFT);
-    printer.highlight(HIGHLIGHT_OFF);
-    String currentDate = dt.date;
-    String currentTime = dt.time;
-    printer.println("Date: " + currentDate);
-    printer.println("Time: " + currentTime);
-
-    String testPrinterInput = String(lv_label_get_text(ui_TestPrinterInput));
-    Serial.println("Test Printer Input: " + testPrinterInput);
+    Serial.printf("Test Printer Input: %s\n", request.text);
     Serial.println("--------------------------------");
-    printer.println("Weight Range: " + String(SET_MIN_WEIGHT, 2) + " - " + String(SET_MAX_WEIGHT, 2) + " g.");
-    printer.println("Weight:            " + String(testPrinterInput) + " g.");
-    printer.println("Operator id 1: " + EmployeeID1);
-    printer.println("Operator id 2: " + (EmployeeID2.length() > 0 ? EmployeeID2 : "-"));
 
-    printer.feed(1);
-    printer.setFontSize(LARGE);
-    printer.setBold(BOLD_ON);
-    printer.setAlign(ALIGN_CENTER);
-    printer.highlight(HIGHLIGHT_VERTICAL_HORIZONTALLY_EXPANDED);
-    printer.println("PASS");
-    printer.cut();
+    DateTimeInfo dt = getDateTime();
+    ReceiptData receipt;
+    fillReceiptData(receipt, dt, "PASS");
+    strlcpy(receipt.weight, request.text, sizeof(receipt.weight));
+    printReceipt(RECEIPT_TEST, receipt);
 }
 
 void testing(lv_event_t *e) {
-    TestType testType = static_cast<TestType>(reinterpret_cast<int>(lv_event_get_user_data(e)));
+    TestType testType = static_cast<TestType>((int)(intptr_t)lv_event_get_user_data(e));
 
     switch (testType) {
     case TEST_ALARM:
         isAlert = true;
         Serial.println("Testing Alarm...");
         break;
-    case PRINT_TEST:
+    case PRINT_TEST: {
         Serial.println("Testing Print...");
-        printTest();
+        PrintTestRequest request;
+        strlcpy(request.text, lv_label_get_text(ui_TestPrinterInput), sizeof(request.text));
+        xQueueOverwrite(printTestQueue, &request);
         break;
+    }
     default:
         Serial.println("Unknown test type!");
         break;
@@ -1146,6 +1667,588 @@ void addEventListener() {
     lv_obj_add_event_cb(ui_ConfirmFactoryReset, confirmFactoryReset, LV_EVENT_CLICKED, NULL);
 }
 
+// แท็บใหม่ในหน้าตั้งค่า (ต่อท้ายแท็บที่สร้างจาก SquareLine)
+lv_obj_t *createSettingsTab(const char *title) {
+    lv_obj_t *tab = lv_tabview_add_tab(ui_TabSettings, title);
+    lv_obj_set_style_text_font(tab, &ui_font_sukhumvit25, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_color(tab, lv_color_hex(0x696969), LV_PART_MAIN | LV_STATE_DEFAULT);
+    return tab;
+}
+
+// ===== หน่วยความจำ =====
+lv_obj_t *memoryLabel = NULL;
+
+// อ่านสถานะ pool ของ LVGL (PSRAM) และ heap หลัก (internal RAM) ทำงานใน LVGL task
+void updateMemoryMonitor(lv_timer_t *timer) {
+    static unsigned long lastLogTime = 0;
+
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+
+    size_t heapFree = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    size_t heapMinFree = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    size_t heapBiggest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    int heapFrag = heapFree ? 100 - (int)(heapBiggest * 100 / heapFree) : 0;
+    RecordPoolStats pool = recordPool.stats();
+    OutboxStats box = outbox.stats();
+    AuditStats audit = auditLog.stats();
+
+    lv_label_set_text_fmt(memoryLabel,
+                          "LVGL (PSRAM)\n"
+                          "  used: %u / %u KB (%d%%), max used: %u KB\n"
+                          "  free: %u KB, biggest free: %u KB, frag: %d%%\n"
+                          "Heap (internal)\n"
+                          "  free: %u KB, min free: %u KB\n"
+                          "  biggest free: %u KB, frag: %d%%\n"
+                          "Upload queue (PSRAM pool)\n"
+                          "  in use: %u / %u, max: %u, total: %lu, dropped: %lu\n"
+                          "Outbox (LittleFS)\n"
+                          "  waiting: %lu, commits: %lu, written: %lu KB, dropped: %lu\n"
+                          "Audit log (SD)\n"
+                          "  %s, next no.: %lu, written: %lu, dropped: %lu\n"
+                          "Uptime: %lu min",
+                          (mon.total_size - mon.free_size) / 1024, mon.total_size / 1024, mon.used_pct, mon.max_used / 1024,
+                          mon.free_size / 1024, mon.free_biggest_size / 1024, mon.frag_pct, heapFree / 1024, heapMinFree / 1024,
+                          heapBiggest / 1024, heapFrag, pool.inUse, pool.capacity, pool.highWater, (unsigned long)pool.acquired,
+                          (unsigned long)pool.dropped, (unsigned long)box.pending, (unsigned long)box.commits,
+                          (unsigned long)(box.bytesWritten / 1024), (unsigned long)box.dropped, audit.ready ? "ready" : "no card",
+                          (unsigned long)audit.sequence, (unsigned long)audit.appended, (unsigned long)audit.dropped, millis() / 60000);
+
+    if (millis() - lastLogTime >= MEMORY_LOG_INTERVAL || lastLogTime == 0) {
+        Serial.printf("(Memory)=> LVGL used: %u/%u, biggest free: %u, frag: %d%% | heap free: %u, min free: %u, biggest free: %u, frag: %d%%"
+                      " | pool: %u/%u, max %u, dropped %lu | outbox: %lu waiting, %lu dropped\n",
+                      mon.total_size - mon.free_size, mon.total_size, mon.free_biggest_size, mon.frag_pct, heapFree, heapMinFree,
+                      heapBiggest, heapFrag, pool.inUse, pool.capacity, pool.highWater, (unsigned long)pool.dropped,
+                      (unsigned long)box.pending, (unsigned long)box.dropped);
+        lastLogTime = millis();
+    }
+}
+
+void createMemoryTab() {
+    lv_obj_t *tab = createSettingsTab("หน่วยความจำ");
+    memoryLabel = lv_label_create(tab);
+    lv_obj_set_width(memoryLabel, 700);
+    lv_obj_set_align(memoryLabel, LV_ALIGN_TOP_LEFT);
+
+    lv_timer_t *timer = lv_timer_create(updateMemoryMonitor, MEMORY_MONITOR_INTERVAL, NULL);
+    updateMemoryMonitor(timer);
+}
+
+// ===== ประวัติการชั่ง (audit log บน SD) =====
+// LVGL task ส่งคำขอผ่าน auditRequestQueue ให้ loop อ่าน SD แล้วส่งผลกลับทาง auditPageQueue + gui_post(UI_AUDIT)
+enum AuditAction { AUDIT_DAYS, AUDIT_PAGE, AUDIT_FIND, AUDIT_EXPORT };
+
+struct AuditRequest {
+    uint8_t action;
+    uint32_t day;   // YYYYMMDD
+    uint32_t first; // AUDIT_PAGE: record แรกของหน้า
+    uint32_t time;  // AUDIT_FIND: หน้าที่มี record แรกตั้งแต่เวลานี้
+};
+
+struct AuditPage {
+    uint8_t action;
+    uint32_t day;
+    uint32_t first;
+    uint32_t total; // record ทั้งวัน
+    uint8_t count;
+    uint32_t elapsedUs;
+    AuditRecord records[AUDIT_PAGE_SIZE];
+    char text[AUDIT_DAY_OPTIONS * 11]; // AUDIT_DAYS: ตัวเลือกของ dropdown (YYYY-MM-DD), นอกนั้น: ข้อความสถานะ
+};
+
+QueueHandle_t auditRequestQueue = NULL;
+QueueHandle_t auditPageQueue = NULL;
+lv_obj_t *auditDaySelect = NULL;
+lv_obj_t *auditHourSelect = NULL;
+lv_obj_t *auditStatus = NULL;
+lv_obj_t *auditTable = NULL;
+uint16_t auditTabIndex = 0;
+uint32_t auditFirst = 0; // หน้าที่แสดงอยู่ (ใช้ใน LVGL task)
+uint32_t auditTotal = 0;
+
+// ทำงานใน loop
+void handleAuditRequest(const AuditRequest &request) {
+    static AuditPage page; // ~1 KB ไม่วางบน stack ของ loop
+    memset(&page, 0, sizeof(page));
+    page.action = request.action;
+    page.day = request.day;
+    uint32_t start = micros();
+
+    if (!auditLog.stats().ready) {
+        snprintf(page.text, sizeof(page.text), "No SD card");
+    } else if (request.action == AUDIT_DAYS) {
+        uint32_t days[AUDIT_DAY_OPTIONS];
+        uint16_t count = auditLog.days(days, AUDIT_DAY_OPTIONS);
+        size_t length = 0;
+        for (uint16_t i = 0; i < count; i++) {
+            length += snprintf(page.text + length, sizeof(page.text) - length, "%s%04lu-%02lu-%02lu", i > 0 ? "\n" : "",
+                               (unsigned long)(days[i] / 10000), (unsigned long)(days[i] / 100 % 100), (unsigned long)(days[i] % 100));
+        }
+        page.day = count > 0 ? days[0] : 0;
+    } else if (request.action == AUDIT_EXPORT) {
+        char path[32];
+        snprintf(path, sizeof(path), AUDIT_DIR "/%08lu.csv", (unsigned long)request.day);
+        if (auditLog.exportCsv(request.day, path)) {
+            snprintf(page.text, sizeof(page.text), "Exported %s (%lu ms)", path, (unsigned long)(micros() - start) / 1000);
+        } else {
+            snprintf(page.text, sizeof(page.text), "Export %s failed", path);
+        }
+    } else {
+        page.total = auditLog.count(request.day);
+        page.first = request.action == AUDIT_FIND ? auditLog.find(request.day, request.time) : request.first;
+        // หน้าที่มี record นั้น (เลยเวลาสุดท้ายของวัน = หน้าสุดท้าย)
+        page.first = min(page.first, page.total > 0 ? page.total - 1 : 0) / AUDIT_PAGE_SIZE * AUDIT_PAGE_SIZE;
+        page.count = auditLog.read(request.day, page.first, page.records, AUDIT_PAGE_SIZE);
+    }
+    page.elapsedUs = micros() - start;
+
+    if (xQueueSend(auditPageQueue, &page, 0) == pdTRUE) {
+        gui_post(UI_AUDIT);
+    }
+}
+
+bool sendAuditRequest(uint8_t action, uint32_t day, uint32_t first = 0, uint32_t time = 0) {
+    AuditRequest request = {action, day, first, time};
+    if (xQueueSend(auditRequestQueue, &request, 0) != pdTRUE) {
+        lv_label_set_text(auditStatus, "Busy, try again");
+        return false;
+    }
+    return true;
+}
+
+// "YYYY-MM-DD" ที่เลือกใน dropdown -> YYYYMMDD (0 = ยังไม่มีวัน)
+uint32_t selectedAuditDay() {
+    char text[12];
+    lv_dropdown_get_selected_str(auditDaySelect, text, sizeof(text));
+    int year, month, day;
+    return sscanf(text, "%d-%d-%d", &year, &month, &day) == 3 ? year * 10000 + month * 100 + day : 0;
+}
+
+void auditTabChanged(lv_event_t *e) {
+    if (lv_tabview_get_tab_act(ui_TabSettings) == auditTabIndex) {
+        sendAuditRequest(AUDIT_DAYS, 0);
+    }
+}
+
+void auditDayChanged(lv_event_t *e) {
+    lv_dropdown_set_selected(auditHourSelect, 0);
+    sendAuditRequest(AUDIT_PAGE, selectedAuditDay());
+}
+
+void auditHourChanged(lv_event_t *e) {
+    uint32_t day = selectedAuditDay();
+    sendAuditRequest(AUDIT_FIND, day, 0, AuditLog::timeOf(day) + lv_dropdown_get_selected(auditHourSelect) * 3600);
+}
+
+void auditPageClicked(lv_event_t *e) {
+    int direction = (int)(intptr_t)lv_event_get_user_data(e);
+    if (direction < 0 && auditFirst > 0) {
+        sendAuditRequest(AUDIT_PAGE, selectedAuditDay(), auditFirst - min(auditFirst, (uint32_t)AUDIT_PAGE_SIZE));
+    } else if (direction > 0 && auditFirst + AUDIT_PAGE_SIZE < auditTotal) {
+        sendAuditRequest(AUDIT_PAGE, selectedAuditDay(), auditFirst + AUDIT_PAGE_SIZE);
+    }
+}
+
+void auditExportClicked(lv_event_t *e) {
+    uint32_t day = selectedAuditDay();
+    if (day != 0 && sendAuditRequest(AUDIT_EXPORT, day)) {
+        lv_label_set_text(auditStatus, "Exporting...");
+    }
+}
+
+// ทำงานใน LVGL task (จาก applyUiMessage)
+void showAuditPage() {
+    static AuditPage page;
+    while (xQueueReceive(auditPageQueue, &page, 0) == pdTRUE) {
+        if (page.action == AUDIT_DAYS && page.day != 0) {
+            lv_dropdown_set_options(auditDaySelect, page.text);
+            lv_dropdown_set_selected(auditHourSelect, 0);
+            sendAuditRequest(AUDIT_PAGE, page.day);
+            continue;
+        }
+        if (page.action == AUDIT_DAYS || page.action == AUDIT_EXPORT || page.text[0] != '\0') {
+            lv_label_set_text(auditStatus, page.action == AUDIT_DAYS && page.text[0] == '\0' ? "No records" : page.text);
+            continue;
+        }
+
+        auditFirst = page.first;
+        auditTotal = page.total;
+        uint32_t pages = max((page.total + AUDIT_PAGE_SIZE - 1) / AUDIT_PAGE_SIZE, (uint32_t)1);
+        lv_label_set_text_fmt(auditStatus, "%lu records, page %lu / %lu (%lu.%lu ms)", (unsigned long)page.total,
+                              (unsigned long)(page.first / AUDIT_PAGE_SIZE + 1), (unsigned long)pages, (unsigned long)(page.elapsedUs / 1000),
+                              (unsigned long)(page.elapsedUs / 100 % 10));
+        for (uint8_t row = 0; row < AUDIT_PAGE_SIZE; row++) {
+            const AuditRecord &record = page.records[row];
+            if (row >= page.count) {
+                for (uint8_t col = 0; col < 6; col++) {
+                    lv_table_set_cell_value(auditTable, row + 1, col, "");
+                }
+                continue;
+            }
+            // เศษจากไฟดับ (ดู AuditLog::append) ไม่ใช่ผลชั่ง แสดงเป็นแถวเสียแทนลำดับ 0 ปี 1970
+            if (record.magic != AUDIT_MAGIC) {
+                lv_table_set_cell_value(auditTable, row + 1, 0, "-");
+                lv_table_set_cell_value(auditTable, row + 1, 1, "damaged");
+                for (uint8_t col = 2; col < 6; col++) {
+                    lv_table_set_cell_value(auditTable, row + 1, col, "");
+                }
+                continue;
+            }
+            char time[20];
+            AuditLog::formatTime(record.time, time, sizeof(time));
+            lv_table_set_cell_value_fmt(auditTable, row + 1, 0, "%lu", (unsigned long)record.sequence);
+            lv_table_set_cell_value(auditTable, row + 1, 1, time + 11);
+            if (record.mode == MODE_GRAM) {
+                lv_table_set_cell_value_fmt(auditTable, row + 1, 2, "%.2f g", record.value);
+                lv_table_set_cell_value_fmt(auditTable, row + 1, 3, "%.2f - %.2f", record.low, record.high);
+            } else {
+                lv_table_set_cell_value_fmt(auditTable, row + 1, 2, "%.0f pcs", record.value);
+                lv_table_set_cell_value_fmt(auditTable, row + 1, 3, "%.0f", record.low);
+            }
+            lv_table_set_cell_value(auditTable, row + 1, 4, record.pass ? "OK" : "NG");
+            lv_table_set_cell_value_fmt(auditTable, row + 1, 5, "%ld", (long)record.operator1);
+        }
+    }
+}
+
+void createAuditTab() {
+    auditRequestQueue = xQueueCreate(1, sizeof(AuditRequest));
+    auditPageQueue = xQueueCreate(2, sizeof(AuditPage));
+
+    lv_obj_t *tab = createSettingsTab("ประวัติ");
+    auditTabIndex = lv_obj_get_index(tab);
+    lv_obj_add_event_cb(ui_TabSettings, auditTabChanged, LV_EVENT_VALUE_CHANGED, NULL);
+
+    auditDaySelect = lv_dropdown_create(tab);
+    lv_dropdown_set_options(auditDaySelect, "");
+    lv_obj_set_width(auditDaySelect, 220);
+    lv_obj_align(auditDaySelect, LV_ALIGN_TOP_LEFT, 0, -8);
+    lv_obj_add_event_cb(auditDaySelect, auditDayChanged, LV_EVENT_VALUE_CHANGED, NULL);
+
+    // ข้ามไปชั่วโมงที่เลือก (ค้นด้วย index ของวันนั้น)
+    auditHourSelect = lv_dropdown_create(tab);
+    lv_dropdown_set_options_static(auditHourSelect, AUDIT_HOUR_OPTIONS);
+    lv_obj_set_width(auditHourSelect, 140);
+    lv_obj_align(auditHourSelect, LV_ALIGN_TOP_LEFT, 240, -8);
+    lv_obj_add_event_cb(auditHourSelect, auditHourChanged, LV_EVENT_VALUE_CHANGED, NULL);
+
+    createTabButton(tab, "<", 400, -8, auditPageClicked, (void *)-1);
+    createTabButton(tab, ">", 470, -8, auditPageClicked, (void *)1);
+    createTabButton(tab, "CSV", 540, -8, auditExportClicked, NULL);
+
+    auditStatus = lv_label_create(tab);
+    lv_obj_set_style_text_font(auditStatus, &lv_font_montserrat_16, LV_PART_MAIN);
+    lv_obj_align(auditStatus, LV_ALIGN_TOP_LEFT, 0, 45);
+    lv_label_set_text(auditStatus, "");
+
+    static const char *HEADERS[] = {"No.", "Time", "Value", "Limits", "Result", "Operator"};
+    static const lv_coord_t WIDTHS[] = {110, 110, 140, 170, 80, 110};
+    auditTable = lv_table_create(tab);
+    lv_obj_set_style_text_font(auditTable, &lv_font_montserrat_16, LV_PART_ITEMS);
+    lv_obj_set_style_pad_ver(auditTable, 4, LV_PART_ITEMS);
+    lv_obj_align(auditTable, LV_ALIGN_TOP_LEFT, 0, 70);
+    lv_table_set_row_cnt(auditTable, AUDIT_PAGE_SIZE + 1);
+    lv_table_set_col_cnt(auditTable, 6);
+    for (uint8_t col = 0; col < 6; col++) {
+        lv_table_set_col_width(auditTable, col, WIDTHS[col]);
+        lv_table_set_cell_value(auditTable, 0, col, HEADERS[col]);
+    }
+}
+
+// ===== เครื่องชั่ง =====
+void setBalanceProtocol(lv_event_t *e) {
+    lv_obj_t *dropdown = lv_event_get_target(e);
+    SET_BALANCE_PROTOCOL = lv_dropdown_get_selected(dropdown);
+
+    preferencesBegin(false);
+    preferences.putInt(MEM_SET_BALANCE_PROTOCOL, SET_BALANCE_PROTOCOL);
+    preferencesEnd();
+    Serial.printf("SET_BALANCE_PROTOCOL: %s\n", BalanceProtocol::get(SET_BALANCE_PROTOCOL).name());
+    Serial.printf("================================\n");
+}
+
+// dropdown เลือก baud rate (ตัวเลือกตาม BAUD_OPTIONS)
+lv_obj_t *createBaudDropdown(lv_obj_t *parent, uint32_t baud, lv_event_cb_t callback) {
+    lv_obj_t *dropdown = lv_dropdown_create(parent);
+    lv_dropdown_set_options_static(dropdown, BAUD_OPTIONS);
+    char text[12];
+    snprintf(text, sizeof(text), "%u", baud);
+    int index = lv_dropdown_get_option_index(dropdown, text);
+    lv_dropdown_set_selected(dropdown, index < 0 ? 0 : index);
+    lv_obj_set_width(dropdown, 180);
+    lv_obj_add_event_cb(dropdown, callback, LV_EVENT_VALUE_CHANGED, NULL);
+    return dropdown;
+}
+
+uint32_t getSelectedBaud(lv_event_t *e) {
+    char text[12];
+    lv_dropdown_get_selected_str(lv_event_get_target(e), text, sizeof(text));
+    return strtoul(text, NULL, 10);
+}
+
+void setScaleBaud(lv_event_t *e) {
+    SET_SCALE_BAUD = getSelectedBaud(e);
+    SCALE_SERIAL.updateBaudRate(SET_SCALE_BAUD);
+
+    preferencesBegin(false);
+    preferences.putUInt(MEM_SCALE_BAUD, SET_SCALE_BAUD);
+    preferencesEnd();
+    Serial.printf("SCALE_BAUD: %u\n", SET_SCALE_BAUD);
+    Serial.printf("================================\n");
+}
+
+void setPrinterBaud(lv_event_t *e) {
+    SET_PRINTER_BAUD = getSelectedBaud(e);
+    PRINTER_SERIAL.updateBaudRate(SET_PRINTER_BAUD);
+
+    preferencesBegin(false);
+    preferences.putUInt(MEM_PRINTER_BAUD, SET_PRINTER_BAUD);
+    preferencesEnd();
+    Serial.printf("PRINTER_BAUD: %u\n", SET_PRINTER_BAUD);
+    Serial.printf("================================\n");
+}
+
+// ค่าที่แสดงข้าง slider (slider เก็บเป็นจำนวนเต็ม)
+lv_obj_t *stabilityLabels[STABILITY_SETTING_COUNT];
+
+void updateStabilityLabel(int setting) {
+    switch (setting) {
+    case STABLE_SAMPLES:
+        lv_label_set_text_fmt(stabilityLabels[setting], "%d ค่า", SET_STABLE_SAMPLES);
+        break;
+    case STABLE_STDDEV:
+        lv_label_set_text_fmt(stabilityLabels[setting], "%.2f", SET_STABLE_STDDEV);
+        break;
+    case ZERO_BAND:
+        lv_label_set_text_fmt(stabilityLabels[setting], "%.1f", SET_ZERO_BAND);
+        break;
+    }
+}
+
+void setAutoCapture(lv_event_t *e) {
+    SET_AUTO_CAPTURE = lv_obj_has_state(lv_event_get_target(e), LV_STATE_CHECKED);
+    stabilityChanged = true;
+
+    preferencesBegin(false);
+    preferences.putBool(MEM_SET_AUTO_CAPTURE, SET_AUTO_CAPTURE);
+    preferencesEnd();
+    Serial.printf("SET_AUTO_CAPTURE: %s\n", SET_AUTO_CAPTURE ? "ON" : "OFF");
+    Serial.printf("================================\n");
+}
+
+void setStability(lv_event_t *e) {
+    int setting = (int)(intptr_t)lv_event_get_user_data(e);
+    int32_t value = lv_slider_get_value(lv_event_get_target(e));
+    switch (setting) {
+    case STABLE_SAMPLES:
+        SET_STABLE_SAMPLES = value;
+        break;
+    case STABLE_STDDEV:
+        SET_STABLE_STDDEV = value / 100.0;
+        break;
+    case ZERO_BAND:
+        SET_ZERO_BAND = value / 10.0;
+        break;
+    }
+    updateStabilityLabel(setting);
+
+    if (lv_event_get_code(e) == LV_EVENT_RELEASED) {
+        stabilityChanged = true;
+        preferencesBegin(false);
+        preferences.putInt(MEM_SET_STABLE_SAMPLES, SET_STABLE_SAMPLES);
+        preferences.putFloat(MEM_SET_STABLE_STDDEV, SET_STABLE_STDDEV);
+        preferences.putFloat(MEM_SET_ZERO_BAND, SET_ZERO_BAND);
+        preferencesEnd();
+        Serial.printf("SET_STABILITY: samples: %d, std dev: %.3f, zero: %.2f\n", SET_STABLE_SAMPLES, SET_STABLE_STDDEV, SET_ZERO_BAND);
+        Serial.printf("================================\n");
+    }
+}
+
+void createStabilitySlider(lv_obj_t *tab, int setting, const char *title, int32_t min, int32_t max, int32_t value) {
+    lv_coord_t y = 140 + setting * 60;
+    lv_obj_t *label = lv_label_create(tab);
+    lv_label_set_text(label, title);
+    lv_obj_set_align(label, LV_ALIGN_TOP_LEFT);
+    lv_obj_set_y(label, y);
+
+    lv_obj_t *slider = lv_slider_create(tab);
+    lv_slider_set_range(slider, min, max);
+    lv_slider_set_value(slider, value, LV_ANIM_OFF);
+    lv_obj_set_width(slider, 300);
+    lv_obj_align(slider, LV_ALIGN_TOP_LEFT, 230, y + 12);
+    lv_obj_add_event_cb(slider, setStability, LV_EVENT_VALUE_CHANGED, (void *)(intptr_t)setting);
+    lv_obj_add_event_cb(slider, setStability, LV_EVENT_RELEASED, (void *)(intptr_t)setting);
+
+    stabilityLabels[setting] = lv_label_create(tab);
+    lv_obj_align(stabilityLabels[setting], LV_ALIGN_TOP_LEFT, 570, y);
+    updateStabilityLabel(setting);
+}
+
+void createBalanceTab() {
+    lv_obj_t *tab = createSettingsTab("เครื่องชั่ง");
+
+    lv_obj_t *label = lv_label_create(tab);
+    lv_label_set_text(label, "รูปแบบข้อมูล");
+    lv_obj_set_align(label, LV_ALIGN_TOP_LEFT);
+
+    lv_obj_t *dropdown = lv_dropdown_create(tab);
+    lv_dropdown_set_options_static(dropdown, BalanceProtocol::options());
+    lv_dropdown_set_selected(dropdown, SET_BALANCE_PROTOCOL);
+    lv_obj_set_width(dropdown, 300);
+    lv_obj_align(dropdown, LV_ALIGN_TOP_LEFT, 220, -8);
+    lv_obj_add_event_cb(dropdown, setBalanceProtocol, LV_EVENT_VALUE_CHANGED, NULL);
+
+    lv_obj_t *baud = createBaudDropdown(tab, SET_SCALE_BAUD, setScaleBaud);
+    lv_obj_align(baud, LV_ALIGN_TOP_LEFT, 540, -8);
+
+    // ชั่งอัตโนมัติ: ไม่ต้องกด PRINT ที่เครื่องชั่ง (ต้องตั้งเครื่องชั่งให้ส่งค่าต่อเนื่อง)
+    lv_obj_t *autoLabel = lv_label_create(tab);
+    lv_label_set_text(autoLabel, "ชั่งอัตโนมัติ");
+    lv_obj_align(autoLabel, LV_ALIGN_TOP_LEFT, 0, 70);
+
+    lv_obj_t *autoSwitch = lv_switch_create(tab);
+    lv_obj_align(autoSwitch, LV_ALIGN_TOP_LEFT, 230, 70);
+    if (SET_AUTO_CAPTURE) {
+        lv_obj_add_state(autoSwitch, LV_STATE_CHECKED);
+    }
+    lv_obj_add_event_cb(autoSwitch, setAutoCapture, LV_EVENT_VALUE_CHANGED, NULL);
+
+    createStabilitySlider(tab, STABLE_SAMPLES, "จำนวนค่าที่นิ่ง", 2, STABILITY_WINDOW_MAX, SET_STABLE_SAMPLES);
+    createStabilitySlider(tab, STABLE_STDDEV, "ค่าแกว่งสูงสุด", 1, 100, lroundf(SET_STABLE_STDDEV * 100));
+    createStabilitySlider(tab, ZERO_BAND, "ช่วงศูนย์", 1, 100, lroundf(SET_ZERO_BAND * 10));
+}
+
+// ===== เครื่องพิมพ์ =====
+lv_obj_t *receiptSelect = NULL;
+lv_obj_t *receiptEditor = NULL;
+lv_obj_t *receiptStatus = NULL;
+lv_obj_t *receiptKeyboard = NULL;
+
+void showReceiptSource(lv_event_t *e) {
+    int type = lv_dropdown_get_selected(receiptSelect);
+    lv_textarea_set_text(receiptEditor, receiptSources[type].c_str());
+    lv_label_set_text(receiptStatus, "");
+}
+
+// compile ใน LVGL task เพื่อแจ้ง error ทันที แล้วส่งตัวที่ compile แล้วให้ loop ใช้แทนของเดิม
+void saveReceipt(lv_event_t *e) {
+    static ReceiptUpdate update; // ~1 KB ไม่วางบน stack ของ LVGL task
+    bool restoreDefault = (bool)(intptr_t)lv_event_get_user_data(e);
+    update.type = lv_dropdown_get_selected(receiptSelect);
+    if (restoreDefault) {
+        lv_textarea_set_text(receiptEditor, RECEIPT_DEFAULTS[update.type]);
+    }
+    const char *source = lv_textarea_get_text(receiptEditor);
+
+    if (!update.compiled.compile(source, RECEIPT_FIELDS, RECEIPT_FIELD_COUNT, RECEIPT_FLAGS, RECEIPT_FLAG_COUNT)) {
+        lv_obj_set_style_text_color(receiptStatus, lv_color_hex(COLOR_RED), LV_PART_MAIN);
+        lv_label_set_text(receiptStatus, update.compiled.error());
+        return;
+    }
+    if (xQueueSend(receiptUpdateQueue, &update, pdMS_TO_TICKS(100)) != pdTRUE) {
+        lv_obj_set_style_text_color(receiptStatus, lv_color_hex(COLOR_RED), LV_PART_MAIN);
+        lv_label_set_text(receiptStatus, "Busy, try again");
+        return;
+    }
+
+    receiptSources[update.type] = source;
+    preferencesBegin(false);
+    preferences.putString(RECEIPT_KEYS[update.type], source);
+    preferencesEnd();
+
+    lv_obj_set_style_text_color(receiptStatus, lv_color_hex(COLOR_GREEN), LV_PART_MAIN);
+    lv_label_set_text_fmt(receiptStatus, "Saved (%u bytes)", update.compiled.size());
+    Serial.printf("RECEIPT %s: saved, %u bytes\n", RECEIPT_KEYS[update.type], update.compiled.size());
+    Serial.printf("================================\n");
+}
+
+void receiptKeyboardEvent(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code == LV_EVENT_FOCUSED) {
+        lv_keyboard_set_textarea(receiptKeyboard, receiptEditor);
+        lv_obj_clear_flag(receiptKeyboard, LV_OBJ_FLAG_HIDDEN);
+    } else if (code == LV_EVENT_READY || code == LV_EVENT_CANCEL || code == LV_EVENT_DEFOCUSED) {
+        lv_obj_add_flag(receiptKeyboard, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_clear_state(receiptEditor, LV_STATE_FOCUSED);
+    }
+}
+
+lv_obj_t *createTabButton(lv_obj_t *tab, const char *text, lv_coord_t x, lv_coord_t y, lv_event_cb_t callback, void *userData) {
+    lv_obj_t *button = lv_btn_create(tab);
+    lv_obj_align(button, LV_ALIGN_TOP_LEFT, x, y);
+    lv_obj_add_event_cb(button, callback, LV_EVENT_CLICKED, userData);
+    lv_obj_t *label = lv_label_create(button);
+    lv_label_set_text(label, text);
+    lv_obj_center(label);
+    return button;
+}
+
+void createPrinterTab() {
+    lv_obj_t *tab = createSettingsTab("เครื่องพิมพ์");
+
+    lv_obj_t *label = lv_label_create(tab);
+    lv_label_set_text(label, "Baud rate");
+    lv_obj_set_align(label, LV_ALIGN_TOP_LEFT);
+
+    lv_obj_t *baud = createBaudDropdown(tab, SET_PRINTER_BAUD, setPrinterBaud);
+    lv_obj_align(baud, LV_ALIGN_TOP_LEFT, 220, -8);
+
+    // แก้ไขรูปแบบใบเสร็จ (ดูคำสั่งใน lib/ReceiptTemplate/ReceiptTemplate.h)
+    label = lv_label_create(tab);
+    lv_label_set_text(label, "ใบเสร็จ");
+    lv_obj_align(label, LV_ALIGN_TOP_LEFT, 0, 70);
+
+    receiptSelect = lv_dropdown_create(tab);
+    lv_dropdown_set_options_static(receiptSelect, "Weight\nPcs\nTest");
+    lv_obj_set_width(receiptSelect, 180);
+    lv_obj_align(receiptSelect, LV_ALIGN_TOP_LEFT, 220, 62);
+    lv_obj_add_event_cb(receiptSelect, showReceiptSource, LV_EVENT_VALUE_CHANGED, NULL);
+
+    createTabButton(tab, "Save", 420, 62, saveReceipt, (void *)false);
+    createTabButton(tab, "Default", 520, 62, saveReceipt, (void *)true);
+
+    receiptStatus = lv_label_create(tab);
+    lv_obj_set_style_text_font(receiptStatus, &lv_font_montserrat_16, LV_PART_MAIN);
+    lv_obj_align(receiptStatus, LV_ALIGN_TOP_LEFT, 0, 120);
+    lv_label_set_text(receiptStatus, "");
+
+    receiptEditor = lv_textarea_create(tab);
+    lv_obj_set_style_text_font(receiptEditor, &lv_font_montserrat_16, LV_PART_MAIN);
+    lv_obj_set_size(receiptEditor, 720, 260);
+    lv_obj_align(receiptEditor, LV_ALIGN_TOP_LEFT, 0, 150);
+    lv_textarea_set_max_length(receiptEditor, 2000);
+    lv_obj_add_event_cb(receiptEditor, receiptKeyboardEvent, LV_EVENT_ALL, NULL);
+
+    receiptKeyboard = lv_keyboard_create(lv_layer_top());
+    lv_obj_set_size(receiptKeyboard, LV_PCT(100), LV_PCT(45));
+    lv_obj_add_flag(receiptKeyboard, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_add_event_cb(receiptKeyboard, receiptKeyboardEvent, LV_EVENT_ALL, NULL);
+
+    showReceiptSource(NULL);
+}
+
+// สถานะเครื่องพิมพ์ มุมล่างขวาของหน้าหลัก
+lv_obj_t *printerStateLabel = NULL;
+
+void createPrinterStateLabel() {
+    printerStateLabel = lv_label_create(ui_MainPage);
+    lv_obj_set_style_text_font(printerStateLabel, &lv_font_montserrat_16, LV_PART_MAIN);
+    lv_obj_set_style_text_color(printerStateLabel, lv_color_hex(COLOR_GRAY), LV_PART_MAIN);
+    lv_obj_align(printerStateLabel, LV_ALIGN_BOTTOM_RIGHT, -10, -4);
+    lv_label_set_text(printerStateLabel, "Printer: ready");
+}
+
+// outbox เต็ม/เขียน flash ไม่ได้ มุมล่างซ้ายของหน้าหลัก (ซ่อนเมื่อปกติ)
+lv_obj_t *storageStateLabel = NULL;
+
+void createStorageStateLabel() {
+    storageStateLabel = lv_label_create(ui_MainPage);
+    lv_obj_set_style_text_font(storageStateLabel, &lv_font_montserrat_16, LV_PART_MAIN);
+    lv_obj_set_style_text_color(storageStateLabel, lv_color_hex(COLOR_RED), LV_PART_MAIN);
+    lv_obj_align(storageStateLabel, LV_ALIGN_BOTTOM_LEFT, 10, -4);
+    lv_obj_add_flag(storageStateLabel, LV_OBJ_FLAG_HIDDEN);
+}
+
 void copyright() {
     lv_label_set_text(ui_Copyright1, COPYRIGHT);
     lv_label_set_text(ui_Copyright2, COPYRIGHT);
@@ -1156,26 +2259,125 @@ void copyright() {
     lv_label_set_text(ui_Copyright7, COPYRIGHT);
 }
 
+// อัพเดทหน้าจอตามข้อความจาก task อื่น (ทำงานใน LVGL task)
+void applyUiMessage(const UiMessage &msg) {
+    switch (msg.type) {
+    case UI_LOADING_TEXT:
+        lv_label_set_text(ui_LoadingLabel, msg.text);
+        break;
+
+    case UI_SHOW_DETAILS:
+        _ui_screen_change(&ui_DetailsPage, LV_SCR_LOAD_ANIM_FADE_ON, 500, 0, &ui_DetailsPage_screen_init);
+        break;
+
+    case UI_DATE:
+        lv_label_set_text(ui_Date, msg.text);
+        break;
+
+    case UI_TIME:
+        lv_label_set_text(ui_Time, msg.text);
+        break;
+
+    case UI_GRAM_RESULT: {
+        lv_color_t color = lv_color_hex(msg.flag ? COLOR_GREEN : COLOR_RED);
+        lv_label_set_text_fmt(ui_CurrentWeight, "%.2f", msg.value);
+        lv_obj_set_style_bg_color(ui_LedGramResult, color, LV_PART_MAIN);
+        lv_obj_set_style_text_color(ui_CurrentWeight, color, LV_PART_MAIN);
+        lv_label_set_text(ui_GramResult, msg.flag ? "ผ่าน" : "ไม่ผ่าน");
+        gui_refresh_soon(); // setter ด้านบน invalidate เฉพาะ widget ผลลัพธ์ ให้วาดในเฟรมถัดไปทันที
+        break;
+    }
+
+    case UI_PCS_RESULT: {
+        lv_color_t color = lv_color_hex(msg.flag ? COLOR_GREEN : COLOR_RED);
+        lv_label_set_text_fmt(ui_CurrentPcs, "%d", (int)msg.value);
+        lv_obj_set_style_bg_color(ui_LedPcsResult, color, LV_PART_MAIN);
+        lv_obj_set_style_text_color(ui_CurrentPcs, color, LV_PART_MAIN);
+        lv_label_set_text(ui_PcsResult, msg.flag ? "ผ่าน" : "ไม่ผ่าน");
+        gui_refresh_soon();
+        break;
+    }
+
+    case UI_COUNT:
+        if ((int)msg.value == MODE_GRAM) {
+            lv_label_set_text_fmt(ui_OkGramCount, "%05u", COUNT_GRAM_OK);
+            lv_label_set_text_fmt(ui_NgGramCount, "%05u", COUNT_GRAM_NG);
+        } else if ((int)msg.value == MODE_PCS) {
+            lv_label_set_text_fmt(ui_OkPcsCount, "%05u", COUNT_PCS_OK);
+            lv_label_set_text_fmt(ui_NgPcsCount, "%05u", COUNT_PCS_NG);
+        }
+        break;
+
+    case UI_PRINTER_STATE: {
+        static const uint32_t colors[] = {COLOR_GRAY, COLOR_ORANGE, COLOR_ORANGE, COLOR_RED, COLOR_RED};
+        lv_label_set_text(printerStateLabel, msg.text);
+        lv_obj_set_style_text_color(printerStateLabel, lv_color_hex(colors[(int)msg.value]), LV_PART_MAIN);
+        break;
+    }
+
+    case UI_AUDIT:
+        showAuditPage();
+        break;
+
+    case UI_SPC:
+        showSpc();
+        break;
+
+    case UI_STORAGE_STATE:
+        lv_label_set_text(storageStateLabel, msg.text);
+        if (msg.flag) {
+            lv_obj_add_flag(storageStateLabel, LV_OBJ_FLAG_HIDDEN);
+        } else {
+            lv_obj_clear_flag(storageStateLabel, LV_OBJ_FLAG_HIDDEN);
+        }
+        break;
+
+    case UI_BALANCE_TEST:
+        lv_obj_set_style_text_color(ui_TestBalanceValue, lv_color_hex(msg.flag ? COLOR_GREEN : COLOR_RED), LV_PART_MAIN);
+        lv_label_set_text(ui_TestBalanceValue, msg.text);
+        break;
+
+    default:
+        break;
+    }
+}
+
 void setup() {
     // ห้ามลบ
     gui_start();
     gfx.setBrightness(244);
 
-    // เริ่มต้นการทำงานของเครื่องพิมพ์
     Serial.begin(115200);
-    Serial2.begin(9600, SERIAL_8N1, 17, 18);
-    printer.begin();
-
     snprintf(chipid, 23, "ESP32-%llX", ESP.getEfuseMac());
     Serial.println(chipid);
 
+    preferencesMutex = xSemaphoreCreateRecursiveMutex();
     loadConfiguration();
 
+    // เริ่มต้นการทำงานของเครื่องพิมพ์และเครื่องชั่ง (ดู port map ใน setting.h)
+    PRINTER_SERIAL.begin(SET_PRINTER_BAUD, SERIAL_8N1, PRINTER_RX_PIN, PRINTER_TX_PIN);
+    printer.begin(PRINTER_SERIAL);
+    SCALE_SERIAL.begin(SET_SCALE_BAUD, SERIAL_8N1, SCALE_RX_PIN, SCALE_TX_PIN);
+    balanceScale.begin(SCALE_SERIAL, SCALE_PORT_BALANCE);
+    consoleScale.begin(Serial, SCALE_PORT_CONSOLE);
+    consoleScale.setEnabled(false);
+
     pcf8574.pinMode(P0, OUTPUT);
     copyright();
 
+    receiptUpdateQueue = xQueueCreate(1, sizeof(ReceiptUpdate));
+    operatorQueue = xQueueCreate(1, sizeof(OperatorInfo));
+    printTestQueue = xQueueCreate(1, sizeof(PrintTestRequest));
+
     // เพิ่ม events
     addEventListener();
+    createBalanceTab();
+    createPrinterTab();
+    createMemoryTab();
+    createAuditTab();
+    createSpcPanel();
+    createPrinterStateLabel();
+    createStorageStateLabel();
     lv_label_set_long_mode(ui_MachineName, LV_LABEL_LONG_SCROLL_CIRCULAR); /*Circular scroll*/
 
     // เริ่มต้น I2C โดยใช้ SDA = GPIO 19 และ SCL = GPIO 20
@@ -1185,20 +2387,22 @@ void setup() {
     xTaskCreatePinnedToCore(handShakeTask, "Handshaking Task", 8000, NULL, 1, &handShakeTaskHandle, 1);
     xTaskCreatePinnedToCore(syncTimeTask, "Sync Time Task", 8000, NULL, 1, &syncTimeTaskHandle, 1);
 
-    // สร้าง Queue ที่สามารถเก็บได้ 5 ชุดข้อมูล
-    xSendDataQueue = xQueueCreate(5, sizeof(DataToSend));
-    if (xSendDataQueue == NULL) {
-        Serial.println("Error creating the queue");
-        ESP.restart(); // หรือจัดการ error อย่างเหมาะสม
-    }
-
-    dataQueue = xQueueCreate(MAX_QUEUE_SIZE, sizeof(DataToSend *));
-    if (dataQueue == NULL) {
+    dataQueue = xQueueCreate(MAX_QUEUE_SIZE, sizeof(WeighRecord *));
+    if (dataQueue == NULL || !recordPool.begin(MAX_QUEUE_SIZE)) {
         Serial.println("Failed to create queue!");
         while (true)
             ; // Stop the program
     }
 
+    // ผลชั่งที่ยังไม่ถึง server เก็บใน LittleFS (ครั้งแรกที่ partition ยังไม่ format จะ format ให้)
+    // outbox ใช้ได้ไม่เกินขนาด partition ลบส่วนที่เหลือไว้ให้โลโก้และ LittleFS
+    if (!LittleFS.begin(true) || !outbox.begin(LittleFS, LittleFS.totalBytes() - min(LittleFS.totalBytes(), (size_t)OUTBOX_FS_RESERVE))) {
+        Serial.println("(Outbox)=> LittleFS not available, sending records without storing them");
+    }
+    if (!sdCard.begin(SD_CS_PIN, SD_SCK_PIN, SD_MISO_PIN, SD_MOSI_PIN)) {
+        Serial.println("(SD)=> No card, waiting for insert");
+    }
+
     // สร้าง Task สำหรับส่งข้อมูล
     xTaskCreate(processQueueTask, "QueueProcessor", 10000, NULL, 1, &processQueueTaskHandle);
 
@@ -1207,52 +2411,80 @@ void setup() {
         lv_obj_clear_flag(ui_LowBattery, LV_OBJ_FLAG_HIDDEN);
         isAlert = true;
     }
+
+    // งานพิมพ์ทั้งหมดผ่าน spooler (core 0 คนละ core กับ LVGL)
+    loadLogo();
+    spooler.onStateChange(printerStateChanged);
+    spooler.begin(PRINTER_SERIAL, PRINTER_CTS_PIN, PRINTER_RX_PIN >= 0, 0);
+
+    // ตั้งแต่นี้ไปเรียก lv_* ได้จาก LVGL task เท่านั้น (event callback, lv_timer, applyUiMessage)
+    gui_task_start(applyUiMessage);
 }
 
 unsigned long printTime = 0;
 void loop() {
-    lv_timer_handler();
     delay(5);
 
+    // audit log ตามการเสียบ/ถอดการ์ด แล้วทำคำขอจากหน้าประวัติ
+    static bool sdMounted = false;
+    if (sdCard.check() != sdMounted) {
+        sdMounted = sdCard.isMounted();
+        if (sdMounted) {
+            auditLog.begin(sdCard.fs());
+        } else {
+            auditLog.end();
+        }
+    }
+    static AuditRequest auditRequest;
+    if (xQueueReceive(auditRequestQueue, &auditRequest, 0) == pdTRUE) {
+        handleAuditRequest(auditRequest);
+    }
+
+    xQueueReceive(operatorQueue, &operators, 0);
+
+    // Serial ใช้รับคำสั่งจนกว่าจะ login, หลังจากนั้นใช้ป้อนข้อมูลชั่งแทนเครื่องชั่งเมื่อเปิด devMode
+    bool readyToMeasure = runTaskComplete && operators.loggedIn;
+    consoleScale.setEnabled(devMode && readyToMeasure);
+    if (!readyToMeasure) {
+        // ยังไม่พร้อมชั่ง ทิ้งข้อมูลที่ค้าง
+        ScaleFrame *frame;
+        while (ScaleReader::receive(&frame)) {
+            ScaleReader::release(frame);
+        }
+    }
+
     if (!runTaskComplete) {
-        if (syncWifi) {
-            lv_label_set_text_fmt(ui_LoadingLabel, "WiFi connect to ssid: %s", WiFi.SSID());
+        static bool postedSyncWifi = false;
+        static bool postedSyncTime = false;
+        static bool postedDetailsPage = false;
+
+        if (syncWifi && !postedSyncWifi) {
+            gui_post(UI_LOADING_TEXT, false, 0, ("WiFi connect to ssid: " + WiFi.SSID()).c_str());
+            postedSyncWifi = true;
         }
-        if (syncTime) {
-            lv_label_set_text(ui_LoadingLabel, "Sync time success");
+        if (syncTime && !postedSyncTime) {
+            gui_post(UI_LOADING_TEXT, false, 0, "Sync time success");
+            postedSyncTime = true;
         }
-        if (switchToDetailsPage) {
-            _ui_screen_change(&ui_DetailsPage, LV_SCR_LOAD_ANIM_FADE_ON, 500, 0, &ui_DetailsPage_screen_init);
+        if (switchToDetailsPage && !postedDetailsPage) {
+            gui_post(UI_SHOW_DETAILS);
             xTaskNotifyGive(processQueueTaskHandle);
+            postedDetailsPage = true;
         }
-    } else if (isLogin && EmployeeID1 != "") {
-        if (Serial.available() && devMode) {
-            if (SET_MODE == MODE_GRAM) {
-                printWeight(readSerial(Serial));
-            } else if (SET_MODE == MODE_PCS) {
-                printPcs(readSerial(Serial));
-            } else if (SET_MODE == MODE_SETTING) {
-                balanceTest(readSerial(Serial));
-            } else {
-                Serial2.read();
-            }
-        } else if (Serial2.available()) {
-            if (SET_MODE == MODE_GRAM) {
-                printWeight(readSerial(Serial2));
-            } else if (SET_MODE == MODE_PCS) {
-                printPcs(readSerial(Serial2));
-            } else if (SET_MODE == MODE_SETTING) {
-                balanceTest(readSerial(Serial2));
-            } else {
-                Serial2.read();
-            }
+    } else if (operators.loggedIn) {
+        ScaleFrame *frame;
+        if (ScaleReader::receive(&frame)) {
+            serialInputTime = frame->received;
+            Serial.printf("\n(Received data) => port %d: %s\n", frame->port, frame->data);
+            handleScaleFrame(*frame);
+            ScaleReader::release(frame);
         }
 
         // แสดงวันที่, เวลา
         if (millis() - printTime >= 1000) {
             DateTimeInfo dt = getDateTime();
-            lv_label_set_text(ui_Date, dt.date.c_str());
-            lv_label_set_text(ui_Time, dt.time.c_str());
+            gui_post(UI_DATE, false, 0, dt.date.c_str());
+            gui_post(UI_TIME, false, 0, dt.time.c_str());
             printTime = millis();
         }
     } else {
@@ -1272,13 +2504,51 @@ void loop() {
                 factoryReset();
                 ESP.restart();
                 break;
+            case 'S': {
+                // S<KB>: วัดความเร็วอ่าน/เขียน SD แบบ buffer เทียบกับทีละ byte
+                SdBenchmark result;
+                uint32_t kilobytes = constrain(Serial.parseInt(), 1, 4096);
+                if (!sdCard.benchmark(SD_BENCHMARK_PATH, kilobytes, result)) {
+                    Serial.println("(SD)=> Benchmark failed");
+                    break;
+                }
+                Serial.printf("(SD)=> %lu KB write %lu us (byte %lu us), read %lu us (byte %lu us)\n", kilobytes, result.writeUs,
+                              result.byteWriteUs, result.readUs, result.byteReadUs);
+                break;
+            }
+            case 'A': {
+                // A<n>: สุ่มค้นเวลาใน audit log n ครั้ง (ค้น + อ่าน 1 หน้า)
+                AuditBenchmark result;
+                if (!auditLog.benchmark(constrain(Serial.parseInt(), 1, 100000), result)) {
+                    Serial.println("(Audit)=> Benchmark failed (no card or no records)");
+                    break;
+                }
+                Serial.printf("(Audit)=> %u days, %lu records, list %lu us | %lu lookups: avg %lu us, max %lu us\n", result.days,
+                              (unsigned long)result.records, (unsigned long)result.listUs, (unsigned long)result.lookups,
+                              (unsigned long)result.averageUs, (unsigned long)result.maxUs);
+                break;
+            }
             default:
                 break;
             }
         }
+    }
+
+    // template ใหม่จากหน้าตั้งค่า
+    static ReceiptUpdate receiptUpdate;
+    if (xQueueReceive(receiptUpdateQueue, &receiptUpdate, 0) == pdTRUE) {
+        receipts[receiptUpdate.type] = receiptUpdate.compiled;
+    }
 
-        if (Serial2.available()) {
-            Serial2.read();
+    PrintTestRequest printTestRequest;
+    if (xQueueReceive(printTestQueue, &printTestRequest, 0) == pdTRUE) {
+        printTest(printTestRequest);
+    }
+
+    if (beepStart != 0 && millis() - beepStart >= BEEP_MS) {
+        beepStart = 0;
+        if (!isAlert) {
+            pcf8574.digitalWrite(P0, HIGH);
         }
     }
 
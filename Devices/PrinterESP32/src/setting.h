@@ -1,7 +1,49 @@
-#define MAX_QUEUE_SIZE 250
+#define MAX_QUEUE_SIZE 250 // จำนวน record ใน pool ของผลชั่งที่รอส่ง (PSRAM)
+#define UPLOAD_BATCH_SIZE 20    // record สูงสุดต่อ 1 request
+#define UPLOAD_BATCH_WAIT 200   // ms รอ record ถัดไปก่อนส่ง (ชั่งต่อเนื่องจะได้รวมเป็นชุดเดียว)
+#define UPLOAD_RETRY_DELAY 2000 // ms รอก่อนส่งซ้ำเมื่อส่งไม่ออก/server error
+// byte ของ LittleFS ที่ outbox ไม่ใช้: โลโก้ + ไฟล์ ack และ block สำรองที่ LittleFS ต้องใช้ตอนเขียน
+#define OUTBOX_FS_RESERVE (LOGO_MAX_BYTES + 65536)
 #define ALERT_ROUNDS 10
+#define BEEP_MS 200 // เสียงสั้นตอนผ่าน/ค่านิ่ง (loop ปิดเองเมื่อครบ)
 #define SYNC_WIFI_TASK_TIMEOUT 10000
 #define SYNC_TIME_TASK_TIMEOUT 5000
+#define MEMORY_MONITOR_INTERVAL 2000 // ms อัพเดทหน้าจอ
+#define MEMORY_LOG_INTERVAL 60000    // ms พิมพ์ลง Serial
+
+// Port map: เครื่องชั่งและเครื่องพิมพ์ใช้คนละ UART (baud แยกกัน ข้อมูลที่ส่งไปเครื่องพิมพ์ไม่ปนกับข้อมูลเครื่องชั่ง)
+// สายเดิม: เครื่องชั่ง TX -> GPIO17, เครื่องพิมพ์ RX <- GPIO18 (-1 = ไม่ใช้ขานั้น)
+#define SCALE_SERIAL Serial2
+#define SCALE_RX_PIN 17
+#define SCALE_TX_PIN -1
+#define DEFAULT_SCALE_BAUD 9600
+#define PRINTER_SERIAL Serial1
+#define PRINTER_RX_PIN -1 // TX ของเครื่องพิมพ์ ใส่ขาเพื่อถามสถานะกระดาษ/ฝา (DLE EOT) และหยุดคิวเมื่อไม่พร้อม
+#define PRINTER_TX_PIN 18
+#define PRINTER_CTS_PIN -1 // ขา CTS ของเครื่องพิมพ์ (-1 = ไม่ใช้ hardware flow control)
+#define DEFAULT_PRINTER_BAUD 9600
+#define BAUD_OPTIONS "2400\n4800\n9600\n19200\n38400\n57600\n115200"
+
+// โลโก้ขาวดำ (PBM แบบ P4 กว้างไม่เกิน 384 จุด) ใน LittleFS ถ้าไม่มีจะใช้โลโก้ที่เก็บในเครื่องพิมพ์ (FS p)
+#define LOGO_PATH "/logo.pbm"
+#define LOGO_JOB_RESERVE 4096                                              // byte ในใบที่เหลือไว้ให้ค่า field และ QR/barcode
+#define LOGO_MAX_BYTES (PRINT_JOB_SIZE - RECEIPT_MAX_BYTES - LOGO_JOB_RESERVE) // โลโก้ใหญ่กว่านี้ไม่โหลด (ใช้โลโก้ในเครื่องพิมพ์แทน)
+
+// ช่อง micro SD บนบอร์ด (SPI แยกจากเครื่องพิมพ์) ถอด/เสียบได้ระหว่างทำงาน
+#define SD_CS_PIN 10
+#define SD_MOSI_PIN 11
+#define SD_SCK_PIN 12
+#define SD_MISO_PIN 13
+#define SD_BENCHMARK_PATH "/bench.bin" // ไฟล์ชั่วคราวของคำสั่ง S<KB> ทาง Serial
+#define AUDIT_DAY_OPTIONS 62           // วันล่าสุดที่เลือกได้ในหน้าประวัติ (CSV ทั้งหมดอยู่ใน /audit บนการ์ด)
+#define AUDIT_HOUR_OPTIONS                                                                                                                           \
+    "00:00\n01:00\n02:00\n03:00\n04:00\n05:00\n06:00\n07:00\n08:00\n09:00\n10:00\n11:00\n12:00\n13:00\n14:00\n15:00\n16:00\n17:00\n18:00\n19:00\n"   \
+    "20:00\n21:00\n22:00\n23:00"
+
+// SPC หน้าชั่งกรัม (ขนาดหน้าต่าง/subgroup ดูใน lib/SpcEngine/SpcEngine.h)
+#define SPC_QUEUE_SIZE 8     // snapshot ที่รอ LVGL task วาด
+#define SPC_CPK_MINIMUM 1.0  // Cpk ต่ำกว่านี้แสดงสีแดง
+#define SPC_CPK_CAPABLE 1.33 // Cpk ตั้งแต่นี้แสดงสีเขียว (ระหว่างนั้นสีส้ม)
 
 // Preferences
 #define NAME_SPACE "alarm_box"
@@ -11,6 +53,16 @@
 #define MEM_SET_MIN_WEIGHT "set_min_weight"
 #define MEM_SET_MAX_WEIGHT "set_max_weight"
 #define MEM_SET_PCS "set_pcs"
+#define MEM_SET_BALANCE_PROTOCOL "set_balance"
+#define MEM_SET_AUTO_CAPTURE "set_auto_cap"
+#define MEM_SET_STABLE_SAMPLES "set_stb_samples"
+#define MEM_SET_STABLE_STDDEV "set_stb_stddev"
+#define MEM_SET_ZERO_BAND "set_zero_band"
+#define MEM_SCALE_BAUD "scale_baud"
+#define MEM_PRINTER_BAUD "printer_baud"
+#define MEM_RECEIPT_GRAM "rcpt_gram"
+#define MEM_RECEIPT_PCS "rcpt_pcs"
+#define MEM_RECEIPT_TEST "rcpt_test"
 
 #define MEM_COUNT_GRAM_OK "count_gram_ok"
 #define MEM_COUNT_GRAM_NG "count_gram_ng"
@@ -31,6 +83,70 @@ bool IS_FIRST_RUN = true;
 #define DEFAULT_SERVER_URL "https://192.168.0.250/api"
 #define DEFAULT_NTP_SERVER "192.168.0.1"
 
+// ชั่งอัตโนมัติ (เครื่องชั่งที่ส่งค่าต่อเนื่อง)
+#define DEFAULT_STABLE_SAMPLES 5   // จำนวน sample ล่าสุดที่ต้องนิ่ง
+#define DEFAULT_STABLE_STDDEV 0.05 // ส่วนเบี่ยงเบนมาตรฐานสูงสุด (g หรือ pcs)
+#define DEFAULT_ZERO_BAND 0.5      // ค่าที่ถือว่าถาดว่าง (g หรือ pcs)
+
+// ใบเสร็จเริ่มต้น (ใบชั่ง/นับเหมือนใบเสร็จเดิมทุก byte, ใบทดสอบพิมพ์ QR และ barcode ต่อท้าย)
+#define DEFAULT_RECEIPT_GRAM                                                                                                                         \
+    "@reset\n"                                                                                                                                       \
+    "@if logo\n"                                                                                                                                     \
+    "@align center\n"                                                                                                                                \
+    "@logo\n"                                                                                                                                        \
+    "@endif\n"                                                                                                                                       \
+    "@align left\n"                                                                                                                                  \
+    "Date: {date}\n"                                                                                                                                 \
+    "Time: {time}\n"                                                                                                                                 \
+    "Weight Range: {min} - {max} g.\n"                                                                                                               \
+    "Weight:            {weight} g.\n"                                                                                                               \
+    "Operator id 1: {op1}\n"                                                                                                                         \
+    "Operator id 2: {op2}\n"                                                                                                                         \
+    "@feed 1\n"                                                                                                                                      \
+    "@size large\n"                                                                                                                                  \
+    "@bold on\n"                                                                                                                                     \
+    "@align center\n"                                                                                                                                \
+    "@highlight big\n"                                                                                                                               \
+    "{result}\n"                                                                                                                                     \
+    "@cut\n"
+
+#define DEFAULT_RECEIPT_PCS                                                                                                                          \
+    "@reset\n"                                                                                                                                       \
+    "@align left\n"                                                                                                                                  \
+    "Date:{date} Time:{time}\n"                                                                                                                      \
+    "Oper: {op1}, Count: {pcs} PCS\n"                                                                                                                \
+    "@cut\n"
+
+#define DEFAULT_RECEIPT_TEST                                                                                                                         \
+    "@size large\n"                                                                                                                                  \
+    "@bold on\n"                                                                                                                                     \
+    "@align center\n"                                                                                                                                \
+    "@highlight big\n"                                                                                                                               \
+    "PRINT TEST\n"                                                                                                                                   \
+    "@feed 2\n"                                                                                                                                      \
+    "@size normal\n"                                                                                                                                 \
+    "@bold off\n"                                                                                                                                    \
+    "@align left\n"                                                                                                                                  \
+    "@highlight off\n"                                                                                                                               \
+    "Date: {date}\n"                                                                                                                                 \
+    "Time: {time}\n"                                                                                                                                 \
+    "Weight Range: {min} - {max} g.\n"                                                                                                               \
+    "Weight:            {weight} g.\n"                                                                                                               \
+    "Operator id 1: {op1}\n"                                                                                                                         \
+    "Operator id 2: {op2}\n"                                                                                                                         \
+    "@feed 1\n"                                                                                                                                      \
+    "@size large\n"                                                                                                                                  \
+    "@bold on\n"                                                                                                                                     \
+    "@align center\n"                                                                                                                                \
+    "@highlight big\n"                                                                                                                               \
+    "PASS\n"                                                                                                                                         \
+    "@feed 1\n"                                                                                                                                      \
+    "@size normal\n"                                                                                                                                 \
+    "@highlight off\n"                                                                                                                               \
+    "@qr record\n"                                                                                                                                   \
+    "@barcode serial\n"                                                                                                                              \
+    "@cut\n"
+
 #define COPYRIGHT "CREATE BY NATTAPON PONDONKO"
 
 enum ServerStatus { INITIAL = 0, REGISTERED = 200, NOT_REGISTERED = 400, OFFLINE = 404, ERROR = -1 };
@@ -38,6 +154,45 @@ enum ServerStatus { INITIAL = 0, REGISTERED = 200, NOT_REGISTERED = 400, OFFLINE
 // โหมดการใช้งาน
 enum ModeType { MODE_GRAM, MODE_PCS, MODE_SETTING };
 
+// ข้อความอัพเดทหน้าจอ (ส่งผ่าน gui_post ไปยัง LVGL task)
+enum UiMessageType {
+    UI_LOADING_TEXT,
+    UI_SHOW_DETAILS,
+    UI_DATE,
+    UI_TIME,
+    UI_GRAM_RESULT,
+    UI_PCS_RESULT,
+    UI_COUNT,
+    UI_BALANCE_TEST,
+    UI_PRINTER_STATE,
+    UI_AUDIT,
+    UI_SPC,
+    UI_STORAGE_STATE
+};
+
+// ใบเสร็จ (template แก้ไขได้ในแท็บเครื่องพิมพ์ รูปแบบดูใน lib/ReceiptTemplate/ReceiptTemplate.h)
+enum ReceiptType { RECEIPT_GRAM, RECEIPT_PCS, RECEIPT_TEST, RECEIPT_COUNT };
+enum ReceiptField {
+    FIELD_DATE,
+    FIELD_TIME,
+    FIELD_WEIGHT,
+    FIELD_MIN,
+    FIELD_MAX,
+    FIELD_PCS,
+    FIELD_TARGET,
+    FIELD_OP1,
+    FIELD_OP2,
+    FIELD_RESULT,
+    FIELD_MACHINE,
+    FIELD_SERIAL,
+    FIELD_RECORD, // ข้อมูลการชั่งสำหรับ QR (timestamp,serial,operator,ค่า,ผล)
+    RECEIPT_FIELD_COUNT
+};
+enum ReceiptFlag { FLAG_LOGO, RECEIPT_FLAG_COUNT };
+
+// ค่าตั้งชั่งอัตโนมัติที่ปรับจากหน้าจอ
+enum StabilitySetting { STABLE_SAMPLES, STABLE_STDDEV, ZERO_BAND, STABILITY_SETTING_COUNT };
+
 enum SetEmployeeIdType { SET_EMPLOYEE_ID1, SET_EMPLOYEE_ID2 };
 
 // Testing
@@ -49,4 +204,5 @@ enum ColorCode {
     COLOR_ORANGE = 0xF4660A,
     COLOR_GREEN = 0x0FB301,
     COLOR_GRAY = 0x695C62,
+    COLOR_BLUE = 0x1F6FD1,
 };
@@ -81,4 +81,72 @@ router.post('/modePcs', async (req, res) => {
   }
 });
 
+// --- Endpoint: batch ---
+// หลาย record ใน request เดียว { records: [...] } (mode 0 = gram, 1 = pcs) บันทึกใน transaction เดียว
+// record ที่ข้อมูลไม่ครบหรือไม่พบ serial number จะถูกข้าม (index อยู่ใน rejected) ส่วนที่เหลือบันทึกตามปกติ
+const MODE_GRAM = 0;
+const MODE_PCS = 1;
+
+router.post('/batch', async (req, res) => {
+  const records = Array.isArray(req.body) ? req.body : req.body.records;
+  if (!Array.isArray(records) || records.length === 0) {
+    return res.status(400).send('Missing records');
+  }
+  console.log(`(batch)=> ${records.length} records`);
+
+  const conn = await pool.getConnection();
+  try {
+    // machine_sn ของแต่ละ serial number (ปกติทั้งชุดมาจากเครื่องเดียว query ครั้งเดียว)
+    const machines = {};
+    for (const serial of new Set(records.map((r) => r.serial_number).filter(Boolean))) {
+      const [rows] = await conn.execute('SELECT machine_sn FROM machine WHERE alarm_box_sn_1 = ? OR alarm_box_sn_2 = ? LIMIT 1;', [serial, serial]);
+      if (rows.length) {
+        machines[serial] = rows[0].machine_sn;
+      }
+    }
+
+    const gramRows = [];
+    const pcsRows = [];
+    const rejected = [];
+    records.forEach((r, index) => {
+      const machine_sn = machines[r.serial_number];
+      if (!validateData(r) || machine_sn === undefined) {
+        rejected.push(index);
+      } else if (r.mode === MODE_GRAM) {
+        gramRows.push([r.timestamp, machine_sn, r.serial_number, r.operator1, r.operator2, r.min_weight, r.max_weight, r.weight, r.result]);
+      } else if (r.mode === MODE_PCS) {
+        pcsRows.push([r.timestamp, machine_sn, r.serial_number, r.operator1, r.operator2, r.primary_pcs, r.pcs, r.result]);
+      } else {
+        rejected.push(index);
+      }
+    });
+
+    if (!gramRows.length && !pcsRows.length) {
+      return res.status(400).json({ inserted: 0, rejected });
+    }
+
+    await conn.beginTransaction();
+    if (gramRows.length) {
+      await conn.query(
+        'INSERT INTO mode_gram (timestamp, machine_sn, serial_number, operator1, operator2, min_weight, max_weight, weight, result) VALUES ?;',
+        [gramRows]
+      );
+    }
+    if (pcsRows.length) {
+      await conn.query('INSERT INTO mode_pcs (timestamp, machine_sn, serial_number, operator1, operator2, primary_pcs, pcs, result) VALUES ?;', [
+        pcsRows,
+      ]);
+    }
+    await conn.commit();
+
+    res.status(201).json({ inserted: gramRows.length + pcsRows.length, rejected });
+  } catch (err) {
+    await conn.rollback();
+    console.error('Error inserting batch:', err);
+    res.status(500).send('An error occurred while inserting data');
+  } finally {
+    conn.release();
+  }
+});
+
 module.exports = router;
@@ -181,6 +181,10 @@ async function startServer() {
     console.error('Unhandled Rejection at:', promise, 'reason:', reason);
   });
 
+  // เครื่องชั่งเปิด connection ค้างไว้ส่งชุดถัดไป (keep-alive) ไม่ต้อง handshake ใหม่ทุกครั้ง
+  server.keepAliveTimeout = 65 * 1000;
+  server.headersTimeout = 66 * 1000;
+
   server.listen(SERVER_PORT, () => console.log(`Listening on port ${SERVER_PORT}`));
 }
 